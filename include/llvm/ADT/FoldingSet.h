@@ -144,7 +144,10 @@ public:
     void SetNextInBucket(void *N) { NextInFoldingSetBucket = N; }
   };
 
-  /// clear - Remove all nodes from the folding set.
+  /// clear - Remove all nodes from the folding set.  If the set has grown much
+  /// larger than the number of nodes it holds, its buckets are shrunk, so that
+  /// a set that is filled and cleared over and over doesn't pay for its
+  /// largest use every time.
   void clear();
 
   /// RemoveNode - Remove a node from the folding set, returning true if one
@@ -180,6 +183,10 @@ public:
   /// empty - Returns true if there are no nodes in the folding set.
   bool empty() const { return NumNodes == 0; }
 
+  /// capacity - Returns the number of nodes the folding set can hold before
+  /// it has to grow its buckets.
+  unsigned capacity() const { return NumBuckets * 2; }
+
 private:
 
   /// GrowHashTable - Double the size of the hash table and rehash everything.
@@ -0,0 +1,618 @@
+//===- llvm/ADT/GroupedDenseMap.h - Group-probed hash table -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the GroupedDenseMap class, an open addressing hash table
+// with the same interface as DenseMap but a different memory layout.
+//
+// Instead of probing over std::pair<KeyT, ValueT> buckets and comparing every
+// probed key against the empty and tombstone keys, GroupedDenseMap keeps one
+// control byte per bucket in a separate array.  A control byte is either
+// "empty", "deleted", or holds 7 bits of the key's hash.  Lookups scan the
+// control bytes a group of 16 buckets at a time (with SSE2 when it is
+// available), and only touch the key array for buckets whose hash bits match.
+// Keys and values live in separate arrays, so a lookup never pulls values
+// into the cache.
+//
+// Because emptiness is tracked by the control bytes, GroupedDenseMap does not
+// reserve empty and tombstone key values, and KeyInfoT only needs to provide
+// getHashValue and isEqual.  Iterators dereference to a proxy whose 'first'
+// and 'second' members are references into the key and value arrays.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_GROUPEDDENSEMAP_H
+#define LLVM_ADT_GROUPEDDENSEMAP_H
+
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/MathExtras.h"
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LLVM_GROUPEDDENSEMAP_SSE2 1
+#endif
+
+namespace llvm {
+
+namespace detail {
+
+/// GroupedDenseMapCtrl - Control byte encoding and group matching shared by
+/// every GroupedDenseMap instantiation.
+struct GroupedDenseMapCtrl {
+  /// Control byte values.  Full buckets store the low 7 bits of the key's
+  /// hash, so they are always non-negative.
+  enum : int8_t {
+    Empty = -128,
+    Deleted = -2
+  };
+
+  /// The number of control bytes examined by one probe step.
+  enum { GroupWidth = 16 };
+
+  static bool isFull(int8_t C) { return C >= 0; }
+
+  /// BitMask - One bit per bucket in a group, set for matching buckets.
+  typedef uint32_t BitMask;
+
+#ifdef LLVM_GROUPEDDENSEMAP_SSE2
+  static BitMask match(const int8_t *Group, int8_t C) {
+    __m128i Ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Group));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(C), Ctrl));
+  }
+
+  static BitMask matchEmptyOrDeleted(const int8_t *Group) {
+    // Empty and deleted are exactly the control bytes with the sign bit set.
+    __m128i Ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Group));
+    return _mm_movemask_epi8(Ctrl);
+  }
+#else
+  static BitMask match(const int8_t *Group, int8_t C) {
+    BitMask Mask = 0;
+    for (unsigned i = 0; i != GroupWidth; ++i)
+      Mask |= BitMask(Group[i] == C) << i;
+    return Mask;
+  }
+
+  static BitMask matchEmptyOrDeleted(const int8_t *Group) {
+    BitMask Mask = 0;
+    for (unsigned i = 0; i != GroupWidth; ++i)
+      Mask |= BitMask(Group[i] < 0) << i;
+    return Mask;
+  }
+#endif
+
+  static BitMask matchEmpty(const int8_t *Group) {
+    return match(Group, Empty);
+  }
+
+  /// mixHash - DenseMapInfo hashes are cheap and often weak (pointer hashes
+  /// only shift and xor).  Mix the bits so that both the bucket index and
+  /// the 7-bit tag stored in the control byte are well distributed.
+  static uint64_t mixHash(unsigned Hash) {
+    uint64_t H = uint64_t(Hash) * 0x9E3779B97F4A7C15ULL;
+    return H ^ (H >> 29);
+  }
+};
+
+} // end namespace detail
+
+template<typename KeyT, typename ValueT, typename KeyInfoT, bool IsConst>
+class GroupedDenseMapIterator;
+
+template<typename KeyT, typename ValueT,
+         typename KeyInfoT = DenseMapInfo<KeyT> >
+class GroupedDenseMap {
+  typedef detail::GroupedDenseMapCtrl Ctrl;
+  friend class GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, false>;
+  friend class GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, true>;
+
+  /// Ctrls - NumBuckets control bytes, followed by a copy of the first
+  /// GroupWidth control bytes so that a group starting near the end of the
+  /// table can be loaded without wrapping around.
+  int8_t *Ctrls;
+  KeyT *Keys;
+  ValueT *Values;
+  unsigned NumEntries;
+  unsigned NumTombstones;
+  unsigned NumBuckets;
+
+public:
+  typedef unsigned size_type;
+  typedef KeyT key_type;
+  typedef ValueT mapped_type;
+  typedef std::pair<KeyT, ValueT> value_type;
+
+  typedef GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, false> iterator;
+  typedef GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, true> const_iterator;
+
+  explicit GroupedDenseMap(unsigned NumInitBuckets = 0) {
+    init(NumInitBuckets);
+  }
+
+  GroupedDenseMap(const GroupedDenseMap &Other) {
+    init(0);
+    copyFrom(Other);
+  }
+
+  GroupedDenseMap(GroupedDenseMap &&Other) {
+    init(0);
+    swap(Other);
+  }
+
+  ~GroupedDenseMap() {
+    destroyAll();
+    deallocate();
+  }
+
+  GroupedDenseMap &operator=(const GroupedDenseMap &Other) {
+    if (&Other != this) {
+      destroyAll();
+      deallocate();
+      init(0);
+      copyFrom(Other);
+    }
+    return *this;
+  }
+
+  GroupedDenseMap &operator=(GroupedDenseMap &&Other) {
+    destroyAll();
+    deallocate();
+    init(0);
+    swap(Other);
+    return *this;
+  }
+
+  void swap(GroupedDenseMap &RHS) {
+    std::swap(Ctrls, RHS.Ctrls);
+    std::swap(Keys, RHS.Keys);
+    std::swap(Values, RHS.Values);
+    std::swap(NumEntries, RHS.NumEntries);
+    std::swap(NumTombstones, RHS.NumTombstones);
+    std::swap(NumBuckets, RHS.NumBuckets);
+  }
+
+  inline iterator begin() { return iterator(this, 0); }
+  inline iterator end() { return iterator(this, NumBuckets, true); }
+  inline const_iterator begin() const { return const_iterator(this, 0); }
+  inline const_iterator end() const {
+    return const_iterator(this, NumBuckets, true);
+  }
+
+  bool LLVM_ATTRIBUTE_UNUSED_RESULT empty() const { return NumEntries == 0; }
+  unsigned size() const { return NumEntries; }
+
+  /// Grow the map so that it can hold at least Size entries without
+  /// rehashing.  Does not shrink.
+  void resize(size_type Size) {
+    unsigned Needed = bucketsForEntries(Size);
+    if (Needed > NumBuckets)
+      rehash(Needed);
+  }
+
+  void clear() {
+    if (NumEntries == 0 && NumTombstones == 0) return;
+
+    // If the capacity of the table is huge, and the # elements used is small,
+    // shrink the table.
+    if (NumEntries * 4 < NumBuckets && NumBuckets > 64) {
+      destroyAll();
+      unsigned OldNumEntries = NumEntries;
+      deallocate();
+      allocate(OldNumEntries ? bucketsForEntries(OldNumEntries) : 0);
+      return;
+    }
+
+    destroyAll();
+    if (Ctrls)
+      std::memset(Ctrls, Ctrl::Empty, NumBuckets + Ctrl::GroupWidth);
+    NumEntries = 0;
+    NumTombstones = 0;
+  }
+
+  /// Return 1 if the specified key is in the map, 0 otherwise.
+  size_type count(const KeyT &Val) const {
+    return lookupIndex(Val) != NumBuckets ? 1 : 0;
+  }
+
+  iterator find(const KeyT &Val) {
+    return iterator(this, lookupIndex(Val), true);
+  }
+  const_iterator find(const KeyT &Val) const {
+    return const_iterator(this, lookupIndex(Val), true);
+  }
+
+  /// Alternate version of find() which allows a different, and possibly
+  /// less expensive, key type.
+  /// The DenseMapInfo is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, KeyT) for each key
+  /// type used.
+  template<class LookupKeyT>
+  iterator find_as(const LookupKeyT &Val) {
+    return iterator(this, lookupIndex(Val), true);
+  }
+  template<class LookupKeyT>
+  const_iterator find_as(const LookupKeyT &Val) const {
+    return const_iterator(this, lookupIndex(Val), true);
+  }
+
+  /// lookup - Return the entry for the specified key, or a default
+  /// constructed value if no such entry exists.
+  ValueT lookup(const KeyT &Val) const {
+    unsigned Idx = lookupIndex(Val);
+    if (Idx != NumBuckets)
+      return Values[Idx];
+    return ValueT();
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(const std::pair<KeyT, ValueT> &KV) {
+    uint64_t Hash = hashOf(KV.first);
+    unsigned Idx = lookupIndex(KV.first, Hash);
+    if (Idx != NumBuckets)
+      return std::make_pair(iterator(this, Idx, true), false);
+
+    Idx = prepareInsert(Hash);
+    new (&Keys[Idx]) KeyT(KV.first);
+    new (&Values[Idx]) ValueT(KV.second);
+    return std::make_pair(iterator(this, Idx, true), true);
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(std::pair<KeyT, ValueT> &&KV) {
+    uint64_t Hash = hashOf(KV.first);
+    unsigned Idx = lookupIndex(KV.first, Hash);
+    if (Idx != NumBuckets)
+      return std::make_pair(iterator(this, Idx, true), false);
+
+    Idx = prepareInsert(Hash);
+    new (&Keys[Idx]) KeyT(std::move(KV.first));
+    new (&Values[Idx]) ValueT(std::move(KV.second));
+    return std::make_pair(iterator(this, Idx, true), true);
+  }
+
+  /// insert - Range insertion of pairs.
+  template<typename InputIt>
+  void insert(InputIt I, InputIt E) {
+    for (; I != E; ++I)
+      insert(*I);
+  }
+
+  bool erase(const KeyT &Val) {
+    unsigned Idx = lookupIndex(Val);
+    if (Idx == NumBuckets)
+      return false; // not in map.
+    eraseIndex(Idx);
+    return true;
+  }
+  void erase(iterator I) {
+    assert(I.Map == this && I.Idx < NumBuckets &&
+           Ctrl::isFull(Ctrls[I.Idx]) && "Erasing an invalid iterator!");
+    eraseIndex(I.Idx);
+  }
+
+  ValueT &operator[](const KeyT &Key) {
+    uint64_t Hash = hashOf(Key);
+    unsigned Idx = lookupIndex(Key, Hash);
+    if (Idx != NumBuckets)
+      return Values[Idx];
+
+    Idx = prepareInsert(Hash);
+    new (&Keys[Idx]) KeyT(Key);
+    new (&Values[Idx]) ValueT();
+    return Values[Idx];
+  }
+
+  ValueT &operator[](KeyT &&Key) {
+    uint64_t Hash = hashOf(Key);
+    unsigned Idx = lookupIndex(Key, Hash);
+    if (Idx != NumBuckets)
+      return Values[Idx];
+
+    Idx = prepareInsert(Hash);
+    new (&Keys[Idx]) KeyT(std::move(Key));
+    new (&Values[Idx]) ValueT();
+    return Values[Idx];
+  }
+
+  /// Return the approximate size (in bytes) of the actual map.
+  /// This is just the raw memory used by GroupedDenseMap.
+  /// If entries are pointers to objects, the size of the referenced objects
+  /// are not included.
+  size_t getMemorySize() const {
+    if (NumBuckets == 0)
+      return 0;
+    return NumBuckets * (sizeof(KeyT) + sizeof(ValueT) + 1) +
+           Ctrl::GroupWidth;
+  }
+
+private:
+  void init(unsigned InitBuckets) {
+    allocate(InitBuckets ? bucketsForEntries(InitBuckets) : 0);
+  }
+
+  /// bucketsForEntries - The number of buckets needed to hold Entries
+  /// entries without exceeding the maximum load factor of 7/8.
+  static unsigned bucketsForEntries(unsigned Entries) {
+    unsigned Buckets = Entries + Entries / 7 + 1;
+    if (Buckets < Ctrl::GroupWidth)
+      return Ctrl::GroupWidth;
+    return NextPowerOf2(Buckets - 1);
+  }
+
+  void allocate(unsigned Num) {
+    NumEntries = 0;
+    NumTombstones = 0;
+    NumBuckets = Num;
+    if (Num == 0) {
+      Ctrls = nullptr;
+      Keys = nullptr;
+      Values = nullptr;
+      return;
+    }
+    assert(isPowerOf2_32(Num) && Num >= Ctrl::GroupWidth &&
+           "Invalid number of buckets!");
+    Ctrls = static_cast<int8_t *>(operator new(Num + Ctrl::GroupWidth));
+    std::memset(Ctrls, Ctrl::Empty, Num + Ctrl::GroupWidth);
+    Keys = static_cast<KeyT *>(operator new(sizeof(KeyT) * Num));
+    Values = static_cast<ValueT *>(operator new(sizeof(ValueT) * Num));
+  }
+
+  void deallocate() {
+    operator delete(Ctrls);
+    operator delete(Keys);
+    operator delete(Values);
+  }
+
+  void destroyAll() {
+    if (NumEntries == 0)
+      return;
+    for (unsigned i = 0; i != NumBuckets; ++i) {
+      if (Ctrl::isFull(Ctrls[i])) {
+        Values[i].~ValueT();
+        Keys[i].~KeyT();
+      }
+    }
+  }
+
+  void copyFrom(const GroupedDenseMap &Other) {
+    allocate(Other.NumBuckets);
+    if (NumBuckets == 0)
+      return;
+    std::memcpy(Ctrls, Other.Ctrls, NumBuckets + Ctrl::GroupWidth);
+    for (unsigned i = 0; i != NumBuckets; ++i) {
+      if (Ctrl::isFull(Ctrls[i])) {
+        new (&Keys[i]) KeyT(Other.Keys[i]);
+        new (&Values[i]) ValueT(Other.Values[i]);
+      }
+    }
+    NumEntries = Other.NumEntries;
+    NumTombstones = Other.NumTombstones;
+  }
+
+  template<typename LookupKeyT>
+  static uint64_t hashOf(const LookupKeyT &Val) {
+    return Ctrl::mixHash(KeyInfoT::getHashValue(Val));
+  }
+
+  /// getH2 - The 7 bits of the hash that are stored in the control byte.
+  static int8_t getH2(uint64_t Hash) { return int8_t(Hash & 0x7F); }
+
+  /// getH1 - The bits of the hash that select the first probed group.
+  static uint64_t getH1(uint64_t Hash) { return Hash >> 7; }
+
+  void setCtrl(unsigned Idx, int8_t C) {
+    Ctrls[Idx] = C;
+    // Keep the cloned control bytes at the end of the table in sync.
+    if (Idx < Ctrl::GroupWidth)
+      Ctrls[NumBuckets + Idx] = C;
+  }
+
+  /// lookupIndex - Return the bucket holding Val, or NumBuckets if Val is
+  /// not in the map.
+  template<typename LookupKeyT>
+  unsigned lookupIndex(const LookupKeyT &Val) const {
+    if (NumBuckets == 0)
+      return 0;
+    return lookupIndex(Val, hashOf(Val));
+  }
+
+  template<typename LookupKeyT>
+  unsigned lookupIndex(const LookupKeyT &Val, uint64_t Hash) const {
+    if (NumBuckets == 0)
+      return 0;
+
+    const unsigned Mask = NumBuckets - 1;
+    const int8_t H2 = getH2(Hash);
+    unsigned Pos = unsigned(getH1(Hash)) & Mask;
+    unsigned Step = 0;
+    while (1) {
+      const int8_t *Group = Ctrls + Pos;
+      for (Ctrl::BitMask M = Ctrl::match(Group, H2); M; M &= M - 1) {
+        unsigned Idx = (Pos + countTrailingZeros(M)) & Mask;
+        if (LLVM_LIKELY(KeyInfoT::isEqual(Val, Keys[Idx])))
+          return Idx;
+      }
+
+      // An empty bucket in the group means the probe sequence for Val never
+      // went past it, so Val is not in the table.
+      if (LLVM_LIKELY(Ctrl::matchEmpty(Group)))
+        return NumBuckets;
+
+      // Triangular probing over groups visits every group exactly once when
+      // the number of buckets is a power of two.
+      Step += Ctrl::GroupWidth;
+      Pos = (Pos + Step) & Mask;
+      assert(Step <= NumBuckets && "Probed the whole table!");
+    }
+  }
+
+  /// findInsertSlot - Return the first empty or deleted bucket in the probe
+  /// sequence for Hash.
+  unsigned findInsertSlot(uint64_t Hash) const {
+    const unsigned Mask = NumBuckets - 1;
+    unsigned Pos = unsigned(getH1(Hash)) & Mask;
+    unsigned Step = 0;
+    while (1) {
+      if (Ctrl::BitMask M = Ctrl::matchEmptyOrDeleted(Ctrls + Pos))
+        return (Pos + countTrailingZeros(M)) & Mask;
+      Step += Ctrl::GroupWidth;
+      Pos = (Pos + Step) & Mask;
+      assert(Step <= NumBuckets && "No free bucket in the table!");
+    }
+  }
+
+  /// prepareInsert - Claim a bucket for a key with the specified hash which
+  /// is known not to be in the map, growing the table if necessary.  The
+  /// caller constructs the key and value in the returned bucket.
+  unsigned prepareInsert(uint64_t Hash) {
+    // Grow the table if the load, counting tombstones, would exceed 7/8.
+    // When most of that load is tombstones, rehashing at the same size is
+    // enough to reclaim them.
+    if ((NumEntries + NumTombstones + 1) * 8 > NumBuckets * 7) {
+      if (NumBuckets != 0 && (NumEntries + 1) * 16 <= NumBuckets * 7)
+        rehash(NumBuckets);
+      else
+        rehash(NumBuckets * 2);
+    }
+
+    unsigned Idx = findInsertSlot(Hash);
+    if (Ctrls[Idx] == Ctrl::Deleted)
+      --NumTombstones;
+    setCtrl(Idx, getH2(Hash));
+    ++NumEntries;
+    return Idx;
+  }
+
+  void eraseIndex(unsigned Idx) {
+    Values[Idx].~ValueT();
+    Keys[Idx].~KeyT();
+    setCtrl(Idx, Ctrl::Deleted);
+    --NumEntries;
+    ++NumTombstones;
+  }
+
+  void rehash(unsigned AtLeast) {
+    int8_t *OldCtrls = Ctrls;
+    KeyT *OldKeys = Keys;
+    ValueT *OldValues = Values;
+    unsigned OldNumBuckets = NumBuckets;
+    unsigned OldNumEntries = NumEntries;
+
+    allocate(AtLeast < Ctrl::GroupWidth ? unsigned(Ctrl::GroupWidth)
+                                        : NextPowerOf2(AtLeast - 1));
+
+    for (unsigned i = 0; i != OldNumBuckets; ++i) {
+      if (!Ctrl::isFull(OldCtrls[i]))
+        continue;
+      uint64_t Hash = hashOf(OldKeys[i]);
+      unsigned Idx = findInsertSlot(Hash);
+      setCtrl(Idx, getH2(Hash));
+      new (&Keys[Idx]) KeyT(std::move(OldKeys[i]));
+      new (&Values[Idx]) ValueT(std::move(OldValues[i]));
+      OldValues[i].~ValueT();
+      OldKeys[i].~KeyT();
+    }
+    NumEntries = OldNumEntries;
+
+    operator delete(OldCtrls);
+    operator delete(OldKeys);
+    operator delete(OldValues);
+  }
+};
+
+template<typename KeyT, typename ValueT, typename KeyInfoT, bool IsConst>
+class GroupedDenseMapIterator {
+  typedef detail::GroupedDenseMapCtrl Ctrl;
+  typedef GroupedDenseMap<KeyT, ValueT, KeyInfoT> MapT;
+  typedef GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, true> ConstIterator;
+  typedef typename std::conditional<IsConst, const MapT, MapT>::type
+    MapTy;
+  typedef typename std::conditional<IsConst, const ValueT, ValueT>::type
+    ValueTy;
+  friend class GroupedDenseMap<KeyT, ValueT, KeyInfoT>;
+  friend class GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, false>;
+  friend class GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, true>;
+
+  MapTy *Map;
+  unsigned Idx;
+
+public:
+  /// value_reference - What the iterator dereferences to: references to the
+  /// key and value of one entry, in the shape of a std::pair.
+  struct value_reference {
+    const KeyT &first;
+    ValueTy &second;
+    const value_reference *operator->() const { return this; }
+  };
+
+  typedef ptrdiff_t difference_type;
+  typedef std::pair<KeyT, ValueT> value_type;
+  typedef value_reference reference;
+  typedef value_reference pointer;
+  typedef std::forward_iterator_tag iterator_category;
+
+  GroupedDenseMapIterator() : Map(nullptr), Idx(0) {}
+
+  GroupedDenseMapIterator(MapTy *Map, unsigned Idx, bool NoAdvance = false)
+    : Map(Map), Idx(Idx) {
+    if (!NoAdvance) AdvancePastEmptyBuckets();
+  }
+
+  // If IsConst is true this is a converting constructor from iterator to
+  // const_iterator and the default copy constructor is used.
+  // Otherwise this is a copy constructor for iterator.
+  GroupedDenseMapIterator(
+      const GroupedDenseMapIterator<KeyT, ValueT, KeyInfoT, false> &I)
+    : Map(I.Map), Idx(I.Idx) {}
+
+  reference operator*() const {
+    reference R = { Map->Keys[Idx], Map->Values[Idx] };
+    return R;
+  }
+  pointer operator->() const { return **this; }
+
+  bool operator==(const ConstIterator &RHS) const {
+    return Idx == RHS.Idx;
+  }
+  bool operator!=(const ConstIterator &RHS) const {
+    return Idx != RHS.Idx;
+  }
+
+  inline GroupedDenseMapIterator& operator++() {  // Preincrement
+    ++Idx;
+    AdvancePastEmptyBuckets();
+    return *this;
+  }
+  GroupedDenseMapIterator operator++(int) {  // Postincrement
+    GroupedDenseMapIterator tmp = *this; ++*this; return tmp;
+  }
+
+private:
+  void AdvancePastEmptyBuckets() {
+    while (Idx < Map->NumBuckets && !Ctrl::isFull(Map->Ctrls[Idx]))
+      ++Idx;
+  }
+};
+
+} // end namespace llvm
+
+#endif
@@ -20,6 +20,7 @@
 #ifndef LLVM_ADT_SETVECTOR_H
 #define LLVM_ADT_SETVECTOR_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallSet.h"
 #include <algorithm>
 #include <cassert>
@@ -91,6 +92,11 @@ public:
     return vector_.back();
   }
 
+  /// \brief Return the elements of the SetVector in insertion order.
+  ArrayRef<T> getArrayRef() const {
+    return vector_;
+  }
+
   /// \brief Index into the SetVector.
   const_reference operator[](size_type n) const {
     assert(n < vector_.size() && "SetVector access out of range!");
@@ -14,9 +14,14 @@
 #ifndef LLVM_ANALYSIS_INLINECOST_H
 #define LLVM_ANALYSIS_INLINECOST_H
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Analysis/CallGraphSCCPass.h"
+#include "llvm/IR/ValueHandle.h"
 #include <cassert>
 #include <climits>
+#include <vector>
 
 namespace llvm {
 class CallSite;
@@ -61,6 +66,7 @@ class InlineCost {
 
   // Trivial constructor, interesting logic in the factory functions below.
   InlineCost(int Cost, int Threshold) : Cost(Cost), Threshold(Threshold) {}
+  friend class InlineCostAnalysis;
 
 public:
   static InlineCost get(int Cost, int Threshold) {
@@ -101,6 +107,39 @@ public:
 class InlineCostAnalysis : public CallGraphSCCPass {
   const TargetTransformInfo *TTI;
 
+  /// CalleeCallbackVH - Drops the cached costs of a callee when it is
+  /// deleted.
+  class CalleeCallbackVH : public CallbackVH {
+    InlineCostAnalysis *ICA;
+    void deleted() override;
+  public:
+    CalleeCallbackVH(Value *V, InlineCostAnalysis *ICA = nullptr)
+      : CallbackVH(V), ICA(ICA) {}
+  };
+  friend class CalleeCallbackVH;
+
+  /// CachedCost - The cost of inlining a callee at the call sites with the
+  /// given signature.
+  struct CachedCost {
+    SmallVector<uint64_t, 8> Signature;
+    int Cost, Threshold;
+
+    CachedCost(const SmallVectorImpl<uint64_t> &Signature, InlineCost IC)
+      : Signature(Signature.begin(), Signature.end()), Cost(IC.Cost),
+        Threshold(IC.Threshold) {}
+
+    InlineCost get() const { return InlineCost(Cost, Threshold); }
+  };
+
+  /// CostCache - The costs computed for each callee, most recent last.  Only
+  /// callees outside the SCC being visited are cached; their bodies no longer
+  /// change while the inliner runs.
+  DenseMap<CalleeCallbackVH, std::vector<CachedCost>, DenseMapInfo<Value *> >
+    CostCache;
+
+  /// CurrentSCC - The functions of the SCC being visited.
+  SmallPtrSet<const Function *, 8> CurrentSCC;
+
 public:
   static char ID;
 
@@ -110,6 +149,8 @@ public:
   // Pass interface implementation.
   void getAnalysisUsage(AnalysisUsage &AU) const override;
   bool runOnSCC(CallGraphSCC &SCC) override;
+  using llvm::Pass::doFinalization;
+  bool doFinalization(CallGraph &CG) override;
 
   /// \brief Get an InlineCost object representing the cost of inlining this
   /// callsite.
@@ -120,7 +161,9 @@ public:
   /// sufficiently low to warrant inlining.
   ///
   /// Also note that calling this function *dynamically* computes the cost of
-  /// inlining the callsite. It is an expensive, heavyweight call.
+  /// inlining the callsite. It is an expensive, heavyweight call, though the
+  /// result is reused for call sites of the same callee that the analysis
+  /// can't tell apart.
   InlineCost getInlineCost(CallSite CS, int Threshold);
 
   /// \brief Get an InlineCost with the callee explicitly specified.
@@ -134,6 +177,10 @@ public:
 
   /// \brief Minimal filter to detect invalid constructs for inlining.
   bool isInlineViable(Function &Callee);
+
+  /// \brief Drop the cached costs of inlining \p Callee.  Passes that change
+  /// the body of a function outside the SCC being visited must call this.
+  void forgetInlineCosts(Function *Callee);
 };
 
 }
@@ -85,6 +85,20 @@ struct PostDominatorTree : public FunctionPass {
     DT->getDescendants(R, Result);
   }
 
+  /// insertEdge, deleteEdge, applyUpdates - Update the tree after changes to
+  /// the edges of the CFG.  See DominatorTreeBase.
+  void insertEdge(BasicBlock *From, BasicBlock *To) {
+    DT->insertEdge(From, To);
+  }
+
+  void deleteEdge(BasicBlock *From, BasicBlock *To) {
+    DT->deleteEdge(From, To);
+  }
+
+  void applyUpdates(ArrayRef<DominatorTreeBase<BasicBlock>::UpdateType> U) {
+    DT->applyUpdates(U);
+  }
+
   void releaseMemory() override {
     DT->releaseMemory();
   }
@@ -375,6 +375,11 @@ namespace llvm {
     DenseMap<const SCEV *,
              SmallVector<std::pair<const Loop *, const SCEV *>, 2> > ValuesAtScopes;
 
+    /// ScopeValues - The expressions that were given an entry in
+    /// ValuesAtScopes for each scope, so that forgetValuesAtScope only visits
+    /// those.  An expression whose entries were dropped since may remain.
+    DenseMap<const Loop *, SmallVector<const SCEV *, 4> > ScopeValues;
+
     /// LoopDispositions - Memoized computeLoopDisposition results.
     DenseMap<const SCEV *,
              SmallVector<std::pair<const Loop *, LoopDisposition>, 2> > LoopDispositions;
@@ -803,6 +808,13 @@ namespace llvm {
     /// disconnect it from a def-use chain linking it to a loop.
     void forgetValue(Value *V);
 
+    /// forgetValuesAtScope - Drop the memoized getSCEVAtScope results that
+    /// were computed for the scope of the specified loop. Unlike forgetLoop,
+    /// this does not invalidate anything; it only releases cache memory. It
+    /// should be called by clients that are done querying values at this
+    /// scope, and it must be called before the loop is deleted.
+    void forgetValuesAtScope(const Loop *L);
+
     /// \brief Called when the client has changed the disposition of values in
     /// this loop.
     ///
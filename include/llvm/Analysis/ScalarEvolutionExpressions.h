@@ -137,12 +137,18 @@ namespace llvm {
     // arrays with its SCEVAllocator, so this class just needs a simple
     // pointer rather than a more elaborate vector-like data structure.
     // This also avoids the need for a non-trivial destructor.
+    //
+    // NumOperands is declared first and kept to 32 bits so that it can be
+    // laid out in the tail padding of the SCEV base class, which keeps every
+    // n-ary node one pointer smaller.
+    unsigned NumOperands;
     const SCEV *const *Operands;
-    size_t NumOperands;
 
     SCEVNAryExpr(const FoldingSetNodeIDRef ID,
                  enum SCEVTypes T, const SCEV *const *O, size_t N)
-      : SCEV(ID, T), Operands(O), NumOperands(N) {}
+      : SCEV(ID, T), NumOperands(N), Operands(O) {
+      assert(NumOperands == N && "Too many operands for a SCEV expression!");
+    }
 
   public:
     size_t getNumOperands() const { return NumOperands; }
@@ -382,6 +382,19 @@ public:
                                    unsigned Alignment,
                                    unsigned AddressSpace) const;
 
+  /// \return The cost of an interleaved load or store group.
+  ///
+  /// \p VecTy is the type of the wide access, which holds \p Factor vectors
+  /// interleaved element by element; the cost includes the shuffles that
+  /// separate them after a load or merge them before a store. \p Indices
+  /// lists the vectors of the group that are actually used, so a load group
+  /// can have gaps.
+  virtual unsigned getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                              unsigned Factor,
+                                              ArrayRef<unsigned> Indices,
+                                              unsigned Alignment,
+                                              unsigned AddressSpace) const;
+
   /// \brief Calculate the cost of performing a vector reduction.
   ///
   /// This is the cost of reducing the vector value of type \p Ty to a scalar
@@ -398,6 +411,15 @@ public:
   virtual unsigned getReductionCost(unsigned Opcode, Type *Ty,
                                     bool IsPairwiseForm) const;
 
+  /// \brief Calculate the cost of reducing the vector value of type \p Ty to
+  /// its minimum or maximum element.
+  ///
+  /// Every level of the reduction is a compare, producing a value of type
+  /// \p CondTy, and a select, in the pairwise or split form described for
+  /// getReductionCost.
+  virtual unsigned getMinMaxReductionCost(Type *Ty, Type *CondTy,
+                                          bool IsPairwiseForm) const;
+
   /// \returns The cost of Intrinsic instructions.
   virtual unsigned getIntrinsicInstrCost(Intrinsic::ID ID, Type *RetTy,
                                          ArrayRef<Type *> Tys) const;
@@ -182,8 +182,13 @@ namespace llvm {
       void dump() const;
     };
 
-    typedef SmallVector<Segment,4> Segments;
-    typedef SmallVector<VNInfo*,4> VNInfoList;
+    // Most live ranges are local to a block and have one or two segments and
+    // values, and a large function has one live range per virtual register,
+    // so the inline storage is kept small.  Longer ranges live on the heap.
+    // On a 64-bit host, room for two of each makes a LiveInterval 120 bytes,
+    // against 184 with room for four.
+    typedef SmallVector<Segment,2> Segments;
+    typedef SmallVector<VNInfo*,2> VNInfoList;
 
     Segments segments;   // the liveness segments
     VNInfoList valnos;   // value#'s
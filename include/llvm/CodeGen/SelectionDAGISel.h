@@ -117,8 +117,10 @@ public:
     OPC_CheckPredicate,
     OPC_CheckOpcode,
     OPC_SwitchOpcode,
+    OPC_SwitchOpcodeIndexed,
     OPC_CheckType,
     OPC_SwitchType,
+    OPC_SwitchTypeIndexed,
     OPC_CheckChild0Type, OPC_CheckChild1Type, OPC_CheckChild2Type,
     OPC_CheckChild3Type, OPC_CheckChild4Type, OPC_CheckChild5Type,
     OPC_CheckChild6Type, OPC_CheckChild7Type,
@@ -283,6 +285,12 @@ private:
   /// state machines that start with a OPC_SwitchOpcode node.
   std::vector<unsigned> OpcodeOffset;
 
+  /// SwitchCaseOffsets - For each OPC_SwitchOpcodeIndexed and
+  /// OPC_SwitchTypeIndexed node, indexed by the switch number the table gives
+  /// it, the table index of the case for each opcode or type, or 0 if there is
+  /// no such case.  Each entry is built the first time the switch is reached.
+  std::vector<std::vector<unsigned> > SwitchCaseOffsets;
+
   void UpdateChainsAndGlue(SDNode *NodeToMatch, SDValue InputChain,
                            const SmallVectorImpl<SDNode*> &ChainNodesMatched,
                            SDValue InputGlue, const SmallVectorImpl<SDNode*> &F,
@@ -46,6 +46,9 @@ bool verifyFunction(const Function &F, raw_ostream *OS = nullptr);
 /// If there are no errors, the function returns false. If an error is found,
 /// a message describing the error is written to OS (if non-null) and true is
 /// returned.
+///
+/// With -verify-threads, the function bodies are checked concurrently; the
+/// messages are still written in the order of the functions in the module.
 bool verifyModule(const Module &M, raw_ostream *OS = nullptr);
 
 /// \brief Create a verifier pass.
@@ -11,6 +11,7 @@
 #define LLVM_MC_MCASMLAYOUT_H
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 
 namespace llvm {
@@ -43,6 +44,37 @@ private:
   /// lower ordinal will be valid.
   mutable DenseMap<const MCSectionData*, MCFragment*> LastValidFragment;
 
+  /// A fragment resized during the current relaxation sweep after it had
+  /// been laid out.  The fragments after it keep their stale offsets until
+  /// the sweep ends, and are reported with the change in size added instead,
+  /// up to but not including the next alignment or .org fragment (Limit),
+  /// which may absorb the change.  Relaxed instructions only grow, but LEB
+  /// and DWARF fragments shrink when the distance they encode does, so the
+  /// deltas are signed.
+  struct SweepDelta {
+    unsigned Order;
+    unsigned Limit;
+    /// Total - The sum of the deltas of this and all earlier entries.
+    int64_t Total;
+  };
+
+  /// The section being relaxed and the fragments resized in this sweep, in
+  /// layout order.
+  const MCSectionData *SweepSection;
+  SmallVector<SweepDelta, 8> SweepDeltas;
+
+  /// The layout order of the first alignment or .org fragment after the
+  /// last entry of SweepDeltas.
+  unsigned SweepBarrier;
+
+  /// The fragments that have been entered in SweepDeltas in any sweep, so
+  /// that each one is counted once in the statistics.
+  SmallPtrSet<const MCFragment *, 8> SweepResizedFragments;
+
+  /// \brief Get the total change in size of the resized fragments that the
+  /// offset of \p F should be adjusted for.
+  int64_t getSweepAdjustment(const MCFragment *F) const;
+
   /// \brief Make sure that the layout for the given fragment is valid, lazily
   /// computing it if necessary.
   void ensureValid(const MCFragment *F) const;
@@ -66,6 +98,19 @@ public:
   /// its bundle padding will be recomputed.
   void invalidateFragmentsFrom(MCFragment *F);
 
+  /// \brief Start a relaxation sweep over the fragments of \p SD.
+  void beginSweep(const MCSectionData *SD);
+
+  /// \brief Record that \p F, a fragment of the section being swept, has
+  /// changed size by \p Delta bytes, which is negative if it shrank.  If F
+  /// was already laid out, later offset queries in the section are adjusted
+  /// for it; otherwise its new size is picked up when it is laid out.
+  void noteFragmentResized(const MCFragment *F, int64_t Delta);
+
+  /// \brief End the current sweep and drop its offset adjustments.  The
+  /// caller must invalidate the fragments from the first resized one.
+  void endSweep();
+
   /// \brief Perform layout for a single fragment, assuming that the previous
   /// fragment has already been laid out correctly, and the parent section has
   /// been initialized.
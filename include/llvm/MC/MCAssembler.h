@@ -994,6 +994,13 @@ public:
   void writeSectionData(const MCSectionData *Section,
                         const MCAsmLayout &Layout) const;
 
+  /// Render the section contents into \p Buffer instead of the object file.
+  /// Once layout is final this only reads the assembler state, so it may be
+  /// called for different sections on several threads at once.
+  void writeSectionData(const MCSectionData *Section,
+                        const MCAsmLayout &Layout,
+                        SmallVectorImpl<char> &Buffer) const;
+
   /// Check whether a given symbol has been flagged with .thumb_func.
   bool isThumbFunc(const MCSymbol *Func) const;
 
@@ -18,14 +18,17 @@
 #ifndef LLVM_SUPPORT_GENERIC_DOM_TREE_H
 #define LLVM_SUPPORT_GENERIC_DOM_TREE_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/GraphTraits.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <queue>
 
 namespace llvm {
 
@@ -64,6 +67,7 @@ class DomTreeNodeBase {
   NodeT *TheBB;
   DomTreeNodeBase<NodeT> *IDom;
   std::vector<DomTreeNodeBase<NodeT> *> Children;
+  unsigned Level;
   mutable int DFSNumIn, DFSNumOut;
 
   template<class N> friend class DominatorTreeBase;
@@ -84,8 +88,13 @@ public:
     return Children;
   }
 
+  /// getLevel - Return the depth of this node in the tree.  The root is at
+  /// level 0.
+  unsigned getLevel() const { return Level; }
+
   DomTreeNodeBase(NodeT *BB, DomTreeNodeBase<NodeT> *iDom)
-    : TheBB(BB), IDom(iDom), DFSNumIn(-1), DFSNumOut(-1) { }
+    : TheBB(BB), IDom(iDom), Level(iDom ? iDom->Level + 1 : 0),
+      DFSNumIn(-1), DFSNumOut(-1) { }
 
   DomTreeNodeBase<NodeT> *addChild(DomTreeNodeBase<NodeT> *C) {
     Children.push_back(C);
@@ -131,6 +140,7 @@ public:
       // Switch to new dominator
       IDom = NewIDom;
       IDom->Children.push_back(this);
+      updateLevel();
     }
   }
 
@@ -145,6 +155,21 @@ private:
     return this->DFSNumIn >= other->DFSNumIn &&
       this->DFSNumOut <= other->DFSNumOut;
   }
+
+  // Recompute the level of this node and of the nodes below it after its
+  // immediate dominator has changed.
+  void updateLevel() {
+    if (Level == IDom->Level + 1)
+      return;
+    SmallVector<DomTreeNodeBase<NodeT> *, 16> WorkStack(1, this);
+    while (!WorkStack.empty()) {
+      DomTreeNodeBase<NodeT> *Current = WorkStack.pop_back_val();
+      Current->Level = Current->IDom->Level + 1;
+      for (iterator I = Current->begin(), E = Current->end(); I != E; ++I)
+        if ((*I)->Level != Current->Level + 1)
+          WorkStack.push_back(*I);
+    }
+  }
 };
 
 template<class NodeT>
@@ -198,6 +223,7 @@ protected:
 
   mutable bool DFSInfoValid;
   mutable unsigned int SlowQueries;
+  bool VerifyUpdates;
   // Information record used during immediate dominators computation.
   struct InfoRec {
     unsigned DFSNum;
@@ -292,7 +318,8 @@ protected:
 
 public:
   explicit DominatorTreeBase(bool isPostDom)
-    : DominatorBase<NodeT>(isPostDom), DFSInfoValid(false), SlowQueries(0) {}
+    : DominatorBase<NodeT>(isPostDom), DFSInfoValid(false), SlowQueries(0),
+      VerifyUpdates(false) {}
   virtual ~DominatorTreeBase() { reset(); }
 
   /// compare - Return false if the other dominator tree base matches this
@@ -570,6 +597,118 @@ public:
       this->Split<NodeT*, GraphTraits<NodeT*> >(*this, NewBB);
   }
 
+  /// UpdateKind, UpdateType - A change to one edge of the CFG, for
+  /// applyUpdates.
+  enum UpdateKind { Insert, Delete };
+  struct UpdateType {
+    UpdateKind Kind;
+    NodeT *From, *To;
+    UpdateType(UpdateKind Kind, NodeT *From, NodeT *To)
+      : Kind(Kind), From(From), To(To) {}
+  };
+
+  /// insertEdge - Update the tree after the CFG edge From->To has been added.
+  /// To may be a new block, or one that was unreachable until now; From must
+  /// already be known to the tree unless it is unreachable.  Only the part of
+  /// the tree the new edge can change is visited.
+  void insertEdge(NodeT *From, NodeT *To) {
+    assert(From && To && "Cannot insert an edge from or to a null block!");
+    applyInsertion(From, To, nullptr);
+    verifyAfterUpdate();
+  }
+
+  /// deleteEdge - Update the tree after the CFG edge From->To has been
+  /// removed.  Nothing changes if another From->To edge is still present.
+  /// Blocks that become unreachable are dropped from the tree, but not
+  /// erased from the CFG.
+  void deleteEdge(NodeT *From, NodeT *To) {
+    assert(From && To && "Cannot delete an edge from or to a null block!");
+    applyDeletion(From, To, nullptr);
+    verifyAfterUpdate();
+  }
+
+  /// applyUpdates - Update the tree after all of the given edge changes have
+  /// been made to the CFG, in any order.  An edge both inserted and deleted
+  /// is ignored.  Large batches, relative to the size of the tree, are
+  /// handled by recomputing the tree from scratch.
+  void applyUpdates(ArrayRef<UpdateType> Updates) {
+    SmallVector<UpdateType, 8> Legal;
+    legalizeUpdates(Updates, Legal);
+    if (Legal.empty())
+      return;
+
+    if (Legal.size() > MaxIncrementalUpdates &&
+        Legal.size() * 40 > DomTreeNodes.size()) {
+      recalculateFrom(Legal.front().From);
+      verifyAfterUpdate();
+      return;
+    }
+
+    // Each update is applied against the CFG as it was just before it: the
+    // edges of the updates not applied yet are hidden from, or added back to,
+    // the successor and predecessor lists the updates look at.
+    PendingUpdates Pending;
+    for (unsigned i = 0, e = Legal.size(); i != e; ++i)
+      Pending.add(getDomEdge(Legal[i]), Legal[i].Kind);
+    for (unsigned i = 0, e = Legal.size(); i != e; ++i) {
+      Pending.remove(getDomEdge(Legal[i]), Legal[i].Kind);
+      bool Recalculated =
+          Legal[i].Kind == Insert
+              ? applyInsertion(Legal[i].From, Legal[i].To, &Pending)
+              : applyDeletion(Legal[i].From, Legal[i].To, &Pending);
+      // A recalculated tree already reflects the rest of the batch.
+      if (Recalculated)
+        break;
+    }
+    verifyAfterUpdate();
+  }
+
+  /// setVerifyUpdates - If enabled, compare the tree with one computed from
+  /// scratch after every insertEdge, deleteEdge and applyUpdates, and abort
+  /// if they differ.  This is slow.
+  void setVerifyUpdates(bool Verify) { VerifyUpdates = Verify; }
+
+  /// verify - Return true if the tree matches one computed from scratch for
+  /// the current CFG, and the level of every node is one more than that of
+  /// its immediate dominator.
+  bool verify() const {
+    NodeT *AnyBlock = nullptr;
+    unsigned NumNodes = 0;
+    for (typename DomTreeNodeMapType::const_iterator I = DomTreeNodes.begin(),
+           E = DomTreeNodes.end(); I != E; ++I) {
+      const DomTreeNodeBase<NodeT> *N = I->second;
+      if (!N)
+        continue;
+      ++NumNodes;
+      if (N->getBlock())
+        AnyBlock = N->getBlock();
+      if (N->getIDom() ? N->getLevel() != N->getIDom()->getLevel() + 1
+                       : N != RootNode || N->getLevel() != 0)
+        return false;
+    }
+    if (!AnyBlock)
+      return true;
+
+    DominatorTreeBase Fresh(this->IsPostDominators);
+    Fresh.recalculate(*AnyBlock->getParent());
+    unsigned NumFreshNodes = 0;
+    for (typename DomTreeNodeMapType::const_iterator
+           I = Fresh.DomTreeNodes.begin(), E = Fresh.DomTreeNodes.end();
+         I != E; ++I) {
+      const DomTreeNodeBase<NodeT> *FreshN = I->second;
+      if (!FreshN)
+        continue;
+      ++NumFreshNodes;
+      const DomTreeNodeBase<NodeT> *N = getNode(I->first);
+      if (!N || !FreshN->getIDom() != !N->getIDom())
+        return false;
+      if (FreshN->getIDom() &&
+          FreshN->getIDom()->getBlock() != N->getIDom()->getBlock())
+        return false;
+    }
+    return NumNodes == NumFreshNodes;
+  }
+
   /// print - Convert to human readable form
   ///
   void print(raw_ostream &o) const {
@@ -672,6 +811,455 @@ protected:
     this->Roots.push_back(BB);
   }
 
+  //===--------------------------------------------------------------------===//
+  // Incremental updates.  insertEdge and deleteEdge follow the dynamic SNCA
+  // scheme of Georgiadis et al.: an insertion moves the nodes the new edge
+  // bypasses their dominators for under the nearest common dominator of its
+  // ends, found with a depth-based search, and a deletion recomputes only the
+  // subtree under the nearest common dominator of its ends.
+
+  /// Batches with more updates than this are recalculated from scratch once
+  /// they touch more than one node in forty.
+  enum { MaxIncrementalUpdates = 4 };
+
+  /// PendingUpdates - The edges of a batch that have not been applied to the
+  /// tree yet, in the direction of the dominance graph.  Hidden holds edges
+  /// already inserted into the CFG, Extra those already deleted from it.
+  /// Index 0 of each is keyed by the source of the edge, index 1 by the
+  /// destination.
+  struct PendingUpdates {
+    typedef DenseMap<NodeT *, SmallVector<NodeT *, 2> > EdgeMapType;
+    EdgeMapType Hidden[2], Extra[2];
+
+    void add(std::pair<NodeT *, NodeT *> Edge, UpdateKind Kind) {
+      EdgeMapType *Maps = Kind == Insert ? Hidden : Extra;
+      Maps[0][Edge.first].push_back(Edge.second);
+      Maps[1][Edge.second].push_back(Edge.first);
+    }
+
+    void remove(std::pair<NodeT *, NodeT *> Edge, UpdateKind Kind) {
+      EdgeMapType *Maps = Kind == Insert ? Hidden : Extra;
+      eraseOne(Maps[0][Edge.first], Edge.second);
+      eraseOne(Maps[1][Edge.second], Edge.first);
+    }
+
+    /// adjust - Turn the neighbours of N in the current CFG into those it had
+    /// before the pending updates.  Every copy of a hidden edge is removed: a
+    /// switch or branch may reach the same block through several successors.
+    void adjust(NodeT *N, bool Reverse, SmallVectorImpl<NodeT *> &Nodes) const {
+      typename EdgeMapType::const_iterator I = Hidden[Reverse].find(N);
+      if (I != Hidden[Reverse].end())
+        for (unsigned i = 0, e = I->second.size(); i != e; ++i)
+          Nodes.erase(std::remove(Nodes.begin(), Nodes.end(), I->second[i]),
+                      Nodes.end());
+      I = Extra[Reverse].find(N);
+      if (I != Extra[Reverse].end())
+        Nodes.append(I->second.begin(), I->second.end());
+    }
+
+    static void eraseOne(SmallVectorImpl<NodeT *> &Nodes, NodeT *N) {
+      typename SmallVectorImpl<NodeT *>::iterator I =
+          std::find(Nodes.begin(), Nodes.end(), N);
+      if (I != Nodes.end())
+        Nodes.erase(I);
+    }
+  };
+
+  /// getDomEdge - Return the edge of the dominance graph corresponding to
+  /// the CFG edge of update U: the reverse edge for post-dominators.
+  std::pair<NodeT *, NodeT *> getDomEdge(const UpdateType &U) const {
+    if (this->IsPostDominators)
+      return std::make_pair(U.To, U.From);
+    return std::make_pair(U.From, U.To);
+  }
+
+  /// legalizeUpdates - Reduce a batch to one update per edge, dropping the
+  /// edges that were inserted as many times as they were deleted.
+  static void legalizeUpdates(ArrayRef<UpdateType> Updates,
+                              SmallVectorImpl<UpdateType> &Legal) {
+    typedef std::pair<NodeT *, NodeT *> EdgeType;
+    SmallVector<EdgeType, 8> Edges;
+    DenseMap<EdgeType, int> NetChange;
+    for (unsigned i = 0, e = Updates.size(); i != e; ++i) {
+      EdgeType Edge(Updates[i].From, Updates[i].To);
+      std::pair<typename DenseMap<EdgeType, int>::iterator, bool> Entry =
+          NetChange.insert(std::make_pair(Edge, 0));
+      if (Entry.second)
+        Edges.push_back(Edge);
+      Entry.first->second += Updates[i].Kind == Insert ? 1 : -1;
+    }
+    for (unsigned i = 0, e = Edges.size(); i != e; ++i)
+      if (int Change = NetChange[Edges[i]])
+        Legal.push_back(UpdateType(Change > 0 ? Insert : Delete,
+                                   Edges[i].first, Edges[i].second));
+  }
+
+  /// getDomChildren - Collect the successors of N in the dominance graph, or
+  /// its predecessors if Reverse is set, as they were before the pending
+  /// updates in PU.  The null block stands for the virtual root of a
+  /// post-dominator tree, whose successors are the exits.
+  void getDomChildren(NodeT *N, bool Reverse, const PendingUpdates *PU,
+                      SmallVectorImpl<NodeT *> &Result) const {
+    Result.clear();
+    if (!N) {
+      if (!Reverse)
+        Result.append(this->Roots.begin(), this->Roots.end());
+      return;
+    }
+    if (this->IsPostDominators != Reverse) {
+      typedef GraphTraits<Inverse<NodeT *> > InvTraits;
+      Result.append(InvTraits::child_begin(N), InvTraits::child_end(N));
+    } else {
+      typedef GraphTraits<NodeT *> Traits;
+      Result.append(Traits::child_begin(N), Traits::child_end(N));
+    }
+    if (Reverse && RootNode && !RootNode->getBlock() &&
+        std::find(this->Roots.begin(), this->Roots.end(), N) !=
+            this->Roots.end())
+      Result.push_back(nullptr);
+    if (PU)
+      PU->adjust(N, Reverse, Result);
+  }
+
+  /// getNearestCommonDominatorNode - Walk up from the deeper of two nodes of
+  /// the tree until they meet.
+  static DomTreeNodeBase<NodeT> *
+  getNearestCommonDominatorNode(DomTreeNodeBase<NodeT> *A,
+                                DomTreeNodeBase<NodeT> *B) {
+    while (A != B) {
+      if (A->getLevel() < B->getLevel())
+        std::swap(A, B);
+      A = A->getIDom();
+    }
+    return A;
+  }
+
+  /// computeRegionIDoms - Number the blocks reachable from Root through the
+  /// blocks of Region, or through blocks missing from the tree if Region is
+  /// null, in reverse post-order with Root first, and compute their
+  /// immediate dominators with the iterative algorithm of Cooper, Harvey and
+  /// Kennedy.  IDom[i] is the position in Order of the immediate dominator of
+  /// Order[i].  If Exits is non-null, the edges that leave the region are
+  /// added to it.
+  void computeRegionIDoms(NodeT *Root, const SmallPtrSetImpl<NodeT *> *Region,
+                          const PendingUpdates *PU,
+                          SmallVectorImpl<NodeT *> &Order,
+                          SmallVectorImpl<unsigned> &IDom,
+                          SmallVectorImpl<std::pair<NodeT *, NodeT *> > *Exits)
+      const {
+    struct DFSEntry {
+      NodeT *Block;
+      unsigned NextSucc;
+      SmallVector<NodeT *, 4> Succs;
+    };
+
+    SmallVector<NodeT *, 32> PostOrder;
+    SmallPtrSet<NodeT *, 32> Visited;
+    std::vector<DFSEntry> Stack(1);
+    Stack.back().Block = Root;
+    Stack.back().NextSucc = 0;
+    getDomChildren(Root, false, PU, Stack.back().Succs);
+    Visited.insert(Root);
+    while (!Stack.empty()) {
+      DFSEntry &Top = Stack.back();
+      if (Top.NextSucc == Top.Succs.size()) {
+        PostOrder.push_back(Top.Block);
+        Stack.pop_back();
+        continue;
+      }
+      NodeT *Pred = Top.Block;
+      NodeT *Succ = Top.Succs[Top.NextSucc++];
+      if (Succ == Root)
+        continue;
+      if (Region ? !Region->count(Succ) : getNode(Succ) != nullptr) {
+        if (Exits)
+          Exits->push_back(std::make_pair(Pred, Succ));
+        continue;
+      }
+      if (!Visited.insert(Succ))
+        continue;
+      Stack.push_back(DFSEntry());
+      Stack.back().Block = Succ;
+      Stack.back().NextSucc = 0;
+      getDomChildren(Succ, false, PU, Stack.back().Succs);
+    }
+
+    Order.clear();
+    Order.append(PostOrder.rbegin(), PostOrder.rend());
+    DenseMap<NodeT *, unsigned> Number;
+    for (unsigned i = 0, e = Order.size(); i != e; ++i)
+      Number[Order[i]] = i;
+
+    // Predecessors outside the region are either Root or unreachable.
+    std::vector<SmallVector<unsigned, 4> > Preds(Order.size());
+    SmallVector<NodeT *, 8> PredBlocks;
+    for (unsigned i = 1, e = Order.size(); i != e; ++i) {
+      getDomChildren(Order[i], true, PU, PredBlocks);
+      for (unsigned j = 0, je = PredBlocks.size(); j != je; ++j) {
+        typename DenseMap<NodeT *, unsigned>::const_iterator It =
+            Number.find(PredBlocks[j]);
+        if (It != Number.end())
+          Preds[i].push_back(It->second);
+      }
+    }
+
+    // Dominators come before the blocks they dominate in reverse post-order,
+    // so walking up from two blocks until their numbers meet finds their
+    // nearest common dominator.
+    const unsigned Undefined = ~0U;
+    IDom.assign(Order.size(), Undefined);
+    IDom[0] = 0;
+    bool Changed = true;
+    while (Changed) {
+      Changed = false;
+      for (unsigned i = 1, e = Order.size(); i != e; ++i) {
+        unsigned NewIDom = Undefined;
+        for (unsigned j = 0, je = Preds[i].size(); j != je; ++j) {
+          unsigned Candidate = Preds[i][j];
+          if (IDom[Candidate] == Undefined)
+            continue;
+          if (NewIDom == Undefined) {
+            NewIDom = Candidate;
+            continue;
+          }
+          while (Candidate != NewIDom) {
+            while (Candidate > NewIDom)
+              Candidate = IDom[Candidate];
+            while (NewIDom > Candidate)
+              NewIDom = IDom[NewIDom];
+          }
+        }
+        assert(NewIDom != Undefined && "Block without a numbered predecessor!");
+        if (IDom[i] != NewIDom) {
+          IDom[i] = NewIDom;
+          Changed = true;
+        }
+      }
+    }
+  }
+
+  /// insertReachable - Update the tree for a new dominance-graph edge between
+  /// two nodes already in it.
+  void insertReachable(DomTreeNodeBase<NodeT> *FromNode,
+                       DomTreeNodeBase<NodeT> *ToNode,
+                       const PendingUpdates *PU) {
+    DomTreeNodeBase<NodeT> *NCD =
+        getNearestCommonDominatorNode(FromNode, ToNode);
+    const unsigned NCDLevel = NCD->getLevel();
+
+    // A node V becomes a child of NCD iff it is deeper than NCD's children
+    // and a path from To to V never goes above the level of V.  To is the
+    // first candidate; if it is a child of NCD already, nothing changes.
+    if (NCDLevel + 1 >= ToNode->getLevel())
+      return;
+
+    // Find the affected nodes deepest first.  The bucket is ordered by level
+    // and then by discovery, so that the result does not depend on the
+    // addresses of the nodes.
+    std::priority_queue<std::pair<unsigned, unsigned> > Bucket;
+    SmallVector<DomTreeNodeBase<NodeT> *, 16> Discovered;
+    SmallPtrSet<DomTreeNodeBase<NodeT> *, 16> Visited;
+    SmallVector<DomTreeNodeBase<NodeT> *, 16> Affected, Unaffected;
+    SmallVector<NodeT *, 8> Succs;
+    Bucket.push(std::make_pair(ToNode->getLevel(), ~0U));
+    Discovered.push_back(ToNode);
+    Visited.insert(ToNode);
+    while (!Bucket.empty()) {
+      DomTreeNodeBase<NodeT> *N = Discovered[~Bucket.top().second];
+      Bucket.pop();
+      Affected.push_back(N);
+
+      const unsigned CurrentLevel = N->getLevel();
+      for (;;) {
+        getDomChildren(N->getBlock(), false, PU, Succs);
+        for (unsigned i = 0, e = Succs.size(); i != e; ++i) {
+          DomTreeNodeBase<NodeT> *SuccNode = getNode(Succs[i]);
+          assert(SuccNode && "Unreachable successor of a reachable block!");
+          const unsigned SuccLevel = SuccNode->getLevel();
+          if (SuccLevel <= NCDLevel + 1 || !Visited.insert(SuccNode))
+            continue;
+          if (SuccLevel > CurrentLevel) {
+            // Not affected itself, but the search continues below it.
+            Unaffected.push_back(SuccNode);
+          } else {
+            Bucket.push(
+                std::make_pair(SuccLevel, ~unsigned(Discovered.size())));
+            Discovered.push_back(SuccNode);
+          }
+        }
+        if (Unaffected.empty())
+          break;
+        N = Unaffected.pop_back_val();
+      }
+    }
+
+    for (unsigned i = 0, e = Affected.size(); i != e; ++i)
+      Affected[i]->setIDom(NCD);
+  }
+
+  /// insertUnreachable - Update the tree for a new edge from a node of the
+  /// tree to a block that was unreachable.  Only used for forward dominators.
+  void insertUnreachable(DomTreeNodeBase<NodeT> *FromNode, NodeT *To,
+                         const PendingUpdates *PU) {
+    // Everything the edge makes reachable is dominated by To.
+    SmallVector<NodeT *, 32> Order;
+    SmallVector<unsigned, 32> IDom;
+    SmallVector<std::pair<NodeT *, NodeT *>, 8> Exits;
+    computeRegionIDoms(To, nullptr, PU, Order, IDom, &Exits);
+
+    DomTreeNodes[To] = FromNode->addChild(
+        new DomTreeNodeBase<NodeT>(To, FromNode));
+    for (unsigned i = 1, e = Order.size(); i != e; ++i) {
+      DomTreeNodeBase<NodeT> *IDomNode = getNode(Order[IDom[i]]);
+      DomTreeNodes[Order[i]] = IDomNode->addChild(
+          new DomTreeNodeBase<NodeT>(Order[i], IDomNode));
+    }
+
+    // Edges from the new blocks back into the old part of the tree are
+    // insertions between reachable blocks now.
+    for (unsigned i = 0, e = Exits.size(); i != e; ++i)
+      insertReachable(getNode(Exits[i].first), getNode(Exits[i].second), PU);
+  }
+
+  /// applyInsertion - Update the tree for the CFG edge From->To.  Return true
+  /// if the tree had to be recalculated.
+  bool applyInsertion(NodeT *From, NodeT *To, const PendingUpdates *PU) {
+    DFSInfoValid = false;
+    if (this->IsPostDominators) {
+      // A block gaining its first successor stops being an exit, and a block
+      // that could not reach an exit before may do so now.  Both change the
+      // roots of the tree.
+      if (!getNode(From) || !getNode(To) ||
+          std::find(this->Roots.begin(), this->Roots.end(), From) !=
+              this->Roots.end())
+        return recalculateFrom(From);
+      insertReachable(getNode(To), getNode(From), PU);
+      return false;
+    }
+
+    // An edge out of an unreachable block changes nothing.
+    DomTreeNodeBase<NodeT> *FromNode = getNode(From);
+    if (!FromNode)
+      return false;
+    if (DomTreeNodeBase<NodeT> *ToNode = getNode(To))
+      insertReachable(FromNode, ToNode, PU);
+    else
+      insertUnreachable(FromNode, To, PU);
+    return false;
+  }
+
+  /// applyDeletion - Update the tree for the removal of the CFG edge
+  /// From->To.  Return true if the tree had to be recalculated.
+  bool applyDeletion(NodeT *From, NodeT *To, const PendingUpdates *PU) {
+    DFSInfoValid = false;
+    SmallVector<NodeT *, 8> Succs;
+    getDomChildren(From, this->IsPostDominators, PU, Succs);
+    if (std::find(Succs.begin(), Succs.end(), To) != Succs.end())
+      return false;
+    // A block losing its last successor becomes an exit.
+    if (this->IsPostDominators && Succs.empty())
+      return recalculateFrom(From);
+
+    std::pair<NodeT *, NodeT *> Edge =
+        getDomEdge(UpdateType(Delete, From, To));
+    DomTreeNodeBase<NodeT> *FromNode = getNode(Edge.first);
+    DomTreeNodeBase<NodeT> *ToNode = getNode(Edge.second);
+    if (!FromNode || !ToNode)
+      return false;
+
+    // Deleting an edge to a dominator of its source, such as a loop back
+    // edge, removes no simple path and so changes nothing.
+    DomTreeNodeBase<NodeT> *Top =
+        getNearestCommonDominatorNode(FromNode, ToNode);
+    if (Top == ToNode)
+      return false;
+
+    // Only the nodes below Top can get new dominators, and Top still
+    // dominates all of them: recompute that subtree on its own.  Blocks it
+    // no longer reaches have become unreachable.  Those may have had edges
+    // to nodes outside the subtree, whose dominators may change too, so the
+    // subtree to recompute then starts at their nearest common dominator.
+    SmallPtrSet<NodeT *, 32> Region, Reached;
+    SmallVector<NodeT *, 32> Order;
+    SmallVector<unsigned, 32> IDom;
+    for (;;) {
+      Region.clear();
+      SmallVector<DomTreeNodeBase<NodeT> *, 32> WorkList(Top->begin(),
+                                                         Top->end());
+      while (!WorkList.empty()) {
+        DomTreeNodeBase<NodeT> *N = WorkList.pop_back_val();
+        Region.insert(N->getBlock());
+        WorkList.append(N->begin(), N->end());
+      }
+
+      computeRegionIDoms(Top->getBlock(), &Region, PU, Order, IDom, nullptr);
+      if (Order.size() == Region.size() + 1)
+        break;
+      // Blocks that can no longer reach an exit change the roots.
+      if (this->IsPostDominators)
+        return recalculateFrom(From);
+
+      Reached.clear();
+      Reached.insert(Order.begin(), Order.end());
+      DomTreeNodeBase<NodeT> *NewTop = Top;
+      for (typename SmallPtrSet<NodeT *, 32>::iterator I = Region.begin(),
+             E = Region.end(); I != E; ++I) {
+        if (Reached.count(*I))
+          continue;
+        getDomChildren(*I, false, PU, Succs);
+        for (unsigned i = 0, e = Succs.size(); i != e; ++i)
+          if (!Region.count(Succs[i]))
+            if (DomTreeNodeBase<NodeT> *SuccNode = getNode(Succs[i]))
+              NewTop = getNearestCommonDominatorNode(NewTop, SuccNode);
+      }
+      if (NewTop == Top)
+        break;
+      Top = NewTop;
+    }
+
+    // Detach everything below Top, then hang the reachable blocks back under
+    // their immediate dominators.  Dominators come first in Order, so their
+    // levels are final by the time their children are attached.
+    Top->Children.clear();
+    for (typename SmallPtrSet<NodeT *, 32>::iterator I = Region.begin(),
+           E = Region.end(); I != E; ++I)
+      getNode(*I)->Children.clear();
+    for (unsigned i = 1, e = Order.size(); i != e; ++i) {
+      DomTreeNodeBase<NodeT> *N = getNode(Order[i]);
+      DomTreeNodeBase<NodeT> *IDomNode = getNode(Order[IDom[i]]);
+      N->IDom = IDomNode;
+      N->Level = IDomNode->Level + 1;
+      IDomNode->Children.push_back(N);
+    }
+
+    if (Order.size() != Region.size() + 1) {
+      Reached.clear();
+      Reached.insert(Order.begin(), Order.end());
+      for (typename SmallPtrSet<NodeT *, 32>::iterator I = Region.begin(),
+             E = Region.end(); I != E; ++I)
+        if (!Reached.count(*I)) {
+          delete getNode(*I);
+          DomTreeNodes.erase(*I);
+        }
+    }
+    return false;
+  }
+
+  /// recalculateFrom - Recompute the tree for the function containing BB.
+  /// Always returns true.
+  bool recalculateFrom(NodeT *BB) {
+    recalculate(*BB->getParent());
+    return true;
+  }
+
+  void verifyAfterUpdate() const {
+    if (!VerifyUpdates || verify())
+      return;
+    errs() << "Incrementally updated tree:\n";
+    print(errs());
+    report_fatal_error("Dominator tree update does not match the CFG!");
+  }
+
 public:
   /// recalculate - compute a dominator tree for the given function
   template<class FT>
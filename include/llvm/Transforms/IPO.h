@@ -16,6 +16,7 @@
 #define LLVM_TRANSFORMS_IPO_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
 
 namespace llvm {
 
@@ -184,6 +185,14 @@ Pass *createFunctionAttrsPass();
 ///
 ModulePass *createMergeFunctionsPass();
 
+//===----------------------------------------------------------------------===//
+/// createProfileFunctionOrderPass - This pass orders the functions of the
+/// module by the entry counts in an indexed instrumentation profile, hottest
+/// first, and marks the functions that were never entered cold.  If Filename
+/// is empty, the -function-order-profile option is used.
+///
+ModulePass *createProfileFunctionOrderPass(StringRef Filename = "");
+
 //===----------------------------------------------------------------------===//
 /// createPartialInliningPass - This pass inlines parts of functions.
 ///
@@ -328,7 +328,7 @@ public:
         continue;
 
       // Look for an existing PHI.
-      FindExistingPHI(Info->BB, BlockList);
+      FindExistingPHI(Info->BB);
       if (Info->AvailableVal)
         continue;
 
@@ -375,31 +375,37 @@ public:
 
   /// FindExistingPHI - Look through the PHI nodes in a block to see if any of
   /// them match what is needed.
-  void FindExistingPHI(BlkT *BB, BlockListTy *BlockList) {
+  void FindExistingPHI(BlkT *BB) {
+    SmallVector<BBInfo*, 8> TaggedBlocks;
     for (typename BlkT::iterator BBI = BB->begin(), BBE = BB->end();
          BBI != BBE; ++BBI) {
       PhiT *SomePHI = Traits::InstrIsPHI(BBI);
       if (!SomePHI)
         break;
-      if (CheckIfPHIMatches(SomePHI)) {
-        RecordMatchingPHIs(BlockList);
+      if (CheckIfPHIMatches(SomePHI, TaggedBlocks)) {
+        RecordMatchingPHIs(&TaggedBlocks);
         break;
       }
-      // Match failed: clear all the PHITag values.
-      for (typename BlockListTy::iterator I = BlockList->begin(),
-             E = BlockList->end(); I != E; ++I)
+      // Match failed: clear the PHITag values that were set.  Only the blocks
+      // reached from this PHI have one, so don't walk the whole block list: a
+      // block can hold many PHIs for other values that all fail here.
+      for (typename BlockListTy::iterator I = TaggedBlocks.begin(),
+             E = TaggedBlocks.end(); I != E; ++I)
         (*I)->PHITag = nullptr;
+      TaggedBlocks.clear();
     }
   }
 
   /// CheckIfPHIMatches - Check if a PHI node matches the placement and values
-  /// in the BBMap.
-  bool CheckIfPHIMatches(PhiT *PHI) {
+  /// in the BBMap.  Every block given a PHITag is added to TaggedBlocks.
+  bool CheckIfPHIMatches(PhiT *PHI, BlockListTy &TaggedBlocks) {
     SmallVector<PhiT*, 20> WorkList;
     WorkList.push_back(PHI);
 
     // Mark that the block containing this PHI has been visited.
-    BBMap[PHI->getParent()]->PHITag = PHI;
+    BBInfo *PHIInfo = BBMap[PHI->getParent()];
+    PHIInfo->PHITag = PHI;
+    TaggedBlocks.push_back(PHIInfo);
 
     while (!WorkList.empty()) {
       PHI = WorkList.pop_back_val();
@@ -432,6 +438,7 @@ public:
           return false;
         }
         PredInfo->PHITag = IncomingPHIVal;
+        TaggedBlocks.push_back(PredInfo);
 
         WorkList.push_back(IncomingPHIVal);
       }
@@ -440,7 +447,8 @@ public:
   }
 
   /// RecordMatchingPHIs - For each PHI node that matches, record it in both
-  /// the BBMap and the AvailableVals mapping.
+  /// the BBMap and the AvailableVals mapping.  BlockList holds the blocks
+  /// tagged by the successful match.
   void RecordMatchingPHIs(BlockListTy *BlockList) {
     for (typename BlockListTy::iterator I = BlockList->begin(),
            E = BlockList->end(); I != E; ++I)
@@ -28,6 +28,7 @@
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Operator.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -36,6 +37,12 @@ using namespace llvm;
 #define DEBUG_TYPE "inline-cost"
 
 STATISTIC(NumCallsAnalyzed, "Number of call sites analyzed");
+STATISTIC(NumCachedCosts, "Number of inline costs reused from the cache");
+
+static cl::opt<unsigned>
+MaxCachedCostsPerCallee("inline-cost-cache-size", cl::Hidden, cl::init(8),
+                        cl::desc("Number of call site signatures to cache the "
+                                 "inline cost of per callee (0 to disable)"));
 
 namespace {
 
@@ -154,6 +161,7 @@ public:
         SROACostSavingsLost(0) {}
 
   bool analyzeCall(CallSite CS);
+  bool getCallSiteSignature(CallSite CS, SmallVectorImpl<uint64_t> &Signature);
 
   int getThreshold() { return Threshold; }
   int getCost() { return Cost; }
@@ -973,6 +981,94 @@ ConstantInt *CallAnalyzer::stripAndComputeInBoundsConstantOffsets(Value *&V) {
   return cast<ConstantInt>(ConstantInt::get(IntPtrTy, Offset));
 }
 
+/// \brief Test whether the call site is followed by unreachable code, in
+/// which case the callee is in effect noreturn.
+static bool isNoReturnCallSite(CallSite CS) {
+  Instruction *Instr = CS.getInstruction();
+  if (InvokeInst *II = dyn_cast<InvokeInst>(Instr))
+    return isa<UnreachableInst>(II->getNormalDest()->begin());
+  return isa<UnreachableInst>(++BasicBlock::iterator(Instr));
+}
+
+/// \brief Test whether the function calls itself directly.
+static bool isDirectlyRecursive(Function *F) {
+  for (User *U : F->users()) {
+    CallSite Site(U);
+    if (!Site)
+      continue;
+    Instruction *I = Site.getInstruction();
+    if (I->getParent()->getParent() == F)
+      return true;
+  }
+  return false;
+}
+
+/// \brief Describe everything about the call site that analyzeCall() depends
+/// on, besides the body of the callee, as a sequence of words.  Two call
+/// sites of the callee with the same signature get the same cost.
+///
+/// Arguments are described by what the analysis learns from them: a
+/// constant, or a base pointer plus constant offset.  A base that isn't a
+/// constant is identified by the first argument with the same base, since
+/// only its being an alloca and its relation to the other arguments matter.
+/// Returns false if the call site can't be described.
+bool CallAnalyzer::getCallSiteSignature(CallSite CS,
+                                        SmallVectorImpl<uint64_t> &Signature) {
+  assert(Signature.empty() && "Signature already computed!");
+  Signature.push_back(uint64_t(int64_t(Threshold)));
+
+  bool OnlyOneCallAndLocalLinkage = F.hasLocalLinkage() && F.hasOneUse() &&
+    &F == CS.getCalledFunction();
+  Signature.push_back(unsigned(isNoReturnCallSite(CS)) |
+                      unsigned(OnlyOneCallAndLocalLinkage) << 1 |
+                      unsigned(isDirectlyRecursive(CS.getCaller())) << 2);
+
+  enum {
+    ByValArg = 1,
+    ConstantArg = 2,
+    OffsetArg = 4,
+    AllocaBase = 8,
+    ConstantBase = 16
+  };
+  SmallVector<Value *, 8> Bases;
+  for (unsigned I = 0, E = CS.arg_size(); I != E; ++I) {
+    Value *Arg = CS.getArgument(I);
+    uint64_t Kind = CS.isByValArgument(I) ? ByValArg : 0;
+    Bases.push_back(nullptr);
+
+    if (Constant *C = dyn_cast<Constant>(Arg)) {
+      Signature.push_back(Kind | ConstantArg);
+      Signature.push_back(reinterpret_cast<uintptr_t>(C));
+      continue;
+    }
+
+    Value *Base = Arg;
+    ConstantInt *Offset = stripAndComputeInBoundsConstantOffsets(Base);
+    if (!Offset) {
+      Signature.push_back(Kind);
+      continue;
+    }
+    if (Offset->getBitWidth() > 64)
+      return false;
+
+    Kind |= OffsetArg;
+    if (isa<AllocaInst>(Base))
+      Kind |= AllocaBase;
+    if (Constant *C = dyn_cast<Constant>(Base)) {
+      Signature.push_back(Kind | ConstantBase);
+      Signature.push_back(reinterpret_cast<uintptr_t>(C));
+    } else {
+      Bases.back() = Base;
+      unsigned BaseIdx = std::find(Bases.begin(), Bases.end(), Base) -
+                         Bases.begin();
+      Signature.push_back(Kind);
+      Signature.push_back(BaseIdx);
+    }
+    Signature.push_back(Offset->getSExtValue());
+  }
+  return true;
+}
+
 /// \brief Analyze a call site for potential inlining.
 ///
 /// Returns true if inlining this call is viable, and false if it is not
@@ -1040,11 +1136,7 @@ bool CallAnalyzer::analyzeCall(CallSite CS) {
   // invoke is an unreachable instruction, the function is noreturn. As such,
   // there is little point in inlining this unless there is literally zero
   // cost.
-  Instruction *Instr = CS.getInstruction();
-  if (InvokeInst *II = dyn_cast<InvokeInst>(Instr)) {
-    if (isa<UnreachableInst>(II->getNormalDest()->begin()))
-      Threshold = 1;
-  } else if (isa<UnreachableInst>(++BasicBlock::iterator(Instr)))
+  if (isNoReturnCallSite(CS))
     Threshold = 1;
 
   // If this function uses the coldcc calling convention, prefer not to inline
@@ -1059,18 +1151,8 @@ bool CallAnalyzer::analyzeCall(CallSite CS) {
   if (F.empty())
     return true;
 
-  Function *Caller = CS.getInstruction()->getParent()->getParent();
   // Check if the caller function is recursive itself.
-  for (User *U : Caller->users()) {
-    CallSite Site(U);
-    if (!Site)
-      continue;
-    Instruction *I = Site.getInstruction();
-    if (I->getParent()->getParent() == Caller) {
-      IsCallerRecursive = true;
-      break;
-    }
-  }
+  IsCallerRecursive = isDirectlyRecursive(CS.getCaller());
 
   // Populate our simplified values by mapping from function arguments to call
   // arguments with known important simplifications.
@@ -1234,9 +1316,46 @@ void InlineCostAnalysis::getAnalysisUsage(AnalysisUsage &AU) const {
 
 bool InlineCostAnalysis::runOnSCC(CallGraphSCC &SCC) {
   TTI = &getAnalysis<TargetTransformInfo>();
+
+  // The inliner and the function passes after it are about to change the
+  // functions of this SCC, so don't cache their costs until it is done.  The
+  // functions of the SCCs visited before it are final.
+  CurrentSCC.clear();
+  for (CallGraphSCC::iterator I = SCC.begin(), E = SCC.end(); I != E; ++I)
+    if (Function *F = (*I)->getFunction()) {
+      CurrentSCC.insert(F);
+      forgetInlineCosts(F);
+    }
   return false;
 }
 
+bool InlineCostAnalysis::doFinalization(CallGraph &CG) {
+  CostCache.clear();
+  CurrentSCC.clear();
+  return false;
+}
+
+void InlineCostAnalysis::forgetInlineCosts(Function *Callee) {
+  CostCache.erase(Callee);
+}
+
+void InlineCostAnalysis::CalleeCallbackVH::deleted() {
+  assert(ICA && "CalleeCallbackVH called with a null InlineCostAnalysis!");
+  ICA->CostCache.erase(getValPtr());
+  // this now dangles!
+}
+
+/// \brief Turn the outcome of analyzeCall() into an InlineCost.
+static InlineCost getResult(CallAnalyzer &CA, bool ShouldInline) {
+  // Check if there was a reason to force inlining or no inlining.
+  if (!ShouldInline && CA.getCost() < CA.getThreshold())
+    return InlineCost::getNever();
+  if (ShouldInline && CA.getCost() >= CA.getThreshold())
+    return InlineCost::getAlways();
+
+  return llvm::InlineCost::get(CA.getCost(), CA.getThreshold());
+}
+
 InlineCost InlineCostAnalysis::getInlineCost(CallSite CS, int Threshold) {
   return getInlineCost(CS, CS.getCalledFunction(), Threshold);
 }
@@ -1291,17 +1410,37 @@ InlineCost InlineCostAnalysis::getInlineCost(CallSite CS, Function *Callee,
         << "...\n");
 
   CallAnalyzer CA(Callee->getDataLayout(), *TTI, *Callee, Threshold);
+
+  // Reuse the cost of a call site that looked the same to the analysis.
+  // Recursive calls are left alone, since the callee's own values would show
+  // up in the signature.
+  SmallVector<uint64_t, 8> Signature;
+  std::vector<CachedCost> *Cached = nullptr;
+  if (MaxCachedCostsPerCallee && !CurrentSCC.count(Callee) &&
+      CS.getCalledFunction() == Callee && CS.getCaller() != Callee &&
+      CA.getCallSiteSignature(CS, Signature)) {
+    Cached = &CostCache.FindAndConstruct(CalleeCallbackVH(Callee, this))
+                  .second;
+    for (unsigned i = 0, e = Cached->size(); i != e; ++i)
+      if ((*Cached)[i].Signature == Signature) {
+        ++NumCachedCosts;
+        DEBUG(llvm::dbgs() << "      Reusing cached cost\n");
+        return (*Cached)[i].get();
+      }
+  }
+
   bool ShouldInline = CA.analyzeCall(CS);
 
   DEBUG(CA.dump());
 
-  // Check if there was a reason to force inlining or no inlining.
-  if (!ShouldInline && CA.getCost() < CA.getThreshold())
-    return InlineCost::getNever();
-  if (ShouldInline && CA.getCost() >= CA.getThreshold())
-    return InlineCost::getAlways();
+  InlineCost Cost = getResult(CA, ShouldInline);
 
-  return llvm::InlineCost::get(CA.getCost(), CA.getThreshold());
+  if (Cached) {
+    if (Cached->size() >= MaxCachedCostsPerCallee)
+      Cached->erase(Cached->begin());
+    Cached->push_back(CachedCost(Signature, Cost));
+  }
+  return Cost;
 }
 
 bool InlineCostAnalysis::isInlineViable(Function &F) {
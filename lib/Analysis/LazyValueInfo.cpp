@@ -13,8 +13,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/CFG.h"
@@ -25,16 +27,28 @@
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/PatternMatch.h"
 #include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetLibraryInfo.h"
-#include <map>
+#include <algorithm>
 #include <stack>
 using namespace llvm;
 using namespace PatternMatch;
 
 #define DEBUG_TYPE "lazy-value-info"
 
+STATISTIC(NumQueries,   "Number of value queries");
+STATISTIC(NumCacheHits, "Number of queries answered without solving");
+STATISTIC(NumEvictions, "Number of values evicted from the cache to stay "
+                        "within -lvi-max-cache-entries");
+
+static cl::opt<unsigned>
+MaxCacheEntries("lvi-max-cache-entries", cl::Hidden, cl::init(1 << 20),
+                cl::desc("Number of block values LazyValueInfo may cache "
+                         "before the least recently queried values are "
+                         "evicted (0 for no limit)"));
+
 char LazyValueInfo::ID = 0;
 INITIALIZE_PASS_BEGIN(LazyValueInfo, "lazy-value-info",
                 "Lazy Value Information Analysis", false, true)
@@ -301,7 +315,7 @@ namespace {
   struct LVIValueHandle : public CallbackVH {
     LazyValueInfoCache *Parent;
       
-    LVIValueHandle(Value *V, LazyValueInfoCache *P)
+    LVIValueHandle(Value *V, LazyValueInfoCache *P = nullptr)
       : CallbackVH(V), Parent(P) { }
 
     void deleted() override;
@@ -316,13 +330,38 @@ namespace {
   /// maintains information about queries across the clients' queries.
   class LazyValueInfoCache {
     /// ValueCacheEntryTy - This is all of the cached block information for
-    /// exactly one Value*.  The entries are sorted by the BasicBlock* of the
-    /// entries, allowing us to do a lookup with a binary search.
-    typedef std::map<AssertingVH<BasicBlock>, LVILatticeVal> ValueCacheEntryTy;
+    /// exactly one Value*.  Most values are only queried in a few blocks, so
+    /// those are kept inline.
+    typedef SmallDenseMap<AssertingVH<BasicBlock>, LVILatticeVal, 4>
+      ValueCacheEntryTy;
+
+    /// CachedValue - The cached block information for one Value*, and the
+    /// last client query that used it.
+    struct CachedValue {
+      ValueCacheEntryTy BlockVals;
+      unsigned LastQuery;
+      CachedValue() : LastQuery(0) {}
+    };
 
     /// ValueCache - This is all of the cached information for all values,
-    /// mapped from Value* to key information.
-    std::map<LVIValueHandle, ValueCacheEntryTy> ValueCache;
+    /// mapped from Value* to key information.  Entries move when the map
+    /// grows, so references into it must not be held across a lookup.
+    typedef DenseMap<LVIValueHandle, CachedValue, DenseMapInfo<Value *> >
+      ValueCacheTy;
+    ValueCacheTy ValueCache;
+
+    /// NumBlockValues - The number of block values in ValueCache, checked
+    /// against -lvi-max-cache-entries between queries.
+    unsigned NumBlockValues;
+
+    /// EvictionMark - Twice the number of block values the last eviction
+    /// left.  If that is above -lvi-max-cache-entries, because the values in
+    /// use couldn't be evicted, the cache isn't scanned again until it grows
+    /// past the mark, rather than on every query.
+    unsigned EvictionMark;
+
+    /// CurrentQuery - The number of client queries started so far.
+    unsigned CurrentQuery;
     
     /// OverDefinedCache - This tracks, on a per-block basis, the set of 
     /// values that are over-defined at the end of that block.  This is required
@@ -341,7 +380,8 @@ namespace {
     
     friend struct LVIValueHandle;
     
-    /// OverDefinedCacheUpdater - A helper object that ensures that the
+    /// OverDefinedCacheUpdater - A helper object that stores the value
+    /// computed by solveBlockValue in the cache, and ensures that the
     /// OverDefinedCache is updated whenever solveBlockValue returns.
     struct OverDefinedCacheUpdater {
       LazyValueInfoCache *Parent;
@@ -354,6 +394,7 @@ namespace {
         : Parent(P), Val(V), BB(B), BBLV(LV) { }
       
       bool markResult(bool changed) { 
+        Parent->lookup(Val)[BB] = BBLV;
         if (changed && BBLV.isOverdefined())
           Parent->OverDefinedCache.insert(std::make_pair(BB, Val));
         return changed;
@@ -381,10 +422,32 @@ namespace {
     void solve();
     
     ValueCacheEntryTy &lookup(Value *V) {
-      return ValueCache[LVIValueHandle(V, this)];
+      CachedValue &CV =
+        ValueCache.FindAndConstruct(LVIValueHandle(V, this)).second;
+      CV.LastQuery = CurrentQuery;
+      return CV.BlockVals;
     }
 
+    /// startQuery - Count a query from a client for V, and evict the least
+    /// recently queried values first if the cache has outgrown
+    /// -lvi-max-cache-entries.
+    void startQuery(Value *V) {
+      ++NumQueries;
+      ++CurrentQuery;
+      if (isa<Constant>(V))
+        return;
+      lookup(V);
+      if (MaxCacheEntries &&
+          NumBlockValues > std::max<unsigned>(MaxCacheEntries, EvictionMark))
+        evictValues();
+    }
+
+    void evictValues();
+
   public:
+    LazyValueInfoCache()
+      : NumBlockValues(0), EvictionMark(0), CurrentQuery(0) {}
+
     /// getValueInBlock - This is the query interface to determine the lattice
     /// value for the specified Value* at the end of the specified block.
     LVILatticeVal getValueInBlock(Value *V, BasicBlock *BB);
@@ -407,6 +470,8 @@ namespace {
       SeenBlocks.clear();
       ValueCache.clear();
       OverDefinedCache.clear();
+      NumBlockValues = 0;
+      EvictionMark = 0;
     }
   };
 } // end anonymous namespace
@@ -427,9 +492,14 @@ void LVIValueHandle::deleted() {
        E = ToErase.end(); I != E; ++I)
     Parent->OverDefinedCache.erase(*I);
   
+  LazyValueInfoCache::ValueCacheTy::iterator I =
+    Parent->ValueCache.find_as(getValPtr());
+  assert(I != Parent->ValueCache.end() && "Handle not in the cache?");
+  Parent->NumBlockValues -= I->second.BlockVals.size();
+
   // This erasure deallocates *this, so it MUST happen after we're done
   // using any and all members of *this.
-  Parent->ValueCache.erase(*this);
+  Parent->ValueCache.erase(I);
 }
 
 void LazyValueInfoCache::eraseBlock(BasicBlock *BB) {
@@ -450,9 +520,50 @@ void LazyValueInfoCache::eraseBlock(BasicBlock *BB) {
        E = ToErase.end(); I != E; ++I)
     OverDefinedCache.erase(*I);
 
-  for (std::map<LVIValueHandle, ValueCacheEntryTy>::iterator
-       I = ValueCache.begin(), E = ValueCache.end(); I != E; ++I)
-    I->second.erase(BB);
+  for (ValueCacheTy::iterator I = ValueCache.begin(), E = ValueCache.end();
+       I != E; ++I)
+    NumBlockValues -= I->second.BlockVals.erase(BB);
+}
+
+/// evictValues - Drop the values least recently used by a query until the
+/// cache is down to half of -lvi-max-cache-entries, so that evictions are
+/// rare.  Values used by the current query are kept, so the cache may stay
+/// above the limit; the next eviction then waits until it has doubled.
+/// Evicting whole values keeps the overdefined bookkeeping consistent, and
+/// the values a pass has moved past are the ones it is least likely to ask
+/// about again.
+void LazyValueInfoCache::evictValues() {
+  DEBUG(dbgs() << "LVI cache holds " << NumBlockValues
+               << " block values, evicting the least recently used\n");
+
+  SmallVector<std::pair<unsigned, Value *>, 64> ByAge;
+  for (ValueCacheTy::iterator I = ValueCache.begin(), E = ValueCache.end();
+       I != E; ++I)
+    if (I->second.LastQuery != CurrentQuery)
+      ByAge.push_back(std::make_pair(I->second.LastQuery,
+                                     static_cast<Value *>(I->first)));
+  std::sort(ByAge.begin(), ByAge.end());
+
+  DenseSet<Value *> Evicted;
+  unsigned Target = MaxCacheEntries / 2;
+  for (unsigned i = 0, e = ByAge.size(); i != e && NumBlockValues > Target;
+       ++i) {
+    ValueCacheTy::iterator I = ValueCache.find_as(ByAge[i].second);
+    NumBlockValues -= I->second.BlockVals.size();
+    ValueCache.erase(I);
+    Evicted.insert(ByAge[i].second);
+    ++NumEvictions;
+  }
+
+  SmallVector<OverDefinedPairTy, 16> ToErase;
+  for (DenseSet<OverDefinedPairTy>::iterator I = OverDefinedCache.begin(),
+       E = OverDefinedCache.end(); I != E; ++I)
+    if (Evicted.count(I->second))
+      ToErase.push_back(*I);
+  for (unsigned i = 0, e = ToErase.size(); i != e; ++i)
+    OverDefinedCache.erase(ToErase[i]);
+
+  EvictionMark = 2 * NumBlockValues;
 }
 
 void LazyValueInfoCache::solve() {
@@ -470,11 +581,10 @@ bool LazyValueInfoCache::hasBlockValue(Value *Val, BasicBlock *BB) {
   if (isa<Constant>(Val))
     return true;
 
-  LVIValueHandle ValHandle(Val, this);
-  std::map<LVIValueHandle, ValueCacheEntryTy>::iterator I =
-    ValueCache.find(ValHandle);
+  ValueCacheTy::iterator I = ValueCache.find_as(Val);
   if (I == ValueCache.end()) return false;
-  return I->second.count(BB);
+  I->second.LastQuery = CurrentQuery;
+  return I->second.BlockVals.count(BB);
 }
 
 LVILatticeVal LazyValueInfoCache::getBlockValue(Value *Val, BasicBlock *BB) {
@@ -483,38 +593,51 @@ LVILatticeVal LazyValueInfoCache::getBlockValue(Value *Val, BasicBlock *BB) {
     return LVILatticeVal::get(VC);
 
   SeenBlocks.insert(BB);
-  return lookup(Val)[BB];
+  std::pair<ValueCacheEntryTy::iterator, bool> Entry =
+    lookup(Val).insert(std::make_pair(BB, LVILatticeVal()));
+  NumBlockValues += Entry.second;
+  return Entry.first->second;
 }
 
 bool LazyValueInfoCache::solveBlockValue(Value *Val, BasicBlock *BB) {
   if (isa<Constant>(Val))
     return true;
 
-  ValueCacheEntryTy &Cache = lookup(Val);
   SeenBlocks.insert(BB);
-  LVILatticeVal &BBLV = Cache[BB];
-  
-  // OverDefinedCacheUpdater is a helper object that will update
-  // the OverDefinedCache for us when this method exits.  Make sure to
-  // call markResult on it as we exist, passing a bool to indicate if the
-  // cache needs updating, i.e. if we have solve a new value or not.
-  OverDefinedCacheUpdater ODCacheUpdater(Val, BB, BBLV, this);
+  {
+    ValueCacheEntryTy &Cache = lookup(Val);
+    std::pair<ValueCacheEntryTy::iterator, bool> Entry =
+      Cache.insert(std::make_pair(BB, LVILatticeVal()));
+    LVILatticeVal &CachedLV = Entry.first->second;
+
+    // If we've already computed this block's value, return it.  Since we're
+    // reusing a cached value here, we don't need to update the
+    // OverDefinedCache.  The cache will have been properly updated whenever
+    // the cached value was inserted.
+    if (!CachedLV.isUndefined()) {
+      DEBUG(dbgs() << "  reuse BB '" << BB->getName() << "' val=" << CachedLV
+                   << '\n');
+      return true;
+    }
+    NumBlockValues += Entry.second;
 
-  // If we've already computed this block's value, return it.
-  if (!BBLV.isUndefined()) {
-    DEBUG(dbgs() << "  reuse BB '" << BB->getName() << "' val=" << BBLV <<'\n');
-    
-    // Since we're reusing a cached value here, we don't need to update the 
-    // OverDefinedCahce.  The cache will have been properly updated 
-    // whenever the cached value was inserted.
-    ODCacheUpdater.markResult(false);
-    return true;
+    // Otherwise, this is the first time we're seeing this block.  Reset the
+    // cached lattice value to overdefined, so that cycles will terminate and
+    // be conservatively correct.
+    CachedLV.markOverdefined();
   }
 
-  // Otherwise, this is the first time we're seeing this block.  Reset the
-  // lattice value to overdefined, so that cycles will terminate and be
-  // conservatively correct.
+  // The value is computed into BBLV, since solving may add values to the
+  // cache and move the cached entry.
+  LVILatticeVal BBLV;
   BBLV.markOverdefined();
+
+  // OverDefinedCacheUpdater is a helper object that will store BBLV in the
+  // cache and update the OverDefinedCache for us when this method exits.
+  // Make sure to call markResult on it as we exist, passing a bool to
+  // indicate if the cache needs updating, i.e. if we have solve a new value
+  // or not.
+  OverDefinedCacheUpdater ODCacheUpdater(Val, BB, BBLV, this);
   
   Instruction *BBI = dyn_cast<Instruction>(Val);
   if (!BBI || BBI->getParent() != BB) {
@@ -913,9 +1036,14 @@ bool LazyValueInfoCache::getEdgeValue(Value *Val, BasicBlock *BBFrom,
 LVILatticeVal LazyValueInfoCache::getValueInBlock(Value *V, BasicBlock *BB) {
   DEBUG(dbgs() << "LVI Getting block end value " << *V << " at '"
         << BB->getName() << "'\n");
-  
-  BlockValueStack.push(std::make_pair(BB, V));
-  solve();
+
+  startQuery(V);
+  if (hasBlockValue(V, BB)) {
+    ++NumCacheHits;
+  } else {
+    BlockValueStack.push(std::make_pair(BB, V));
+    solve();
+  }
   LVILatticeVal Result = getBlockValue(V, BB);
 
   DEBUG(dbgs() << "  Result = " << Result << "\n");
@@ -927,8 +1055,11 @@ getValueOnEdge(Value *V, BasicBlock *FromBB, BasicBlock *ToBB) {
   DEBUG(dbgs() << "LVI Getting edge value " << *V << " from '"
         << FromBB->getName() << "' to '" << ToBB->getName() << "'\n");
   
+  startQuery(V);
   LVILatticeVal Result;
-  if (!getEdgeValue(V, FromBB, ToBB, Result)) {
+  if (getEdgeValue(V, FromBB, ToBB, Result)) {
+    ++NumCacheHits;
+  } else {
     solve();
     bool WasFastQuery = getEdgeValue(V, FromBB, ToBB, Result);
     (void)WasFastQuery;
@@ -981,11 +1112,12 @@ void LazyValueInfoCache::threadEdge(BasicBlock *PredBB, BasicBlock *OldSucc,
       if (OI == OverDefinedCache.end()) continue;
 
       // Remove it from the caches.
-      ValueCacheEntryTy &Entry = ValueCache[LVIValueHandle(*I, this)];
+      ValueCacheEntryTy &Entry = lookup(*I);
       ValueCacheEntryTy::iterator CI = Entry.find(ToUpdate);
 
       assert(CI != Entry.end() && "Couldn't find entry to update?");
       Entry.erase(CI);
+      --NumBlockValues;
       OverDefinedCache.erase(OI);
 
       // If we removed anything, then we potentially need to update 
@@ -98,6 +98,12 @@ STATISTIC(NumTripCountsNotComputed,
           "Number of loops without predictable loop counts");
 STATISTIC(NumBruteForceTripCountsComputed,
           "Number of loops with trip counts computed by force");
+STATISTIC(NumValuesAtScopeEvicted,
+          "Number of memoized values-at-scope evicted for finished loops");
+STATISTIC(NumSCEVAllocatorKB,
+          "Kilobytes allocated for SCEV expressions");
+STATISTIC(NumSCEVCacheKB,
+          "Kilobytes used by ScalarEvolution caches");
 
 static cl::opt<unsigned>
 MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
@@ -4331,6 +4337,35 @@ void ScalarEvolution::forgetValue(Value *V) {
   }
 }
 
+/// forgetValuesAtScope - Drop the memoized getSCEVAtScope results that were
+/// computed for the scope of the specified loop.
+void ScalarEvolution::forgetValuesAtScope(const Loop *L) {
+  DenseMap<const Loop *, SmallVector<const SCEV *, 4> >::iterator SI =
+    ScopeValues.find(L);
+  if (SI == ScopeValues.end())
+    return;
+
+  SmallVectorImpl<const SCEV *> &Exprs = SI->second;
+  for (unsigned i = 0, e = Exprs.size(); i != e; ++i) {
+    DenseMap<const SCEV *,
+             SmallVector<std::pair<const Loop *, const SCEV *>, 2> >::iterator
+      I = ValuesAtScopes.find(Exprs[i]);
+    if (I == ValuesAtScopes.end())
+      continue;
+    SmallVectorImpl<std::pair<const Loop *, const SCEV *> > &Values =
+      I->second;
+    for (unsigned u = Values.size(); u > 0; u--) {
+      if (Values[u - 1].first == L) {
+        Values.erase(Values.begin() + (u - 1));
+        ++NumValuesAtScopeEvicted;
+      }
+    }
+    if (Values.empty())
+      ValuesAtScopes.erase(I);
+  }
+  ScopeValues.erase(SI);
+}
+
 /// getExact - Get the exact loop backedge taken count considering all loop
 /// exits. A computable result can only be return for loops with a single exit.
 /// Returning the minimum taken count among all exits is incorrect because one
@@ -5249,6 +5284,7 @@ const SCEV *ScalarEvolution::getSCEVAtScope(const SCEV *V, const Loop *L) {
       return Values[u].second ? Values[u].second : V;
   }
   Values.push_back(std::make_pair(L, static_cast<const SCEV *>(nullptr)));
+  ScopeValues[L].push_back(V);
   // Otherwise compute it.
   const SCEV *C = computeSCEVAtScope(V, L);
   SmallVector<std::pair<const Loop *, const SCEV *>, 2> &Values2 = ValuesAtScopes[V];
@@ -7631,7 +7667,7 @@ ScalarEvolution::SCEVCallbackVH::SCEVCallbackVH(Value *V, ScalarEvolution *se)
 //===----------------------------------------------------------------------===//
 
 ScalarEvolution::ScalarEvolution()
-  : FunctionPass(ID), ValuesAtScopes(64), LoopDispositions(64),
+  : FunctionPass(ID), F(nullptr), ValuesAtScopes(64), LoopDispositions(64),
     BlockDispositions(64), FirstUnknown(nullptr) {
   initializeScalarEvolutionPass(*PassRegistry::getPassRegistry());
 }
@@ -7647,6 +7683,26 @@ bool ScalarEvolution::runOnFunction(Function &F) {
 }
 
 void ScalarEvolution::releaseMemory() {
+  // Record how much memory was held on behalf of the function that is being
+  // released, so peak SCEV memory can be tracked down per function.
+  if (F && !UniqueSCEVs.empty()) {
+    size_t AllocatorBytes = SCEVAllocator.getTotalMemory();
+    size_t CacheBytes = ValueExprMap.getMemorySize() +
+                        BackedgeTakenCounts.getMemorySize() +
+                        ConstantEvolutionLoopExitValue.getMemorySize() +
+                        ValuesAtScopes.getMemorySize() +
+                        ScopeValues.getMemorySize() +
+                        LoopDispositions.getMemorySize() +
+                        BlockDispositions.getMemorySize() +
+                        UnsignedRanges.getMemorySize() +
+                        SignedRanges.getMemorySize();
+    NumSCEVAllocatorKB += AllocatorBytes / 1024;
+    NumSCEVCacheKB += CacheBytes / 1024;
+    DEBUG(dbgs() << "SCEV: memory for function '" << F->getName() << "': "
+                 << UniqueSCEVs.size() << " expressions, " << AllocatorBytes
+                 << " allocator bytes, " << CacheBytes << " cache bytes\n");
+  }
+
   // Iterate through all the SCEVUnknown instances and call their
   // destructors, so that they release their references to their values.
   for (SCEVUnknown *U = FirstUnknown; U; U = U->Next)
@@ -7668,6 +7724,7 @@ void ScalarEvolution::releaseMemory() {
   BackedgeTakenCounts.clear();
   ConstantEvolutionLoopExitValue.clear();
   ValuesAtScopes.clear();
+  ScopeValues.clear();
   LoopDispositions.clear();
   BlockDispositions.clear();
   UnsignedRanges.clear();
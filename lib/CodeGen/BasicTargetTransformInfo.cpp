@@ -114,12 +114,19 @@ public:
                               unsigned Index) const override;
   unsigned getMemoryOpCost(unsigned Opcode, Type *Src, unsigned Alignment,
                            unsigned AddressSpace) const override;
+  unsigned getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                      unsigned Factor,
+                                      ArrayRef<unsigned> Indices,
+                                      unsigned Alignment,
+                                      unsigned AddressSpace) const override;
   unsigned getIntrinsicInstrCost(Intrinsic::ID, Type *RetTy,
                                  ArrayRef<Type*> Tys) const override;
   unsigned getNumberOfParts(Type *Tp) const override;
   unsigned getAddressComputationCost( Type *Ty, bool IsComplex) const override;
   unsigned getReductionCost(unsigned Opcode, Type *Ty,
                             bool IsPairwise) const override;
+  unsigned getMinMaxReductionCost(Type *Ty, Type *CondTy,
+                                  bool IsPairwise) const override;
 
   /// @}
 };
@@ -529,6 +536,47 @@ unsigned BasicTTI::getMemoryOpCost(unsigned Opcode, Type *Src,
   return Cost;
 }
 
+unsigned BasicTTI::getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                              unsigned Factor,
+                                              ArrayRef<unsigned> Indices,
+                                              unsigned Alignment,
+                                              unsigned AddressSpace) const {
+  VectorType *VT = cast<VectorType>(VecTy);
+  unsigned NumElts = VT->getNumElements();
+  assert(Factor > 1 && NumElts % Factor == 0 && "Invalid interleave factor");
+  unsigned NumSubElts = NumElts / Factor;
+  VectorType *SubVT = VectorType::get(VT->getElementType(), NumSubElts);
+
+  // The wide access itself.
+  unsigned Cost = TopTTI->getMemoryOpCost(Opcode, VecTy, Alignment,
+                                          AddressSpace);
+
+  // Without better information assume that the shuffles are expanded into
+  // element moves. A load extracts every element of the used members from
+  // the wide vector and inserts it into its member.
+  if (Opcode == Instruction::Load) {
+    for (unsigned i = 0, e = Indices.size(); i != e; ++i)
+      for (unsigned j = 0; j < NumSubElts; ++j) {
+        Cost += TopTTI->getVectorInstrCost(Instruction::ExtractElement, VT,
+                                           Indices[i] + j * Factor);
+        Cost += TopTTI->getVectorInstrCost(Instruction::InsertElement, SubVT,
+                                           j);
+      }
+    return Cost;
+  }
+
+  // A store extracts every element of every member and builds the wide
+  // vector from them.
+  assert(Opcode == Instruction::Store && "Invalid opcode");
+  assert(Indices.size() == Factor && "Store groups may not have gaps");
+  for (unsigned i = 0; i < NumElts; ++i) {
+    Cost += TopTTI->getVectorInstrCost(Instruction::ExtractElement, SubVT,
+                                       i / Factor);
+    Cost += TopTTI->getVectorInstrCost(Instruction::InsertElement, VT, i);
+  }
+  return Cost;
+}
+
 unsigned BasicTTI::getIntrinsicInstrCost(Intrinsic::ID IID, Type *RetTy,
                                          ArrayRef<Type *> Tys) const {
   unsigned ISD = 0;
@@ -638,3 +686,23 @@ unsigned BasicTTI::getReductionCost(unsigned Opcode, Type *Ty,
       TopTTI->getShuffleCost(SK_ExtractSubvector, Ty, NumVecElts / 2, Ty);
   return ShuffleCost + ArithCost + getScalarizationOverhead(Ty, false, true);
 }
+
+unsigned BasicTTI::getMinMaxReductionCost(Type *Ty, Type *CondTy,
+                                          bool IsPairwise) const {
+  assert(Ty->isVectorTy() && "Expect a vector type");
+  unsigned NumVecElts = Ty->getVectorNumElements();
+  unsigned NumReduxLevels = Log2_32(NumVecElts);
+  unsigned CmpOpcode =
+      Ty->isFPOrFPVectorTy() ? Instruction::FCmp : Instruction::ICmp;
+  unsigned MinMaxCost =
+      NumReduxLevels *
+      (TopTTI->getCmpSelInstrCost(CmpOpcode, Ty, CondTy) +
+       TopTTI->getCmpSelInstrCost(Instruction::Select, Ty, CondTy));
+  // Assume the pairwise shuffles add a cost.
+  unsigned ShuffleCost =
+      NumReduxLevels * (IsPairwise + 1) *
+      TopTTI->getShuffleCost(SK_ExtractSubvector, Ty, NumVecElts / 2, Ty);
+  // Only the first element holds the result.
+  return ShuffleCost + MinMaxCost +
+         TopTTI->getVectorInstrCost(Instruction::ExtractElement, Ty, 0);
+}
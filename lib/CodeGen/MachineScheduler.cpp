@@ -14,6 +14,7 @@
 
 #include "llvm/CodeGen/MachineScheduler.h"
 #include "llvm/ADT/PriorityQueue.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/LiveIntervalAnalysis.h"
 #include "llvm/CodeGen/MachineDominators.h"
@@ -23,10 +24,13 @@
 #include "llvm/CodeGen/RegisterClassInfo.h"
 #include "llvm/CodeGen/ScheduleDFS.h"
 #include "llvm/CodeGen/ScheduleHazardRecognizer.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Function.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/GraphWriter.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
 #include <queue>
@@ -35,6 +39,9 @@ using namespace llvm;
 
 #define DEBUG_TYPE "misched"
 
+STATISTIC(NumRegionsOverBudget,
+          "Number of scheduling regions left in source order by the budget");
+
 namespace llvm {
 cl::opt<bool> ForceTopDown("misched-topdown", cl::Hidden,
                            cl::desc("Force top-down list scheduling"));
@@ -73,6 +80,20 @@ static cl::opt<bool> EnableMacroFusion("misched-fusion", cl::Hidden,
 static cl::opt<bool> VerifyScheduling("verify-misched", cl::Hidden,
   cl::desc("Verify machine instrs before and after machine scheduling"));
 
+// Scheduling effort budget.  Building the DAG of a region can take time
+// quadratic in its size, so regions above the size limit, and every region
+// after the time limit is reached in a function, are left in source order.
+static cl::opt<unsigned> SchedMaxRegionInstrs("misched-max-region-instrs",
+  cl::Hidden, cl::init(10000),
+  cl::desc("Leave regions with more instructions than this in source order "
+           "(0 = no limit)"));
+
+static cl::opt<unsigned> SchedFunctionBudgetMS("misched-budget-ms",
+  cl::Hidden, cl::init(0),
+  cl::desc("Leave the remaining regions of a function in source order once "
+           "scheduling it has taken this many milliseconds (0 = no limit). "
+           "The output then depends on the speed of the host."));
+
 // DAG subtrees must have at least this many nodes.
 static const unsigned MinSubtreeSize = 8;
 
@@ -376,10 +397,24 @@ static bool isSchedBoundary(MachineBasicBlock::iterator MI,
   return MI->isCall() || TII->isSchedulingBoundary(MI, MBB, *MF);
 }
 
+/// reportOverBudget - Note that a scheduling region is being left in source
+/// order because of the scheduling budget.
+static void reportOverBudget(const MachineFunction &MF,
+                             MachineBasicBlock::iterator RegionBegin,
+                             const Twine &Reason) {
+  ++NumRegionsOverBudget;
+  const Function &Fn = *MF.getFunction();
+  emitOptimizationRemarkAnalysis(Fn.getContext(), DEBUG_TYPE, Fn,
+                                 RegionBegin->getDebugLoc(),
+                                 "scheduling region left in source order: " +
+                                 Reason);
+}
+
 /// Main driver for both MachineScheduler and PostMachineScheduler.
 void MachineSchedulerBase::scheduleRegions(ScheduleDAGInstrs &Scheduler) {
   const TargetInstrInfo *TII = MF->getTarget().getInstrInfo();
   bool IsPostRA = Scheduler.isPostRA();
+  double TimeSpent = 0;
 
   // Visit all machine basic blocks.
   //
@@ -452,9 +487,30 @@ void MachineSchedulerBase::scheduleRegions(ScheduleDAGInstrs &Scheduler) {
             dbgs() << " RegionInstrs: " << NumRegionInstrs
             << " Remaining: " << RemainingInstrs << "\n");
 
+      // Leave the region alone if it is over budget.
+      if (SchedMaxRegionInstrs && NumRegionInstrs > SchedMaxRegionInstrs) {
+        reportOverBudget(*MF, I, Twine(NumRegionInstrs) +
+                         " instructions is more than the limit of " +
+                         Twine(SchedMaxRegionInstrs));
+        Scheduler.exitRegion();
+        continue;
+      }
+      if (SchedFunctionBudgetMS &&
+          TimeSpent * 1000 > SchedFunctionBudgetMS) {
+        reportOverBudget(*MF, I, "the function used up its budget of " +
+                         Twine(SchedFunctionBudgetMS) + "ms");
+        Scheduler.exitRegion();
+        continue;
+      }
+
       // Schedule a region: possibly reorder instructions.
       // This invalidates 'RegionEnd' and 'I'.
-      Scheduler.schedule();
+      if (SchedFunctionBudgetMS) {
+        double Start = TimeRecord::getCurrentTime(true).getWallTime();
+        Scheduler.schedule();
+        TimeSpent += TimeRecord::getCurrentTime(false).getWallTime() - Start;
+      } else
+        Scheduler.schedule();
 
       // Close the current region.
       Scheduler.exitRegion();
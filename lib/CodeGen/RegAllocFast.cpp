@@ -42,6 +42,14 @@ using namespace llvm;
 STATISTIC(NumStores, "Number of stores added");
 STATISTIC(NumLoads , "Number of loads added");
 STATISTIC(NumCopies, "Number of copies coalesced");
+STATISTIC(NumDeadStores, "Number of stores of dead local registers avoided");
+STATISTIC(NumReusedSlots, "Number of stack slots reused");
+
+static cl::opt<bool>
+LocalLiveness("fast-regalloc-local-liveness", cl::Hidden, cl::init(false),
+              cl::desc("Find virtual registers that are local to a block, "
+                       "don't spill them at the end of the block and share "
+                       "their stack slots between blocks"));
 
 static RegisterRegAlloc
   fastRegAlloc("fast", "fast register allocator", createFastRegisterAllocator);
@@ -51,7 +59,7 @@ namespace {
   public:
     static char ID;
     RAFast() : MachineFunctionPass(ID), StackSlotForVirtReg(-1),
-               isBulkSpilling(false) {}
+               LocalVirtRegBlock(NotLocal), isBulkSpilling(false) {}
   private:
     const TargetMachine *TM;
     MachineFunction *MF;
@@ -67,6 +75,23 @@ namespace {
     // values are spilled.
     IndexedMap<int, VirtReg2IndexFunctor> StackSlotForVirtReg;
 
+    enum { NotLocal = -1, NotSeen = -2 };
+
+    // LocalVirtRegBlock - With -fast-regalloc-local-liveness, the number of
+    // the block for virtual registers that are only referenced in that block
+    // and are always defined there before being read.  Such a register is
+    // dead at the end of its block.  NotLocal for all other registers.
+    IndexedMap<int, VirtReg2IndexFunctor> LocalVirtRegBlock;
+
+    // LocalSlotRegs - Local virtual registers of the current block that have
+    // been given a stack slot.
+    SmallVector<unsigned, 8> LocalSlotRegs;
+
+    // FreeLocalSlots - Stack slots of local virtual registers in blocks that
+    // have been allocated already.  The lifetimes of local registers in
+    // different blocks never overlap, so they can share slots.
+    DenseMap<const TargetRegisterClass*, SmallVector<int, 4> > FreeLocalSlots;
+
     // Everything we know about a live virtual register.
     struct LiveReg {
       MachineInstr *LastUse;    // Last instr to use reg.
@@ -162,6 +187,10 @@ namespace {
 
   private:
     bool runOnMachineFunction(MachineFunction &Fn) override;
+    void findLocalVirtRegs();
+    bool isLocalVirtReg(unsigned VirtReg) const {
+      return LocalVirtRegBlock[VirtReg] >= 0;
+    }
     void AllocateBasicBlock();
     void handleThroughOperands(MachineInstr *MI,
                                SmallVectorImpl<unsigned> &VirtDead);
@@ -205,6 +234,17 @@ int RAFast::getStackSpaceFor(unsigned VirtReg, const TargetRegisterClass *RC) {
   if (SS != -1)
     return SS;          // Already has space allocated?
 
+  // Local registers may take the slot of a local register of an earlier
+  // block.
+  if (isLocalVirtReg(VirtReg)) {
+    LocalSlotRegs.push_back(VirtReg);
+    SmallVectorImpl<int> &Free = FreeLocalSlots[RC];
+    if (!Free.empty()) {
+      ++NumReusedSlots;
+      return StackSlotForVirtReg[VirtReg] = Free.pop_back_val();
+    }
+  }
+
   // Allocate a new stack object for this spill location...
   int FrameIdx = MF->getFrameInfo()->CreateSpillStackObject(RC->getSize(),
                                                             RC->getAlignment());
@@ -1050,6 +1090,20 @@ void RAFast::AllocateBasicBlock() {
     }
   }
 
+  // Local registers are dead at the end of the block, so there is no need to
+  // store them, and their stack slots are free for later blocks.
+  for (LiveRegMap::iterator i = LiveVirtRegs.begin(), e = LiveVirtRegs.end();
+       i != e; ++i)
+    if (i->Dirty && isLocalVirtReg(i->VirtReg)) {
+      i->Dirty = false;
+      ++NumDeadStores;
+    }
+  for (unsigned i = 0, e = LocalSlotRegs.size(); i != e; ++i) {
+    unsigned Reg = LocalSlotRegs[i];
+    FreeLocalSlots[MRI->getRegClass(Reg)].push_back(StackSlotForVirtReg[Reg]);
+  }
+  LocalSlotRegs.clear();
+
   // Spill all physical registers holding virtual registers now.
   DEBUG(dbgs() << "Spilling live registers at end of block.\n");
   spillAll(MBB->getFirstTerminator());
@@ -1063,6 +1117,41 @@ void RAFast::AllocateBasicBlock() {
   DEBUG(MBB->dump());
 }
 
+/// findLocalVirtRegs - Fill in LocalVirtRegBlock with a single pass over the
+/// function.  Registers with debug values are never treated as local, so
+/// that their variables stay visible in their stack slots.
+void RAFast::findLocalVirtRegs() {
+  for (unsigned i = 0, e = MRI->getNumVirtRegs(); i != e; ++i)
+    LocalVirtRegBlock[TargetRegisterInfo::index2VirtReg(i)] = NotSeen;
+
+  for (MachineFunction::iterator MBBi = MF->begin(), MBBe = MF->end();
+       MBBi != MBBe; ++MBBi) {
+    int Num = MBBi->getNumber();
+    for (MachineBasicBlock::iterator MI = MBBi->begin(), ME = MBBi->end();
+         MI != ME; ++MI) {
+      for (unsigned i = 0, e = MI->getNumOperands(); i != e; ++i) {
+        const MachineOperand &MO = MI->getOperand(i);
+        if (!MO.isReg() ||
+            !TargetRegisterInfo::isVirtualRegister(MO.getReg()))
+          continue;
+        int &Block = LocalVirtRegBlock[MO.getReg()];
+        if (MI->isDebugValue())
+          Block = NotLocal;
+        else if (Block == NotSeen)
+          Block = MI->readsVirtualRegister(MO.getReg()) ? NotLocal : Num;
+        else if (Block != Num)
+          Block = NotLocal;
+      }
+    }
+  }
+
+  for (unsigned i = 0, e = MRI->getNumVirtRegs(); i != e; ++i) {
+    int &Block = LocalVirtRegBlock[TargetRegisterInfo::index2VirtReg(i)];
+    if (Block == NotSeen)
+      Block = NotLocal;
+  }
+}
+
 /// runOnMachineFunction - Register allocate the whole function
 ///
 bool RAFast::runOnMachineFunction(MachineFunction &Fn) {
@@ -1084,6 +1173,9 @@ bool RAFast::runOnMachineFunction(MachineFunction &Fn) {
   // mapping for all virtual registers
   StackSlotForVirtReg.resize(MRI->getNumVirtRegs());
   LiveVirtRegs.setUniverse(MRI->getNumVirtRegs());
+  LocalVirtRegBlock.resize(MRI->getNumVirtRegs());
+  if (LocalLiveness)
+    findLocalVirtRegs();
 
   // Loop over all of the basic blocks, eliminating virtual register references
   for (MachineFunction::iterator MBBi = Fn.begin(), MBBe = Fn.end();
@@ -1105,6 +1197,8 @@ bool RAFast::runOnMachineFunction(MachineFunction &Fn) {
 
   SkippedInstrs.clear();
   StackSlotForVirtReg.clear();
+  LocalVirtRegBlock.clear();
+  FreeLocalSlots.clear();
   LiveDbgValueMap.clear();
   return true;
 }
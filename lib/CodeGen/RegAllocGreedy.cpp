@@ -20,6 +20,7 @@
 #include "SpillPlacement.h"
 #include "Spiller.h"
 #include "SplitKit.h"
+#include "llvm/ADT/IntEqClasses.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/CalcSpillWeights.h"
@@ -54,6 +55,7 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+STATISTIC(NumAllocRegions, "Number of independent allocation regions");
 
 static cl::opt<SplitEditor::ComplementSpillMode>
 SplitSpillMode("split-spill-mode", cl::Hidden,
@@ -92,6 +94,14 @@ CSRFirstTimeCost("regalloc-csr-first-time-cost",
               cl::desc("Cost for first time use of callee-saved register."),
               cl::init(0), cl::Hidden);
 
+// This is an analysis only: the registers are still allocated one function at
+// a time, in priority order, whether or not it is given.
+static cl::opt<bool>
+ReportAllocRegions("greedy-report-regions", cl::Hidden,
+                   cl::desc("Report how the function divides into regions "
+                            "that no virtual register is live across "
+                            "(analysis only)"));
+
 static RegisterRegAlloc greedyRegAlloc("greedy", "greedy register allocator",
                                        createGreedyRegisterAllocator);
 
@@ -365,6 +375,7 @@ private:
                                  unsigned PhysReg, unsigned &CostPerUseLimit,
                                  SmallVectorImpl<unsigned> &NewVRegs);
   void initializeCSRCost();
+  void reportAllocationRegions();
   unsigned tryBlockSplit(LiveInterval&, AllocationOrder&,
                          SmallVectorImpl<unsigned>&);
   unsigned tryInstructionSplit(LiveInterval&, AllocationOrder&,
@@ -2238,6 +2249,62 @@ void RAGreedy::initializeCSRCost() {
     CSRCost = CSRCost.getFrequency() * (ActualEntry / FixedEntry);
 }
 
+/// reportAllocationRegions - Divide the function into regions, each a set of
+/// blocks that no virtual register is live across, and report how the virtual
+/// registers are spread over them.  Regions share nothing but physical
+/// registers, so this bounds how much allocating them independently could
+/// gain on a given function.
+void RAGreedy::reportAllocationRegions() {
+  IntEqClasses Regions(MF->getNumBlockIDs());
+  unsigned NumVRegs = 0;
+  for (unsigned i = 0, e = MRI->getNumVirtRegs(); i != e; ++i) {
+    unsigned Reg = TargetRegisterInfo::index2VirtReg(i);
+    if (MRI->reg_nodbg_empty(Reg))
+      continue;
+    LiveInterval &LI = LIS->getInterval(Reg);
+    if (LI.empty())
+      continue;
+    ++NumVRegs;
+    unsigned First = Indexes->getMBBFromIndex(LI.beginIndex())->getNumber();
+    for (LiveInterval::const_iterator I = LI.begin(), E = LI.end(); I != E;
+         ++I) {
+      // Segments are ordered like the blocks, so a segment that runs past the
+      // end of its block continues into the next block in layout order.
+      MachineFunction::iterator MBB = Indexes->getMBBFromIndex(I->start);
+      for (;;) {
+        Regions.join(First, MBB->getNumber());
+        if (I->end <= Indexes->getMBBEndIdx(MBB))
+          break;
+        ++MBB;
+      }
+    }
+  }
+  Regions.compress();
+
+  // Count the registers in each region by the block they start in.
+  SmallVector<unsigned, 8> RegionSize(Regions.getNumClasses());
+  for (unsigned i = 0, e = MRI->getNumVirtRegs(); i != e; ++i) {
+    unsigned Reg = TargetRegisterInfo::index2VirtReg(i);
+    if (MRI->reg_nodbg_empty(Reg))
+      continue;
+    LiveInterval &LI = LIS->getInterval(Reg);
+    if (!LI.empty())
+      ++RegionSize[Regions[Indexes->getMBBFromIndex(LI.beginIndex())
+                               ->getNumber()]];
+  }
+  unsigned NumRegions = 0, Largest = 0;
+  for (unsigned i = 0, e = RegionSize.size(); i != e; ++i)
+    if (RegionSize[i]) {
+      ++NumRegions;
+      Largest = std::max(Largest, RegionSize[i]);
+    }
+  NumAllocRegions += NumRegions;
+
+  dbgs() << "Allocation regions for " << MF->getName() << ": " << NumVRegs
+         << " virtual registers in " << NumRegions
+         << " regions, largest has " << Largest << '\n';
+}
+
 unsigned RAGreedy::selectOrSplitImpl(LiveInterval &VirtReg,
                                      SmallVectorImpl<unsigned> &NewVRegs,
                                      SmallVirtRegSet &FixedRegisters,
@@ -2356,6 +2423,9 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   IntfCache.init(MF, Matrix->getLiveUnions(), Indexes, LIS, TRI);
   GlobalCand.resize(32);  // This will grow as needed.
 
+  if (ReportAllocRegions)
+    reportAllocationRegions();
+
   allocatePhysRegs();
   releaseMemory();
   return true;
@@ -29,6 +29,8 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetLowering.h"
@@ -41,6 +43,7 @@ using namespace llvm;
 
 #define DEBUG_TYPE "dagcombine"
 
+STATISTIC(NodesVisited    , "Number of dag nodes visited by the combiner");
 STATISTIC(NodesCombined   , "Number of dag nodes combined");
 STATISTIC(PreIndexedNodes , "Number of pre-indexed nodes created");
 STATISTIC(PostIndexedNodes, "Number of post-indexed nodes created");
@@ -76,6 +79,66 @@ namespace {
                              "slicing"),
                     cl::init(false));
 
+  static cl::opt<bool>
+  CombinerOpcodeStats("combiner-opcode-stats", cl::Hidden,
+                      cl::desc("Print how many combines were attempted and "
+                               "how many fired for each opcode"),
+                      cl::init(false));
+
+//--------------------------- CombineOpcodeStats -----------------------------//
+
+  /// CombineOpcodeStats - Per-opcode counts of the nodes handed to combine()
+  /// and of the combines that changed the DAG, accumulated over every
+  /// function compiled and printed when the process shuts down.  Like the
+  /// other statistics, this is meant for a single compilation thread.
+  class CombineOpcodeStats {
+    struct Entry {
+      std::string Name;
+      uint64_t Attempted, Fired;
+      Entry() : Attempted(0), Fired(0) {}
+    };
+    std::vector<Entry> Entries;
+
+    Entry &getEntry(unsigned Opcode) {
+      if (Opcode >= Entries.size())
+        Entries.resize(Opcode + 1);
+      return Entries[Opcode];
+    }
+
+  public:
+    void noteAttempt(const SDNode *N, const SelectionDAG *G) {
+      Entry &E = getEntry(N->getOpcode());
+      if (E.Name.empty())
+        E.Name = N->getOperationName(G);
+      ++E.Attempted;
+    }
+    void noteFired(unsigned Opcode) { ++getEntry(Opcode).Fired; }
+
+    ~CombineOpcodeStats() {
+      if (Entries.empty())
+        return;
+      raw_ostream &OS = errs();
+      OS << "===" << std::string(73, '-') << "===\n"
+         << "                        DAG combines by opcode\n"
+         << "===" << std::string(73, '-') << "===\n\n"
+         << "   Attempted       Fired   Rate  Opcode\n";
+      for (unsigned i = 0, e = Entries.size(); i != e; ++i) {
+        const Entry &E = Entries[i];
+        if (!E.Attempted)
+          continue;
+        OS << format("%12llu %11llu %5.1f%%  ",
+                     (unsigned long long)E.Attempted,
+                     (unsigned long long)E.Fired,
+                     100.0 * E.Fired / E.Attempted)
+           << E.Name << '\n';
+      }
+      OS << '\n';
+      OS.flush();
+    }
+  };
+
+  static ManagedStatic<CombineOpcodeStats> OpcodeStats;
+
 //------------------------------ DAGCombiner ---------------------------------//
 
   class DAGCombiner {
@@ -91,21 +154,14 @@ namespace {
     //
     // This has the semantics that when adding to the worklist,
     // the item added must be next to be processed. It should
-    // also only appear once. The naive approach to this takes
-    // linear time.
+    // also only appear once.
     //
-    // To reduce the insert/remove time to logarithmic, we use
-    // a set and a vector to maintain our worklist.
-    //
-    // The set contains the items on the worklist, but does not
-    // maintain the order they should be visited.
-    //
-    // The vector maintains the order nodes should be visited, but may
-    // contain duplicate or removed nodes. When choosing a node to
-    // visit, we pop off the order stack until we find an item that is
-    // also in the contents set. All operations are O(log N).
-    SmallPtrSet<SDNode*, 64> WorkListContents;
-    SmallVector<SDNode*, 64> WorkListOrder;
+    // A node on the worklist keeps its index in the vector in its NodeId, so
+    // that it can be found in constant time.  Re-adding or removing a node
+    // clears its slot instead of shifting the rest of the vector, and popping
+    // skips the cleared slots.  Node ids carry no other meaning while the
+    // combiner runs; every node it visits is left with an id of -1.
+    SmallVector<SDNode*, 64> WorkList;
 
     // AA - Used for DAG load/store alias analysis.
     AliasAnalysis &AA;
@@ -127,14 +183,33 @@ namespace {
     /// AddToWorkList - Add to the work list making sure its instance is at the
     /// back (next to be processed.)
     void AddToWorkList(SDNode *N) {
-      WorkListContents.insert(N);
-      WorkListOrder.push_back(N);
+      removeFromWorkList(N);
+      N->setNodeId(WorkList.size());
+      WorkList.push_back(N);
     }
 
-    /// removeFromWorkList - remove all instances of N from the worklist.
+    /// removeFromWorkList - remove N from the worklist, if it is there.
     ///
     void removeFromWorkList(SDNode *N) {
-      WorkListContents.erase(N);
+      // Ids assigned by earlier phases may point anywhere, so only trust the
+      // id if the slot it names holds N.
+      int Id = N->getNodeId();
+      if (Id >= 0 && unsigned(Id) < WorkList.size() && WorkList[Id] == N)
+        WorkList[Id] = nullptr;
+      N->setNodeId(-1);
+    }
+
+    /// getNextWorkListEntry - Pop the next node to visit off the worklist, or
+    /// return null if the worklist is empty.
+    SDNode *getNextWorkListEntry() {
+      while (!WorkList.empty()) {
+        SDNode *N = WorkList.pop_back_val();
+        if (N) {
+          N->setNodeId(-1);
+          return N;
+        }
+      }
+      return nullptr;
     }
 
     SDValue CombineTo(SDNode *N, const SDValue *To, unsigned NumTo,
@@ -1104,17 +1179,7 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
 
   // while the worklist isn't empty, find a node and
   // try and combine it.
-  while (!WorkListContents.empty()) {
-    SDNode *N;
-    // The WorkListOrder holds the SDNodes in order, but it may contain
-    // duplicates.
-    // In order to avoid a linear scan, we use a set (O(log N)) to hold what the
-    // worklist *should* contain, and check the node we want to visit is should
-    // actually be visited.
-    do {
-      N = WorkListOrder.pop_back_val();
-    } while (!WorkListContents.erase(N));
-
+  while (SDNode *N = getNextWorkListEntry()) {
     // If N has no uses, it is dead.  Make sure to revisit all N's operands once
     // N is deleted from the DAG, since they too may now be dead or may have a
     // reduced number of uses, allowing other xforms.
@@ -1126,12 +1191,19 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
       continue;
     }
 
+    ++NodesVisited;
+    unsigned Opcode = N->getOpcode();
+    if (CombinerOpcodeStats)
+      OpcodeStats->noteAttempt(N, &DAG);
+
     SDValue RV = combine(N);
 
     if (!RV.getNode())
       continue;
 
     ++NodesCombined;
+    if (CombinerOpcodeStats)
+      OpcodeStats->noteFired(Opcode);
 
     // If we get back the same node we passed in, rather than a new node or
     // zero, we know that the node must have defined multiple values and
@@ -952,8 +952,15 @@ SelectionDAG::~SelectionDAG() {
 void SelectionDAG::allnodes_clear() {
   assert(&*AllNodes.begin() == &EntryNode);
   AllNodes.remove(AllNodes.begin());
-  while (!AllNodes.empty())
-    DeallocateNode(AllNodes.begin());
+  // Both callers throw away the debug values along with the nodes, so there
+  // is no need to invalidate them one node at a time as DeallocateNode does.
+  while (!AllNodes.empty()) {
+    SDNode *N = AllNodes.remove(AllNodes.begin());
+    if (N->OperandsNeedDelete)
+      delete[] N->OperandList;
+    N->NodeType = ISD::DELETED_NODE;
+    NodeAllocator.Deallocate(N);
+  }
 }
 
 BinarySDNode *SelectionDAG::GetBinarySDNode(unsigned Opcode, SDLoc DL,
@@ -33,6 +33,7 @@
 #include "llvm/CodeGen/SelectionDAG.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instructions.h"
@@ -65,6 +66,8 @@ STATISTIC(NumFastIselBlocks, "Number of blocks selected entirely by fast isel");
 STATISTIC(NumDAGBlocks, "Number of blocks selected using DAG");
 STATISTIC(NumDAGIselRetries,"Number of times dag isel has to try another path");
 STATISTIC(NumEntryBlocks, "Number of entry blocks encountered");
+STATISTIC(NumSchedFallbacks,
+          "Number of blocks too large for the pre-RA scheduler to reorder");
 STATISTIC(NumFastIselFailLowerArguments,
           "Number of entry blocks where fast isel failed to lower arguments");
 
@@ -240,6 +243,14 @@ static RegisterScheduler
 defaultListDAGScheduler("default", "Best scheduler for the target",
                         createDefaultScheduler);
 
+/// SchedMaxDAGNodes - Blocks whose selected DAG has more nodes than this are
+/// linearized instead of list scheduled, which takes time quadratic in the
+/// size of the DAG in the worst case.
+static cl::opt<unsigned>
+SchedMaxDAGNodes("pre-RA-sched-max-nodes", cl::Hidden, cl::init(50000),
+                 cl::desc("Linearize blocks whose DAG has more nodes than "
+                          "this instead of scheduling them (0 = no limit)"));
+
 namespace llvm {
   //===--------------------------------------------------------------------===//
   /// \brief This class is used by SelectionDAGISel to temporarily override
@@ -1587,6 +1598,20 @@ SelectionDAGISel::FinishBasicBlock() {
 /// one preferred by the target.
 ///
 ScheduleDAGSDNodes *SelectionDAGISel::CreateScheduler() {
+  if (SchedMaxDAGNodes) {
+    unsigned NumNodes = CurDAG->allnodes_size();
+    if (NumNodes > SchedMaxDAGNodes) {
+      ++NumSchedFallbacks;
+      const Function &Fn = *FuncInfo->Fn;
+      emitOptimizationRemarkAnalysis(
+          Fn.getContext(), DEBUG_TYPE, Fn, DebugLoc(),
+          "block '" + FuncInfo->MBB->getName() + "' has " + Twine(NumNodes) +
+          " nodes, more than the scheduler limit of " +
+          Twine(SchedMaxDAGNodes) + "; linearizing it");
+      return createDAGLinearizer(this, OptLevel);
+    }
+  }
+
   RegisterScheduler::FunctionPassCtor Ctor = RegisterScheduler::getDefault();
 
   if (!Ctor) {
@@ -2438,6 +2463,39 @@ struct MatchScope {
 
 }
 
+/// BuildSwitchCaseOffsets - Decode the cases of the indexed switch whose first
+/// case starts at Idx, recording where the code for each case begins, indexed
+/// by the opcode or simple value type it matches.  If iPTR makes a type
+/// appear twice, the first case wins, as it does for OPC_SwitchType.
+static void BuildSwitchCaseOffsets(const unsigned char *MatcherTable,
+                                   unsigned Idx, bool IsTypeSwitch,
+                                   const TargetLowering *TLI,
+                                   std::vector<unsigned> &Offsets) {
+  while (1) {
+    unsigned CaseSize = MatcherTable[Idx++];
+    if (CaseSize & 128)
+      CaseSize = GetVBR(CaseSize, MatcherTable, Idx);
+    if (CaseSize == 0) break;
+
+    unsigned Key;
+    if (IsTypeSwitch) {
+      MVT CaseVT = (MVT::SimpleValueType)MatcherTable[Idx++];
+      if (CaseVT == MVT::iPTR)
+        CaseVT = TLI->getPointerTy();
+      Key = CaseVT.SimpleTy;
+    } else {
+      Key = MatcherTable[Idx++];
+      Key |= (unsigned)MatcherTable[Idx++] << 8;
+    }
+
+    if (Key >= Offsets.size())
+      Offsets.resize(Key+1);
+    if (Offsets[Key] == 0)
+      Offsets[Key] = Idx;
+    Idx += CaseSize;
+  }
+}
+
 SDNode *SelectionDAGISel::
 SelectCodeCommon(SDNode *NodeToMatch, const unsigned char *MatcherTable,
                  unsigned TableSize) {
@@ -2769,6 +2827,37 @@ SelectCodeCommon(SDNode *NodeToMatch, const unsigned char *MatcherTable,
                    << "] from " << SwitchStart << " to " << MatcherIndex<<'\n');
       continue;
     }
+    case OPC_SwitchOpcodeIndexed:
+    case OPC_SwitchTypeIndexed: {
+      // These are encoded like OPC_SwitchOpcode and OPC_SwitchType, with a
+      // switch number in front of the cases, but look the case up in a table
+      // instead of scanning for it.
+      bool IsTypeSwitch = Opcode == OPC_SwitchTypeIndexed;
+      unsigned SwitchStart = MatcherIndex-1; (void)SwitchStart;
+      unsigned SwitchNo = MatcherTable[MatcherIndex++];
+      if (SwitchNo & 128)
+        SwitchNo = GetVBR(SwitchNo, MatcherTable, MatcherIndex);
+
+      if (SwitchNo >= SwitchCaseOffsets.size())
+        SwitchCaseOffsets.resize(SwitchNo+1);
+      std::vector<unsigned> &Offsets = SwitchCaseOffsets[SwitchNo];
+      if (Offsets.empty())
+        BuildSwitchCaseOffsets(MatcherTable, MatcherIndex, IsTypeSwitch,
+                               getTargetLowering(), Offsets);
+
+      unsigned Key = IsTypeSwitch ? (unsigned)N.getSimpleValueType().SimpleTy
+                                  : N.getOpcode();
+      unsigned CaseIdx = Key < Offsets.size() ? Offsets[Key] : 0;
+
+      // If no cases matched, bail out.
+      if (CaseIdx == 0) break;
+
+      DEBUG(dbgs() << (IsTypeSwitch ? "  TypeSwitch" : "  OpcodeSwitch")
+                   << " #" << SwitchNo << " from " << SwitchStart << " to "
+                   << CaseIdx << "\n");
+      MatcherIndex = CaseIdx;
+      continue;
+    }
     case OPC_CheckChild0Type: case OPC_CheckChild1Type:
     case OPC_CheckChild2Type: case OPC_CheckChild3Type:
     case OPC_CheckChild4Type: case OPC_CheckChild5Type:
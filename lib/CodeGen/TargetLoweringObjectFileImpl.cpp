@@ -223,10 +223,22 @@ const MCSection *TargetLoweringObjectFileELF::getExplicitSectionGlobal(
                                     Kind, /*EntrySize=*/0, Group);
 }
 
+/// isColdFunction - Return true if GV is a function marked cold that should
+/// go to .text.unlikely, which linkers gather away from the hot code.
+static bool isColdFunction(const GlobalValue *GV, const TargetMachine &TM) {
+  if (!TM.Options.ColdTextSection)
+    return false;
+  const Function *F = dyn_cast<Function>(GV);
+  return F && F->hasFnAttribute(llvm::Attribute::Cold);
+}
+
 /// getSectionPrefixForGlobal - Return the section prefix name used by options
 /// FunctionsSections and DataSections.
-static StringRef getSectionPrefixForGlobal(SectionKind Kind) {
-  if (Kind.isText())                 return ".text.";
+static StringRef getSectionPrefixForGlobal(const GlobalValue *GV,
+                                           SectionKind Kind,
+                                           const TargetMachine &TM) {
+  if (Kind.isText())
+    return isColdFunction(GV, TM) ? ".text.unlikely." : ".text.";
   if (Kind.isReadOnly())             return ".rodata.";
   if (Kind.isBSS())                  return ".bss.";
 
@@ -257,7 +269,7 @@ SelectSectionForGlobal(const GlobalValue *GV, SectionKind Kind,
   // into a 'uniqued' section name, create and return the section now.
   if ((GV->isWeakForLinker() || EmitUniquedSection || GV->hasComdat()) &&
       !Kind.isCommon()) {
-    StringRef Prefix = getSectionPrefixForGlobal(Kind);
+    StringRef Prefix = getSectionPrefixForGlobal(GV, Kind, TM);
 
     SmallString<128> Name(Prefix);
     TM.getNameWithPrefix(Name, GV, Mang, true);
@@ -277,7 +289,13 @@ SelectSectionForGlobal(const GlobalValue *GV, SectionKind Kind,
                                       Flags, Kind, 0, Group);
   }
 
-  if (Kind.isText()) return TextSection;
+  if (Kind.isText()) {
+    if (isColdFunction(GV, TM))
+      return getContext().getELFSection(".text.unlikely", ELF::SHT_PROGBITS,
+                                        ELF::SHF_EXECINSTR | ELF::SHF_ALLOC,
+                                        SectionKind::getText());
+    return TextSection;
+  }
 
   if (Kind.isMergeable1ByteCString() ||
       Kind.isMergeable2ByteCString() ||
@@ -311,6 +311,7 @@ INITIALIZE_PASS(DominatorTreeWrapperPass, "domtree",
 
 bool DominatorTreeWrapperPass::runOnFunction(Function &F) {
   DT.recalculate(F);
+  DT.setVerifyUpdates(VerifyDomInfo);
   return false;
 }
 
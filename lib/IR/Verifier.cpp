@@ -68,17 +68,28 @@
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/PassManager.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdarg>
+#if LLVM_ENABLE_THREADS
+#include <atomic>
+#include <thread>
+#endif
 using namespace llvm;
 
 static cl::opt<bool> VerifyDebugInfo("verify-debug-info", cl::init(false));
 
+static cl::opt<unsigned>
+VerifierThreads("verify-threads", cl::init(1),
+                cl::desc("Number of threads verifyModule checks function "
+                         "bodies on (0 = one per hardware thread)"));
+
 namespace {
 struct VerifierSupport {
   raw_ostream &OS;
@@ -173,10 +184,35 @@ class Verifier : public InstVisitor<Verifier>, VerifierSupport {
   /// personality function.
   const Value *PersonalityFn;
 
+  /// \brief Held around the few checks that create types or attributes, or
+  /// cache facts in a type, when functions are verified concurrently.  Those
+  /// update the LLVMContext, which isn't thread safe.  Null otherwise.
+  sys::Mutex *ContextLock;
+
+  /// \brief When functions are verified concurrently, the metadata nodes the
+  /// function refers to, each with the amount of output written before it.
+  /// The caller checks them in module order, as a sequential run would, so
+  /// that a node shared between functions is checked and reported once.
+  std::vector<std::pair<uint64_t, MDNode *> > DeferredMDNodes;
+
+  /// \brief Takes ContextLock, if there is one, for its lifetime.
+  class ContextGuard {
+    sys::Mutex *Lock;
+  public:
+    explicit ContextGuard(sys::Mutex *Lock) : Lock(Lock) {
+      if (Lock)
+        Lock->acquire();
+    }
+    ~ContextGuard() {
+      if (Lock)
+        Lock->release();
+    }
+  };
+
 public:
-  explicit Verifier(raw_ostream &OS = dbgs())
+  explicit Verifier(raw_ostream &OS = dbgs(), sys::Mutex *ContextLock = nullptr)
       : VerifierSupport(OS), Context(nullptr), DL(nullptr),
-        PersonalityFn(nullptr) {}
+        PersonalityFn(nullptr), ContextLock(ContextLock) {}
 
   bool verify(const Function &F) {
     M = F.getParent();
@@ -215,6 +251,23 @@ public:
     return !Broken;
   }
 
+  /// \brief Takes the metadata nodes that the last verify(F) left for the
+  /// caller to check with verifyMetadata.
+  void takeDeferredMetadata(std::vector<std::pair<uint64_t, MDNode *> > &MDs) {
+    MDs.swap(DeferredMDNodes);
+    DeferredMDNodes.clear();
+  }
+
+  /// \brief Checks a metadata node that the body of \p F refers to, unless
+  /// an earlier check reached it.  Returns false if it is broken.
+  bool verifyMetadata(MDNode &MD, const Function &F) {
+    M = F.getParent();
+    Context = &M->getContext();
+    Broken = false;
+    visitMDNode(MD, const_cast<Function *>(&F));
+    return !Broken;
+  }
+
   bool verify(const Module &M) {
     this->M = &M;
     Context = &M.getContext();
@@ -311,6 +364,14 @@ private:
   void visitUserOp1(Instruction &I);
   void visitUserOp2(Instruction &I) { visitUserOp1(I); }
   void visitIntrinsicFunctionCall(Intrinsic::ID ID, CallInst &CI);
+
+  /// \brief Return whether Ty is sized.  Struct types remember the answer.
+  bool isSized(Type *Ty, SmallPtrSet<const Type *, 4> *Visited = nullptr) {
+    if (!Ty->isAggregateType())
+      return Ty->isSized(Visited);
+    ContextGuard Guard(ContextLock);
+    return Ty->isSized(Visited);
+  }
   void visitAtomicCmpXchgInst(AtomicCmpXchgInst &CXI);
   void visitAtomicRMWInst(AtomicRMWInst &RMWI);
   void visitFenceInst(FenceInst &FI);
@@ -567,6 +628,13 @@ void Verifier::visitMDNode(MDNode &MD, Function *F) {
   if (!MDNodes.insert(&MD))
     return;
 
+  // A worker thread only sees some of the functions, so it leaves the node
+  // for the caller, which has seen every function before this one.
+  if (ContextLock) {
+    DeferredMDNodes.push_back(std::make_pair(OS.tell(), &MD));
+    return;
+  }
+
   for (unsigned i = 0, e = MD.getNumOperands(); i != e; ++i) {
     Value *Op = MD.getOperand(i);
     if (!Op)
@@ -845,13 +913,16 @@ void Verifier::VerifyParameterAttrs(AttributeSet Attrs, unsigned Idx, Type *Ty,
             Attrs.hasAttribute(Idx, Attribute::AlwaysInline)), "Attributes "
           "'noinline and alwaysinline' are incompatible!", V);
 
-  Assert1(!AttrBuilder(Attrs, Idx).
-            hasAttributes(AttributeFuncs::typeIncompatible(Ty, Idx), Idx),
-          "Wrong types for attribute: " +
-          AttributeFuncs::typeIncompatible(Ty, Idx).getAsString(Idx), V);
+  AttributeSet Incompatible;
+  {
+    ContextGuard Guard(ContextLock);
+    Incompatible = AttributeFuncs::typeIncompatible(Ty, Idx);
+  }
+  Assert1(!AttrBuilder(Attrs, Idx).hasAttributes(Incompatible, Idx),
+          "Wrong types for attribute: " + Incompatible.getAsString(Idx), V);
 
   if (PointerType *PTy = dyn_cast<PointerType>(Ty)) {
-    if (!PTy->getElementType()->isSized()) {
+    if (!isSized(PTy->getElementType())) {
       Assert1(!Attrs.hasAttribute(Idx, Attribute::ByVal) &&
               !Attrs.hasAttribute(Idx, Attribute::InAlloca),
               "Attributes 'byval' and 'inalloca' do not support unsized types!",
@@ -1851,7 +1922,7 @@ void Verifier::visitGetElementPtrInst(GetElementPtrInst &GEP) {
 
   Assert1(isa<PointerType>(TargetTy),
     "GEP base pointer is not a vector or a vector of pointers", &GEP);
-  Assert1(cast<PointerType>(TargetTy)->getElementType()->isSized(),
+  Assert1(isSized(cast<PointerType>(TargetTy)->getElementType()),
           "GEP into unsized type!", &GEP);
   Assert1(GEP.getPointerOperandType()->isVectorTy() ==
           GEP.getType()->isVectorTy(), "Vector GEP must return a vector value",
@@ -1994,8 +2065,8 @@ void Verifier::visitAllocaInst(AllocaInst &AI) {
   Assert1(PTy->getAddressSpace() == 0,
           "Allocation instruction pointer not in the generic address space!",
           &AI);
-  Assert1(PTy->getElementType()->isSized(&Visited), "Cannot allocate unsized type",
-          &AI);
+  Assert1(isSized(PTy->getElementType(), &Visited),
+          "Cannot allocate unsized type", &AI);
   Assert1(AI.getArraySize()->getType()->isIntegerTy(),
           "Alloca array size must have integer type", &AI);
 
@@ -2344,6 +2415,7 @@ bool Verifier::VerifyIntrinsicType(Type *Ty,
     if (D.getArgumentNumber() >= ArgTys.size())
       return true;
 
+    ContextGuard Guard(ContextLock);
     Type *NewTy = ArgTys[D.getArgumentNumber()];
     if (VectorType *VTy = dyn_cast<VectorType>(NewTy))
       NewTy = VectorType::getExtendedElementVectorType(VTy);
@@ -2359,6 +2431,7 @@ bool Verifier::VerifyIntrinsicType(Type *Ty,
     if (D.getArgumentNumber() >= ArgTys.size())
       return true;
 
+    ContextGuard Guard(ContextLock);
     Type *NewTy = ArgTys[D.getArgumentNumber()];
     if (VectorType *VTy = dyn_cast<VectorType>(NewTy))
       NewTy = VectorType::getTruncatedElementVectorType(VTy);
@@ -2369,12 +2442,15 @@ bool Verifier::VerifyIntrinsicType(Type *Ty,
 
     return Ty != NewTy;
   }
-  case IITDescriptor::HalfVecArgument:
+  case IITDescriptor::HalfVecArgument: {
     // This may only be used when referring to a previous vector argument.
-    return D.getArgumentNumber() >= ArgTys.size() ||
-           !isa<VectorType>(ArgTys[D.getArgumentNumber()]) ||
-           VectorType::getHalfElementsVectorType(
-                         cast<VectorType>(ArgTys[D.getArgumentNumber()])) != Ty;
+    if (D.getArgumentNumber() >= ArgTys.size() ||
+        !isa<VectorType>(ArgTys[D.getArgumentNumber()]))
+      return true;
+    ContextGuard Guard(ContextLock);
+    return VectorType::getHalfElementsVectorType(
+               cast<VectorType>(ArgTys[D.getArgumentNumber()])) != Ty;
+  }
   }
   llvm_unreachable("unhandled");
 }
@@ -2602,14 +2678,88 @@ bool llvm::verifyFunction(const Function &f, raw_ostream *OS) {
   return !V.verify(F);
 }
 
+/// \brief Verify the function bodies of \p M on -verify-threads threads.
+///
+/// The failures are printed to \p OS in the order of the functions in the
+/// module, as a sequential run would print them.  The metadata the functions
+/// refer to is checked by \p V, on this thread, in the same order.  Returns
+/// false, without verifying anything, if there is no point in using more than
+/// one thread.
+static bool verifyFunctionsInParallel(const Module &M, Verifier &V,
+                                      raw_ostream &OS, bool &Broken) {
+#if LLVM_ENABLE_THREADS
+  std::vector<const Function *> Work;
+  for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
+    if (!I->isDeclaration())
+      Work.push_back(I);
+
+  unsigned NumThreads = VerifierThreads;
+  if (NumThreads == 0)
+    NumThreads = std::thread::hardware_concurrency();
+  NumThreads = std::min<size_t>(NumThreads, Work.size());
+  if (NumThreads < 2)
+    return false;
+
+  // Each thread has its own verifier, and so its own dominator tree, and
+  // keeps the messages of each function apart.  Functions are handed out one
+  // at a time since their sizes vary widely.
+  std::vector<std::string> Messages(Work.size());
+  std::vector<std::vector<std::pair<uint64_t, MDNode *> > > MDs(Work.size());
+  std::vector<char> Failed(Work.size());
+  sys::Mutex ContextLock;
+  std::atomic<unsigned> NextFunction(0);
+  auto VerifyFunctions = [&]() {
+    std::string Buffer;
+    raw_string_ostream BufferOS(Buffer);
+    Verifier FV(BufferOS, &ContextLock);
+    for (unsigned i = NextFunction++; i < Work.size(); i = NextFunction++) {
+      Failed[i] = !FV.verify(*Work[i]);
+      BufferOS.flush();
+      Messages[i].swap(Buffer);
+      FV.takeDeferredMetadata(MDs[i]);
+    }
+  };
+
+  // Function::getIntrinsicID caches its answer in the context.  Fill the
+  // cache now, so that the threads only read it.
+  for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
+    I->getIntrinsicID();
+
+  std::vector<std::thread> Threads;
+  for (unsigned i = 1; i != NumThreads; ++i)
+    Threads.push_back(std::thread(VerifyFunctions));
+  VerifyFunctions();
+  for (unsigned i = 0, e = Threads.size(); i != e; ++i)
+    Threads[i].join();
+
+  for (unsigned i = 0, e = Work.size(); i != e; ++i) {
+    StringRef Message = Messages[i];
+    uint64_t Pos = 0;
+    for (unsigned j = 0, je = MDs[i].size(); j != je; ++j) {
+      OS << Message.slice(Pos, MDs[i][j].first);
+      Pos = MDs[i][j].first;
+      Broken |= !V.verifyMetadata(*MDs[i][j].second, *Work[i]);
+    }
+    OS << Message.substr(Pos);
+    Broken |= Failed[i];
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 bool llvm::verifyModule(const Module &M, raw_ostream *OS) {
   raw_null_ostream NullStr;
   Verifier V(OS ? *OS : NullStr);
 
+  // The function bodies are independent, so check them first, possibly
+  // concurrently, then check the module-level properties once.
   bool Broken = false;
-  for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
-    if (!I->isDeclaration())
-      Broken |= !V.verify(*I);
+  if (!verifyFunctionsInParallel(M, V, OS ? *OS : NullStr, Broken))
+    for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
+      if (!I->isDeclaration())
+        Broken |= !V.verify(*I);
 
   // Note that this function's return value is inverted from what you would
   // expect of a function called "verify".
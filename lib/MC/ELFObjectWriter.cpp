@@ -15,6 +15,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/MC/MCAsmBackend.h"
 #include "llvm/MC/MCAsmInfo.h"
@@ -29,17 +30,38 @@
 #include "llvm/MC/MCSectionELF.h"
 #include "llvm/MC/MCValue.h"
 #include "llvm/MC/StringTableBuilder.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compression.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ELF.h"
 #include "llvm/Support/ErrorHandling.h"
 #include <vector>
+#if LLVM_ENABLE_THREADS
+#include <atomic>
+#include <thread>
+#endif
 using namespace llvm;
 
 #undef  DEBUG_TYPE
 #define DEBUG_TYPE "reloc-info"
 
+STATISTIC(NumRenderedSections,
+          "Number of sections rendered on worker threads");
+
+static cl::opt<unsigned>
+ParallelWriteThreshold("elf-parallel-write-threshold", cl::Hidden,
+                       cl::init(1 << 20),
+                       cl::desc("Render the contents of sections of at least "
+                                "this many bytes on worker threads (0 to "
+                                "disable)"));
+
+static cl::opt<unsigned>
+ParallelWriteThreads("elf-parallel-write-threads", cl::Hidden, cl::init(0),
+                     cl::desc("Number of threads rendering large sections "
+                              "(default: one per hardware thread)"));
+
 namespace {
 class FragmentWriter {
   bool IsLittleEndian;
@@ -122,6 +144,12 @@ class ELFObjectWriter : public MCObjectWriter {
                               const MCAsmLayout &Layout,
                               const MCSectionELF &Section);
 
+    /// RenderLargeSections - Render the contents of the large sections in
+    /// \p Sections into RenderedSections, several at a time, so that writing
+    /// them out later is a plain copy.
+    void RenderLargeSections(MCAssembler &Asm, const MCAsmLayout &Layout,
+                             ArrayRef<const MCSectionELF *> Sections);
+
     /*static bool isFixupKindX86RIPRel(unsigned Kind) {
       return Kind == X86::reloc_riprel_4byte ||
         Kind == X86::reloc_riprel_4byte_movq_load;
@@ -152,6 +180,11 @@ class ELFObjectWriter : public MCObjectWriter {
     Relocations;
     StringTableBuilder ShStrTabBuilder;
 
+    /// Section contents rendered ahead of time by RenderLargeSections, and
+    /// the index of each section's buffer.
+    std::vector<SmallVector<char, 0> > RenderedSections;
+    DenseMap<const MCSectionData *, unsigned> RenderedSectionIndex;
+
     /// @}
     /// @name Symbol Table Data
     /// @{
@@ -1648,9 +1681,63 @@ void ELFObjectWriter::WriteDataSectionData(MCAssembler &Asm,
       assert(F.getKind() == MCFragment::FT_Data);
       WriteBytes(cast<MCDataFragment>(F).getContents());
     }
-  } else {
-    Asm.writeSectionData(&SD, Layout);
+    return;
+  }
+
+  DenseMap<const MCSectionData *, unsigned>::const_iterator Rendered =
+    RenderedSectionIndex.find(&SD);
+  if (Rendered != RenderedSectionIndex.end()) {
+    const SmallVectorImpl<char> &Buffer = RenderedSections[Rendered->second];
+    WriteBytes(StringRef(Buffer.data(), Buffer.size()));
+    return;
+  }
+
+  Asm.writeSectionData(&SD, Layout);
+}
+
+void
+ELFObjectWriter::RenderLargeSections(MCAssembler &Asm,
+                                     const MCAsmLayout &Layout,
+                                     ArrayRef<const MCSectionELF *> Sections) {
+#if LLVM_ENABLE_THREADS
+  if (!ParallelWriteThreshold)
+    return;
+
+  std::vector<const MCSectionData *> Work;
+  for (unsigned i = 0, e = Sections.size(); i != e; ++i) {
+    const MCSectionData &SD = Asm.getOrCreateSectionData(*Sections[i]);
+    if (IsELFMetaDataSection(SD) || SD.getSection().isVirtualSection())
+      continue;
+    if (Layout.getSectionAddressSize(&SD) >= ParallelWriteThreshold)
+      Work.push_back(&SD);
   }
+
+  unsigned NumThreads = ParallelWriteThreads;
+  if (!NumThreads)
+    NumThreads = std::thread::hardware_concurrency();
+  NumThreads = std::min<unsigned>(NumThreads, Work.size());
+  if (NumThreads < 2)
+    return;
+
+  // The layout is final, so rendering only reads the assembler state.  The
+  // sections are handed out one at a time since their sizes vary widely.
+  RenderedSections.resize(Work.size());
+  std::atomic<unsigned> NextSection(0);
+  auto Render = [&]() {
+    for (unsigned i = NextSection++; i < Work.size(); i = NextSection++)
+      Asm.writeSectionData(Work[i], Layout, RenderedSections[i]);
+  };
+  std::vector<std::thread> Threads;
+  for (unsigned i = 1; i != NumThreads; ++i)
+    Threads.push_back(std::thread(Render));
+  Render();
+  for (unsigned i = 0, e = Threads.size(); i != e; ++i)
+    Threads[i].join();
+
+  for (unsigned i = 0, e = Work.size(); i != e; ++i)
+    RenderedSectionIndex[Work[i]] = i;
+  NumRenderedSections += Work.size();
+#endif
 }
 
 void ELFObjectWriter::WriteSectionHeader(MCAssembler &Asm,
@@ -1799,6 +1886,8 @@ void ELFObjectWriter::WriteObject(MCAssembler &Asm,
     FileOff += GetSectionFileSize(Layout, SD);
   }
 
+  RenderLargeSections(Asm, Layout, Sections);
+
   // Write out the ELF header ...
   WriteHeader(Asm, SectionHeaderOffset, NumSections + 1);
 
@@ -1817,6 +1906,9 @@ void ELFObjectWriter::WriteObject(MCAssembler &Asm,
   // ... and then the remaining sections ...
   for (unsigned i = NumRegularSections + 1; i < NumSections; ++i)
     WriteDataSectionData(Asm, Layout, *Sections[i]);
+
+  RenderedSections.clear();
+  RenderedSectionIndex.clear();
 }
 
 bool
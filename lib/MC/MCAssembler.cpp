@@ -22,6 +22,7 @@
 #include "llvm/MC/MCSection.h"
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/MC/MCValue.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/LEB128.h"
@@ -53,9 +54,20 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+STATISTIC(RelaxationSweeps, "Number of section relaxation sweeps");
+STATISTIC(AdjustedFragments,
+          "Number of resized fragments whose section wasn't laid out again "
+          "until the end of a sweep");
 }
 }
 
+static cl::opt<bool>
+IncrementalRelaxation("mc-incremental-relaxation", cl::Hidden,
+                      cl::init(true),
+                      cl::desc("Adjust the offsets of the fragments after a "
+                               "relaxed one instead of waiting for the next "
+                               "relaxation sweep"));
+
 // FIXME FIXME FIXME: There are number of places in this file where we convert
 // what is a 64-bit assembler value used for computation into a value in the
 // object file, which may truncate it. We should detect that truncation where
@@ -64,7 +76,7 @@ STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
 /* *** */
 
 MCAsmLayout::MCAsmLayout(MCAssembler &Asm)
-  : Assembler(Asm), LastValidFragment()
+  : Assembler(Asm), LastValidFragment(), SweepSection(nullptr)
  {
   // Compute the section layout order. Virtual sections must go last.
   for (MCAssembler::iterator it = Asm.begin(), ie = Asm.end(); it != ie; ++it)
@@ -112,10 +124,79 @@ void MCAsmLayout::ensureValid(const MCFragment *F) const {
   }
 }
 
+void MCAsmLayout::beginSweep(const MCSectionData *SD) {
+  assert(SweepDeltas.empty() && "Previous sweep not ended!");
+  SweepSection = SD;
+  SweepBarrier = 0;
+}
+
+void MCAsmLayout::noteFragmentResized(const MCFragment *F, int64_t Delta) {
+  assert(F->getParent() == SweepSection && "Fragment not in swept section!");
+  // A fragment that hasn't been laid out yet, or is the last one that has,
+  // gets its new size accounted for when its successor is laid out.
+  if (!Delta || !isFragmentValid(F) ||
+      LastValidFragment.lookup(SweepSection) == F)
+    return;
+
+  // Find the first fragment after F whose size depends on its offset.  The
+  // fragments are resized in layout order, so the barrier found for the
+  // previous one still stands if it is past F.
+  unsigned Order = F->getLayoutOrder();
+  if (SweepBarrier <= Order) {
+    SweepBarrier = ~0U;
+    for (const MCFragment *B = F->getNextNode(); B; B = B->getNextNode())
+      if (isa<MCAlignFragment>(B) || isa<MCOrgFragment>(B)) {
+        SweepBarrier = B->getLayoutOrder();
+        break;
+      }
+  }
+
+  SweepDelta D = { Order, SweepBarrier, Delta };
+  if (!SweepDeltas.empty()) {
+    assert(SweepDeltas.back().Order < Order &&
+           "Fragments must be resized in layout order!");
+    D.Total += SweepDeltas.back().Total;
+  }
+  SweepDeltas.push_back(D);
+  if (SweepResizedFragments.insert(F))
+    ++stats::AdjustedFragments;
+}
+
+void MCAsmLayout::endSweep() {
+  SweepSection = nullptr;
+  SweepDeltas.clear();
+}
+
+int64_t MCAsmLayout::getSweepAdjustment(const MCFragment *F) const {
+  // F moves with the fragments resized before it, unless an alignment or
+  // .org fragment sits in between, or F is one.  Their size depends on their
+  // offset and may absorb the change, so it is left out from there on.  For
+  // growth this means relaxation never sees a distance longer than the real
+  // one.  A shrink is left out past the barrier too, which leaves those
+  // offsets as they would be without any adjustment; the sweep that follows
+  // sees the exact ones.  Both the orders and the limits are ascending.
+  unsigned Order = F->getLayoutOrder();
+  const SweepDelta *Begin = SweepDeltas.begin();
+  const SweepDelta *End =
+    std::lower_bound(Begin, SweepDeltas.end(), Order,
+                     [](const SweepDelta &D, unsigned O) {
+                       return D.Order < O;
+                     });
+  const SweepDelta *First =
+    std::lower_bound(Begin, End, Order, [](const SweepDelta &D, unsigned O) {
+                       return D.Limit <= O;
+                     });
+  if (First == End)
+    return 0;
+  return End[-1].Total - (First == Begin ? 0 : First[-1].Total);
+}
+
 uint64_t MCAsmLayout::getFragmentOffset(const MCFragment *F) const {
   ensureValid(F);
   assert(F->Offset != ~UINT64_C(0) && "Address not set!");
-  return F->Offset;
+  if (SweepDeltas.empty() || F->getParent() != SweepSection)
+    return F->Offset;
+  return F->Offset + getSweepAdjustment(F);
 }
 
 // Simple getSymbolOffset helper for the non-varibale case.
@@ -629,11 +710,9 @@ static void writeFragmentContents(const MCFragment &F, MCObjectWriter *OW) {
   OW->WriteBytes(EF.getContents());
 }
 
-/// \brief Write the fragment \p F to the output file.
+/// \brief Write the fragment \p F using the object writer \p OW.
 static void writeFragment(const MCAssembler &Asm, const MCAsmLayout &Layout,
-                          const MCFragment &F) {
-  MCObjectWriter *OW = &Asm.getWriter();
-
+                          const MCFragment &F, MCObjectWriter *OW) {
   // FIXME: Embed in fragments instead?
   uint64_t FragmentSize = Asm.computeFragmentSize(Layout, F);
 
@@ -830,12 +909,51 @@ void MCAssembler::writeSectionData(const MCSectionData *SD,
 
   for (MCSectionData::const_iterator it = SD->begin(), ie = SD->end();
        it != ie; ++it)
-    writeFragment(*this, Layout, *it);
+    writeFragment(*this, Layout, *it, &getWriter());
 
   assert(getWriter().getStream().tell() - Start ==
          Layout.getSectionAddressSize(SD));
 }
 
+namespace {
+/// SectionBufferWriter - An object writer that only knows how to write bytes,
+/// used to render section contents away from the real output stream.
+class SectionBufferWriter : public MCObjectWriter {
+public:
+  SectionBufferWriter(raw_ostream &OS, bool IsLittleEndian)
+    : MCObjectWriter(OS, IsLittleEndian) {}
+
+  void ExecutePostLayoutBinding(MCAssembler &Asm,
+                                const MCAsmLayout &Layout) override {
+    llvm_unreachable("Not an object file writer!");
+  }
+  void RecordRelocation(const MCAssembler &Asm, const MCAsmLayout &Layout,
+                        const MCFragment *Fragment, const MCFixup &Fixup,
+                        MCValue Target, bool &IsPCRel,
+                        uint64_t &FixedValue) override {
+    llvm_unreachable("Not an object file writer!");
+  }
+  void WriteObject(MCAssembler &Asm, const MCAsmLayout &Layout) override {
+    llvm_unreachable("Not an object file writer!");
+  }
+};
+}
+
+void MCAssembler::writeSectionData(const MCSectionData *SD,
+                                   const MCAsmLayout &Layout,
+                                   SmallVectorImpl<char> &Buffer) const {
+  assert(!SD->getSection().isVirtualSection() &&
+         "Virtual sections have no contents!");
+  raw_svector_ostream VecOS(Buffer);
+  SectionBufferWriter OW(VecOS, getWriter().isLittleEndian());
+  for (MCSectionData::const_iterator it = SD->begin(), ie = SD->end();
+       it != ie; ++it)
+    writeFragment(*this, Layout, *it, &OW);
+  VecOS.flush();
+
+  assert(Buffer.size() == Layout.getSectionAddressSize(SD));
+}
+
 std::pair<uint64_t, bool> MCAssembler::handleFixup(const MCAsmLayout &Layout,
                                                    MCFragment &F,
                                                    const MCFixup &Fixup) {
@@ -1044,16 +1162,36 @@ bool MCAssembler::relaxDwarfCallFrameFragment(MCAsmLayout &Layout,
 }
 
 bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
+  ++stats::RelaxationSweeps;
+
   // Holds the first fragment which needed relaxing during this layout. It will
   // remain NULL if none were relaxed.
   // When a fragment is relaxed, all the fragments following it should get
-  // invalidated because their offset is going to change.
+  // invalidated because their offset is going to change.  Rather than laying
+  // the section out again straight away, the rest of the sweep sees their
+  // offsets adjusted by the change in size, so that fragments further on are
+  // relaxed against close to final offsets and fewer sweeps are needed.
+  // Bundle padding depends on exact offsets, so it always gets full sweeps.
   MCFragment *FirstRelaxedFragment = nullptr;
+  bool TrackDeltas = IncrementalRelaxation && !isBundlingEnabled();
+  Layout.beginSweep(&SD);
 
   // Attempt to relax all the fragments in the section.
   for (MCSectionData::iterator I = SD.begin(), IE = SD.end(); I != IE; ++I) {
     // Check if this is a fragment that needs relaxation.
     bool RelaxedFrag = false;
+    uint64_t OldSize = 0;
+    switch(I->getKind()) {
+    default:
+      continue;
+    case MCFragment::FT_Relaxable:
+    case MCFragment::FT_Dwarf:
+    case MCFragment::FT_DwarfFrame:
+    case MCFragment::FT_LEB:
+      OldSize = computeFragmentSize(Layout, *I);
+      break;
+    }
+
     switch(I->getKind()) {
     default:
       break;
@@ -1075,9 +1213,15 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
       RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
       break;
     }
-    if (RelaxedFrag && !FirstRelaxedFragment)
+    if (!RelaxedFrag)
+      continue;
+    if (!FirstRelaxedFragment)
       FirstRelaxedFragment = I;
+    if (TrackDeltas)
+      Layout.noteFragmentResized(
+          I, int64_t(computeFragmentSize(Layout, *I)) - int64_t(OldSize));
   }
+  Layout.endSweep();
   if (FirstRelaxedFragment) {
     Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
     return true;
@@ -1091,8 +1235,12 @@ bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
   bool WasRelaxed = false;
   for (iterator it = begin(), ie = end(); it != ie; ++it) {
     MCSectionData &SD = *it;
-    while (layoutSectionOnce(Layout, SD))
+    unsigned NumSweeps = 1;
+    for (; layoutSectionOnce(Layout, SD); ++NumSweeps)
       WasRelaxed = true;
+    DEBUG(if (NumSweeps > 1)
+            dbgs() << "Relaxed section #" << SD.getOrdinal() << " in "
+                   << NumSweeps << " sweeps\n");
   }
 
   return WasRelaxed;
@@ -18,6 +18,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/MathExtras.h"
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 using namespace llvm;
@@ -233,6 +234,16 @@ FoldingSetImpl::~FoldingSetImpl() {
   free(Buckets);
 }
 void FoldingSetImpl::clear() {
+  // If the bucket array is much larger than the set it last held, shrink it
+  // rather than paying to zero all of it.
+  if (NumBuckets > 64 && NumNodes * 4 < NumBuckets) {
+    free(Buckets);
+    NumBuckets = std::max(64u, unsigned(NextPowerOf2(NumNodes)));
+    Buckets = AllocateBuckets(NumBuckets);
+    NumNodes = 0;
+    return;
+  }
+
   // Set all but the last bucket to null pointers.
   memset(Buckets, 0, NumBuckets*sizeof(void*));
 
@@ -95,6 +95,11 @@ public:
                               unsigned Index) const override;
   unsigned getMemoryOpCost(unsigned Opcode, Type *Src, unsigned Alignment,
                            unsigned AddressSpace) const override;
+  unsigned getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                      unsigned Factor,
+                                      ArrayRef<unsigned> Indices,
+                                      unsigned Alignment,
+                                      unsigned AddressSpace) const override;
 
   unsigned getAddressComputationCost(Type *PtrTy,
                                      bool IsComplex) const override;
@@ -821,6 +826,94 @@ unsigned X86TTI::getMemoryOpCost(unsigned Opcode, Type *Src, unsigned Alignment,
   return Cost;
 }
 
+namespace {
+/// InterleavedCostTblEntry - The cost of separating or merging one member of
+/// an interleaved access group with the given factor and member type.
+struct InterleavedCostTblEntry {
+  unsigned Factor;
+  MVT::SimpleValueType Type;
+  unsigned Cost;
+};
+}
+
+/// InterleavedCostTableLookup - Find the entry for Factor and Ty in Tbl, or
+/// return null.
+template <unsigned N>
+static const InterleavedCostTblEntry *
+InterleavedCostTableLookup(const InterleavedCostTblEntry (&Tbl)[N],
+                           unsigned Factor, MVT Ty) {
+  for (unsigned i = 0; i != N; ++i)
+    if (Tbl[i].Factor == Factor && Ty == Tbl[i].Type)
+      return &Tbl[i];
+  return nullptr;
+}
+
+unsigned X86TTI::getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                            unsigned Factor,
+                                            ArrayRef<unsigned> Indices,
+                                            unsigned Alignment,
+                                            unsigned AddressSpace) const {
+  // With AVX2 the wide access is done in 256-bit pieces and every member of
+  // a group of two is separated or merged with a few cross-lane permutes and
+  // blends (vpermps, vpermq, vblendps). The costs below are per member; they
+  // are indexed by the interleave factor and the type of a member.
+  static const InterleavedCostTblEntry AVX2InterleavedLoadTbl[] = {
+    { 2, MVT::v4i32, 1 },
+    { 2, MVT::v4f32, 1 },
+    { 2, MVT::v8i32, 2 },
+    { 2, MVT::v8f32, 2 },
+    { 2, MVT::v2i64, 1 },
+    { 2, MVT::v2f64, 1 },
+    { 2, MVT::v4i64, 2 },
+    { 2, MVT::v4f64, 2 },
+  };
+
+  static const InterleavedCostTblEntry AVX2InterleavedStoreTbl[] = {
+    { 2, MVT::v4i32, 1 },
+    { 2, MVT::v4f32, 1 },
+    { 2, MVT::v8i32, 3 },
+    { 2, MVT::v8f32, 3 },
+    { 2, MVT::v2i64, 1 },
+    { 2, MVT::v2f64, 1 },
+    { 2, MVT::v4i64, 3 },
+    { 2, MVT::v4f64, 3 },
+  };
+
+  unsigned NumSubElts = VecTy->getVectorNumElements() / Factor;
+  EVT SubVT = TLI->getValueType(
+      VectorType::get(VecTy->getVectorElementType(), NumSubElts));
+
+  if (ST->hasAVX2() && SubVT.isSimple()) {
+    MVT MemberVT = SubVT.getSimpleVT();
+    const InterleavedCostTblEntry *Entry =
+        Opcode == Instruction::Load
+            ? InterleavedCostTableLookup(AVX2InterleavedLoadTbl, Factor,
+                                         MemberVT)
+            : InterleavedCostTableLookup(AVX2InterleavedStoreTbl, Factor,
+                                         MemberVT);
+    if (Entry) {
+      unsigned NumMemOps = (VecTy->getPrimitiveSizeInBits() + 255) / 256;
+      return NumMemOps + Indices.size() * Entry->Cost;
+    }
+  }
+
+  // Other groups are separated or merged element by element, and the chains
+  // of inserts that makes run no faster than accessing every element on its
+  // own.  Cost them like the scalarized strided accesses the loop vectorizer
+  // would emit instead.
+  bool IsLoad = Opcode == Instruction::Load;
+  unsigned NumMembers = IsLoad ? Indices.size() : Factor;
+  Type *EltTy = VecTy->getVectorElementType();
+  Type *MemberTy = VectorType::get(EltTy, NumSubElts);
+  Type *PtrTy = VectorType::get(EltTy->getPointerTo(AddressSpace), NumSubElts);
+  unsigned MemberCost =
+      NumSubElts * (getAddressComputationCost(PtrTy, /*IsComplex=*/true) +
+                    getMemoryOpCost(Opcode, EltTy, Alignment, AddressSpace)) +
+      getScalarizationOverhead(MemberTy, IsLoad, !IsLoad) +
+      getScalarizationOverhead(PtrTy, false, true);
+  return NumMembers * MemberCost;
+}
+
 unsigned X86TTI::getAddressComputationCost(Type *Ty, bool IsComplex) const {
   // Address computations in vectorized code with non-consecutive addresses will
   // likely result in more instructions compared to scalar code where the
@@ -853,6 +946,13 @@ unsigned X86TTI::getReductionCost(unsigned Opcode, Type *ValTy,
     { ISD::ADD,   MVT::v2i64,   2 },      // The data reported by the IACA tool is "1.6".
     { ISD::ADD,   MVT::v4i32,   3 },      // The data reported by the IACA tool is "3.5".
     { ISD::ADD,   MVT::v8i16,   5 },
+    // The logical operations go through the same shuffles as the adds.
+    { ISD::AND,   MVT::v2i64,   2 },
+    { ISD::AND,   MVT::v4i32,   3 },
+    { ISD::OR,    MVT::v2i64,   2 },
+    { ISD::OR,    MVT::v4i32,   3 },
+    { ISD::XOR,   MVT::v2i64,   2 },
+    { ISD::XOR,   MVT::v4i32,   3 },
   };
  
   static const CostTblEntry<MVT::SimpleValueType> AVX1CostTblPairWise[] = {
@@ -872,6 +972,12 @@ unsigned X86TTI::getReductionCost(unsigned Opcode, Type *ValTy,
     { ISD::ADD,   MVT::v2i64,   2 },      // The data reported by the IACA tool is "1.6".
     { ISD::ADD,   MVT::v4i32,   3 },      // The data reported by the IACA tool is "3.3".
     { ISD::ADD,   MVT::v8i16,   4 },      // The data reported by the IACA tool is "4.3".
+    { ISD::AND,   MVT::v2i64,   2 },
+    { ISD::AND,   MVT::v4i32,   3 },
+    { ISD::OR,    MVT::v2i64,   2 },
+    { ISD::OR,    MVT::v4i32,   3 },
+    { ISD::XOR,   MVT::v2i64,   2 },
+    { ISD::XOR,   MVT::v4i32,   3 },
   };
   
   static const CostTblEntry<MVT::SimpleValueType> AVX1CostTblNoPairWise[] = {
@@ -27,6 +27,10 @@
 // -- We define Function* container class with custom "operator<" (FunctionPtr).
 // -- "FunctionPtr" instances are stored in std::set collection, so every
 //    std::set::insert operation will give you result in log(N) time.
+// -- Each FunctionPtr carries a cheap structural hash of its function (its
+//    signature's shape, opcodes and CFG shape), which functions that compare
+//    equal always share. The order is by hash first, so the full comparison
+//    only runs between functions with the same hash.
 //
 // When a match is found the functions are folded. If both functions are
 // overridable, we move the functionality into a new internal function and
@@ -84,7 +88,9 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/IR/CallSite.h"
@@ -111,6 +117,7 @@ STATISTIC(NumFunctionsMerged, "Number of functions merged");
 STATISTIC(NumThunksWritten, "Number of thunks generated");
 STATISTIC(NumAliasesWritten, "Number of aliases generated");
 STATISTIC(NumDoubleWeak, "Number of new functions created");
+STATISTIC(NumFullComparisons, "Number of full function comparisons");
 
 static cl::opt<unsigned> NumFunctionsForSanityCheck(
     "mergefunc-sanity",
@@ -392,15 +399,49 @@ private:
   DenseMap<const Value*, int> sn_mapL, sn_mapR;
 };
 
+/// functionHash - Hash the parts of F that FunctionComparator::compare()
+/// must find identical, and that are cheap to get at: whether it is variadic,
+/// its number of arguments, and the opcodes of its reachable blocks, taken in
+/// the order compare() walks them.  Functions that compare equal always have
+/// the same hash.  Types are left out, since the comparator considers some
+/// different types equivalent.
+static uint64_t functionHash(const Function &F) {
+  hash_code Hash = hash_combine(F.isVarArg(), F.arg_size());
+
+  SmallVector<const BasicBlock *, 8> Worklist;
+  SmallPtrSet<const BasicBlock *, 16> Visited;
+  Worklist.push_back(&F.getEntryBlock());
+  Visited.insert(Worklist[0]);
+  while (!Worklist.empty()) {
+    const BasicBlock *BB = Worklist.pop_back_val();
+    // Each block ends with its terminator's opcode, so the block boundaries
+    // are part of the hash too.
+    for (BasicBlock::const_iterator I = BB->begin(), E = BB->end(); I != E;
+         ++I)
+      Hash = hash_combine(Hash, I->getOpcode());
+
+    const TerminatorInst *Term = BB->getTerminator();
+    for (unsigned i = 0, e = Term->getNumSuccessors(); i != e; ++i)
+      if (Visited.insert(Term->getSuccessor(i)))
+        Worklist.push_back(Term->getSuccessor(i));
+  }
+  return Hash;
+}
+
 class FunctionPtr {
   AssertingVH<Function> F;
   const DataLayout *DL;
+  uint64_t Hash;
 
 public:
-  FunctionPtr(Function *F, const DataLayout *DL) : F(F), DL(DL) {}
+  FunctionPtr(Function *F, const DataLayout *DL)
+      : F(F), DL(DL), Hash(functionHash(*F)) {}
   Function *getFunc() const { return F; }
   void release() { F = 0; }
   bool operator<(const FunctionPtr &RHS) const {
+    if (Hash != RHS.Hash)
+      return Hash < RHS.Hash;
+    ++NumFullComparisons;
     return (FunctionComparator(DL, F, RHS.getFunc()).compare()) == -1;
   }
 };
@@ -1113,6 +1154,10 @@ private:
   /// to modify it.
   FnTreeType FnTree;
 
+  /// The node of each function in FnTree, so that remove() doesn't have to
+  /// compare its way to it.
+  DenseMap<Function *, FnTreeType::iterator> FNodesInTree;
+
   /// DataLayout for more accurate GEP comparisons. May be NULL.
   const DataLayout *DL;
 
@@ -1249,6 +1294,7 @@ bool MergeFunctions::runOnModule(Module &M) {
   } while (!Deferred.empty());
 
   FnTree.clear();
+  FNodesInTree.clear();
 
   return Changed;
 }
@@ -1414,6 +1460,7 @@ bool MergeFunctions::insert(Function *NewFunction) {
       FnTree.insert(FunctionPtr(NewFunction, DL));
 
   if (Result.second) {
+    FNodesInTree[NewFunction] = Result.first;
     DEBUG(dbgs() << "Inserting as unique: " << NewFunction->getName() << '\n');
     return false;
   }
@@ -1448,18 +1495,16 @@ bool MergeFunctions::insert(Function *NewFunction) {
 void MergeFunctions::remove(Function *F) {
   // We need to make sure we remove F, not a function "equal" to F per the
   // function equality comparator.
-  FnTreeType::iterator found = FnTree.find(FunctionPtr(F, DL));
-  size_t Erased = 0;
-  if (found != FnTree.end() && found->getFunc() == F) {
-    Erased = 1;
-    FnTree.erase(found);
-  }
+  DenseMap<Function *, FnTreeType::iterator>::iterator I =
+      FNodesInTree.find(F);
+  if (I == FNodesInTree.end())
+    return;
 
-  if (Erased) {
-    DEBUG(dbgs() << "Removed " << F->getName()
-                 << " from set and deferred it.\n");
-    Deferred.push_back(F);
-  }
+  FnTree.erase(I->second);
+  FNodesInTree.erase(I);
+  DEBUG(dbgs() << "Removed " << F->getName()
+               << " from set and deferred it.\n");
+  Deferred.push_back(F);
 }
 
 // For each instruction used by the value, remove() the function that contains
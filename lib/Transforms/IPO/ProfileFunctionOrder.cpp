@@ -0,0 +1,152 @@
+//===- ProfileFunctionOrder.cpp - Order functions by profile counts -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass reads an indexed instrumentation profile and reorders the
+// functions of the module so that the code generator emits them hottest
+// first.  Functions that the profile shows were never entered are moved to
+// the end and marked cold, which makes ELF targets place them in
+// .text.unlikely under -cold-text-section.  Functions the profile doesn't
+// mention keep their relative order, between the two groups.
+//
+// Functions are looked up by the names the front end used when it
+// instrumented them: the plain name, or "<file>:<name>" for functions with
+// local linkage.  The function hashes in the profile are computed by the
+// front end from the source, so they can't be checked here; a stale profile
+// can only make the order worse, not the code wrong.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/ProfileData/InstrProfReader.h"
+#include "llvm/Support/CommandLine.h"
+#include <algorithm>
+using namespace llvm;
+
+#define DEBUG_TYPE "profile-function-order"
+
+STATISTIC(NumHotFunctions, "Number of functions moved ahead by the profile");
+STATISTIC(NumColdFunctions, "Number of functions marked cold by the profile");
+
+static cl::opt<std::string>
+FunctionOrderProfile("function-order-profile", cl::init(""),
+                     cl::value_desc("filename"),
+                     cl::desc("Indexed instrumentation profile used to order "
+                              "functions"));
+
+namespace {
+class ProfileFunctionOrder : public ModulePass {
+  std::string Filename;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  ProfileFunctionOrder(StringRef Filename = "")
+    : ModulePass(ID), Filename(Filename) {
+    initializeProfileFunctionOrderPass(*PassRegistry::getPassRegistry());
+    if (this->Filename.empty())
+      this->Filename = FunctionOrderProfile;
+  }
+
+  bool runOnModule(Module &M) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+private:
+  bool getEntryCount(IndexedInstrProfReader &Reader, const Module &M,
+                     const Function &F, uint64_t &Count);
+};
+} // end anonymous namespace
+
+char ProfileFunctionOrder::ID = 0;
+INITIALIZE_PASS(ProfileFunctionOrder, "profile-function-order",
+                "Order functions by profile counts", false, false)
+
+/// getEntryCount - Set Count to the number of times F was entered according
+/// to the profile.  Return false if the profile has no data for F.
+bool ProfileFunctionOrder::getEntryCount(IndexedInstrProfReader &Reader,
+                                         const Module &M, const Function &F,
+                                         uint64_t &Count) {
+  uint64_t Hash;
+  std::vector<uint64_t> Counts;
+  std::error_code EC;
+  if (F.hasLocalLinkage()) {
+    StringRef FileName = M.getModuleIdentifier();
+    EC = Reader.getFunctionCounts((FileName + ":" + F.getName()).str(), Hash,
+                                  Counts);
+    if (EC)
+      EC = Reader.getFunctionCounts(F.getName(), Hash, Counts);
+  } else
+    EC = Reader.getFunctionCounts(F.getName(), Hash, Counts);
+  if (EC || Counts.empty())
+    return false;
+  // The first counter counts entries to the function.
+  Count = Counts[0];
+  return true;
+}
+
+namespace {
+struct HotterFunction {
+  bool operator()(const std::pair<uint64_t, Function *> &LHS,
+                  const std::pair<uint64_t, Function *> &RHS) const {
+    return LHS.first > RHS.first;
+  }
+};
+}
+
+bool ProfileFunctionOrder::runOnModule(Module &M) {
+  if (Filename.empty())
+    return false;
+
+  std::unique_ptr<IndexedInstrProfReader> Reader;
+  if (std::error_code EC = IndexedInstrProfReader::create(Filename, Reader)) {
+    M.getContext().emitError("Could not read profile " + Filename + ": " +
+                             EC.message());
+    return false;
+  }
+
+  std::vector<std::pair<uint64_t, Function *> > Hot;
+  std::vector<Function *> Cold;
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
+    uint64_t Count;
+    if (I->isDeclaration() || !getEntryCount(*Reader, M, *I, Count))
+      continue;
+    if (Count)
+      Hot.push_back(std::make_pair(Count, &*I));
+    else
+      Cold.push_back(I);
+  }
+  if (Hot.empty() && Cold.empty())
+    return false;
+
+  // Move the hot functions to the front, hottest first, and the cold ones to
+  // the back.  The stable sort keeps the order deterministic for ties.
+  std::stable_sort(Hot.begin(), Hot.end(), HotterFunction());
+  Module::FunctionListType &Functions = M.getFunctionList();
+  for (unsigned i = Hot.size(); i != 0; --i) {
+    Function *F = Hot[i - 1].second;
+    Functions.splice(Functions.begin(), Functions, F);
+  }
+  for (unsigned i = 0, e = Cold.size(); i != e; ++i) {
+    Function *F = Cold[i];
+    Functions.splice(Functions.end(), Functions, F);
+    F->addFnAttr(Attribute::Cold);
+  }
+  NumHotFunctions += Hot.size();
+  NumColdFunctions += Cold.size();
+  return true;
+}
+
+ModulePass *llvm::createProfileFunctionOrderPass(StringRef Filename) {
+  return new ProfileFunctionOrder(Filename);
+}
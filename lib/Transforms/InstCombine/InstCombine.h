@@ -82,6 +82,8 @@ public:
   }
 };
 
+struct InstCombineReport;
+
 /// InstCombiner - The -instcombine pass.
 class LLVM_LIBRARY_VISIBILITY InstCombiner
     : public FunctionPass,
@@ -92,6 +94,18 @@ class LLVM_LIBRARY_VISIBILITY InstCombiner
   LibCallSimplifier *Simplifier;
   bool MinimizeSize;
 
+  /// NumVisits - The number of instructions taken off the worklist so far in
+  /// the function being combined, checked against -instcombine-max-visits.
+  unsigned NumVisits;
+
+  /// OverBudget - Set once the function being combined has run out of
+  /// iterations or visits.
+  bool OverBudget;
+
+  /// Report - What combining the function took, if -instcombine-report was
+  /// given.
+  InstCombineReport *Report;
+
 public:
   /// Worklist - All of the instructions that need to be simplified.
   InstCombineWorklist Worklist;
@@ -102,7 +116,8 @@ public:
   BuilderTy *Builder;
 
   static char ID; // Pass identification, replacement for typeid
-  InstCombiner() : FunctionPass(ID), DL(nullptr), Builder(nullptr) {
+  InstCombiner()
+      : FunctionPass(ID), DL(nullptr), Report(nullptr), Builder(nullptr) {
     MinimizeSize = false;
     initializeInstCombinerPass(*PassRegistry::getPassRegistry());
   }
@@ -36,6 +36,7 @@
 #include "llvm/Transforms/Scalar.h"
 #include "InstCombine.h"
 #include "llvm-c/Initialization.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringSwitch.h"
@@ -45,16 +46,22 @@
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/GetElementPtrTypeIterator.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/PatternMatch.h"
 #include "llvm/IR/ValueHandle.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Transforms/Utils/Local.h"
 #include <algorithm>
 #include <climits>
+#include <memory>
 using namespace llvm;
 using namespace llvm::PatternMatch;
 
@@ -67,6 +74,26 @@ STATISTIC(NumSunkInst , "Number of instructions sunk");
 STATISTIC(NumExpand,    "Number of expansions");
 STATISTIC(NumFactor   , "Number of factorizations");
 STATISTIC(NumReassoc  , "Number of reassociations");
+STATISTIC(NumVisited  , "Number of insts visited");
+STATISTIC(NumOverBudget, "Number of functions left partly combined by the "
+                         "budget");
+
+// Combining budget.  Some inputs make the combines undo each other and never
+// reach a fixed point, so stop after a bounded amount of work per function.
+static cl::opt<unsigned>
+MaxIterations("instcombine-max-iterations", cl::Hidden, cl::init(1000),
+              cl::desc("Stop combining a function after this many iterations "
+                       "over it (0 = no limit)"));
+
+static cl::opt<unsigned>
+MaxVisits("instcombine-max-visits", cl::Hidden, cl::init(0),
+          cl::desc("Stop combining a function after taking this many "
+                   "instructions off the worklist (0 = no limit)"));
+
+static cl::opt<std::string>
+ReportFile("instcombine-report", cl::Hidden, cl::value_desc("filename"),
+           cl::desc("Write what combining each function took to the file, "
+                    "one JSON object per line ('-' for stderr)"));
 
 static cl::opt<bool> UnsafeFPShrink("enable-double-float-shrink", cl::Hidden,
                                    cl::init(false),
@@ -2632,6 +2659,89 @@ static bool AddReachableCodeToWorklist(BasicBlock *BB,
   return MadeIRChange;
 }
 
+namespace llvm {
+/// InstCombineReport - What combining one function took, for diagnosing
+/// functions that take InstCombine a long time.
+struct InstCombineReport {
+  unsigned Iterations;
+  unsigned Revisits;
+  unsigned DeadInsts;
+  unsigned ConstFolds;
+
+  /// Combines - The number of times visiting an instruction with each opcode
+  /// changed something.
+  unsigned Combines[Instruction::OtherOpsEnd];
+
+  /// Visited - The instructions visited so far, to count revisits.  A new
+  /// instruction allocated where an erased one was is counted as a revisit.
+  DenseSet<const Instruction *> Visited;
+
+  InstCombineReport() : Iterations(0), Revisits(0), DeadInsts(0),
+                        ConstFolds(0) {
+    std::fill(Combines, Combines + Instruction::OtherOpsEnd, 0);
+  }
+
+  void print(raw_ostream &OS, const Function &F, unsigned NumVisits,
+             bool OverBudget) const;
+};
+}
+
+/// printJSONString - Print S as a JSON string literal.
+static void printJSONString(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (StringRef::iterator I = S.begin(), E = S.end(); I != E; ++I) {
+    unsigned char C = *I;
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+void InstCombineReport::print(raw_ostream &OS, const Function &F,
+                              unsigned NumVisits, bool OverBudget) const {
+  OS << "{\"function\": ";
+  printJSONString(OS, F.getName());
+  OS << ", \"iterations\": " << Iterations << ", \"visits\": " << NumVisits
+     << ", \"revisits\": " << Revisits << ", \"dead\": " << DeadInsts
+     << ", \"constfolds\": " << ConstFolds << ", \"overbudget\": "
+     << (OverBudget ? "true" : "false") << ", \"combines\": {";
+  bool First = true;
+  for (unsigned Opc = 0; Opc != Instruction::OtherOpsEnd; ++Opc) {
+    if (!Combines[Opc])
+      continue;
+    OS << (First ? "" : ", ") << '"' << Instruction::getOpcodeName(Opc)
+       << "\": " << Combines[Opc];
+    First = false;
+  }
+  OS << "}}\n";
+}
+
+/// The file named by -instcombine-report.  It is owned here so that it is
+/// closed at llvm_shutdown.
+static ManagedStatic<std::unique_ptr<raw_fd_ostream> > ReportFileStream;
+
+/// getReportStream - Return the stream for -instcombine-report, opening it
+/// the first time it is needed.
+static raw_ostream &getReportStream() {
+  if (ReportFile == "-")
+    return errs();
+
+  std::unique_ptr<raw_fd_ostream> &OS = *ReportFileStream;
+  if (OS)
+    return *OS;
+
+  std::string Error;
+  OS.reset(new raw_fd_ostream(ReportFile.c_str(), Error, sys::fs::F_Text));
+  if (!Error.empty())
+    report_fatal_error("can't open -instcombine-report file '" + ReportFile +
+                       "': " + Error);
+  return *OS;
+}
+
 bool InstCombiner::DoOneIteration(Function &F, unsigned Iteration) {
   MadeIRChange = false;
 
@@ -2678,11 +2788,27 @@ bool InstCombiner::DoOneIteration(Function &F, unsigned Iteration) {
     Instruction *I = Worklist.RemoveOne();
     if (I == nullptr) continue;  // skip null values.
 
+    // Leave the rest of the worklist alone once the function has used up its
+    // budget of visits.
+    if (MaxVisits && NumVisits == MaxVisits) {
+      DEBUG(dbgs() << "IC: Out of visits in " << F.getName() << '\n');
+      while (!Worklist.isEmpty())
+        Worklist.RemoveOne();
+      OverBudget = true;
+      break;
+    }
+    ++NumVisits;
+    ++NumVisited;
+    if (Report && !Report->Visited.insert(I).second)
+      ++Report->Revisits;
+
     // Check to see if we can DCE the instruction.
     if (isInstructionTriviallyDead(I, TLI)) {
       DEBUG(dbgs() << "IC: DCE: " << *I << '\n');
       EraseInstFromFunction(*I);
       ++NumDeadInst;
+      if (Report)
+        ++Report->DeadInsts;
       MadeIRChange = true;
       continue;
     }
@@ -2695,6 +2821,8 @@ bool InstCombiner::DoOneIteration(Function &F, unsigned Iteration) {
         // Add operands to the worklist.
         ReplaceInstUsesWith(*I, C);
         ++NumConstProp;
+        if (Report)
+          ++Report->ConstFolds;
         EraseInstFromFunction(*I);
         MadeIRChange = true;
         continue;
@@ -2740,8 +2868,11 @@ bool InstCombiner::DoOneIteration(Function &F, unsigned Iteration) {
     DEBUG(raw_string_ostream SS(OrigI); I->print(SS); OrigI = SS.str(););
     DEBUG(dbgs() << "IC: Visiting: " << OrigI << '\n');
 
+    unsigned Opcode = I->getOpcode();
     if (Instruction *Result = visit(*I)) {
       ++NumCombined;
+      if (Report)
+        ++Report->Combines[Opcode];
       // Should we replace the old instruction with a new one?
       if (Result != I) {
         DEBUG(dbgs() << "IC: Old = " << *I << '\n'
@@ -2840,10 +2971,42 @@ bool InstCombiner::runOnFunction(Function &F) {
   // by instcombiner.
   EverMadeChange = LowerDbgDeclare(F);
 
-  // Iterate while there is work to do.
+  InstCombineReport TheReport;
+  if (!ReportFile.empty())
+    Report = &TheReport;
+  NumVisits = 0;
+  OverBudget = false;
+
+  // Iterate while there is work to do, and while the budget allows.
   unsigned Iteration = 0;
-  while (DoOneIteration(F, Iteration++))
+  while (DoOneIteration(F, Iteration++)) {
     EverMadeChange = true;
+    if (OverBudget)
+      break;
+    if (MaxIterations && Iteration == MaxIterations) {
+      DEBUG(dbgs() << "IC: Out of iterations in " << F.getName() << '\n');
+      OverBudget = true;
+      break;
+    }
+  }
+
+  if (OverBudget) {
+    ++NumOverBudget;
+    emitOptimizationRemarkAnalysis(
+        F.getContext(), DEBUG_TYPE, F, DebugLoc(),
+        "function left partly combined: it used up its budget after " +
+            Twine(Iteration) + " iterations and " + Twine(NumVisits) +
+            " instruction visits");
+  }
+
+  if (Report) {
+    TheReport.Iterations = Iteration;
+    raw_ostream &OS = getReportStream();
+    TheReport.print(OS, F, NumVisits, OverBudget);
+    // Tools that never call llvm_shutdown still get a complete report.
+    OS.flush();
+    Report = nullptr;
+  }
 
   Builder = nullptr;
   return EverMadeChange;
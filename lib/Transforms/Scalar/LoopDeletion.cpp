@@ -186,6 +186,7 @@ bool LoopDeletion::runOnLoop(Loop *L, LPPassManager &LPM) {
   // deleting the loop so that ScalarEvolution can look at the loop
   // to determine what it needs to clean up.
   SE.forgetLoop(L);
+  SE.forgetValuesAtScope(L);
 
   // Connect the preheader directly to the exit block.
   TerminatorInst *TI = preheader->getTerminator();
@@ -950,7 +950,7 @@ class SROA : public FunctionPass {
   SetVector<AllocaInst *, SmallVector<AllocaInst *, 16> > PostPromotionWorklist;
 
   /// \brief A collection of alloca instructions we can directly promote.
-  std::vector<AllocaInst *> PromotableAllocas;
+  SetVector<AllocaInst *, SmallVector<AllocaInst *, 16> > PromotableAllocas;
 
   /// \brief A worklist of PHIs to speculate prior to promoting allocas.
   ///
@@ -3225,7 +3225,7 @@ bool SROA::rewritePartition(AllocaInst &AI, AllocaSlices &S,
   if (Promotable) {
     if (PHIUsers.empty() && SelectUsers.empty()) {
       // Promote the alloca.
-      PromotableAllocas.push_back(NewAI);
+      PromotableAllocas.insert(NewAI);
     } else {
       // If we have either PHIs or Selects to speculate, add them to those
       // worklists and re-queue the new alloca so that we promote in on the
@@ -3537,7 +3537,7 @@ bool SROA::promoteAllocas(Function &F) {
 
   if (DT && !ForceSSAUpdater) {
     DEBUG(dbgs() << "Promoting allocas with mem2reg...\n");
-    PromoteMemToReg(PromotableAllocas, *DT);
+    PromoteMemToReg(PromotableAllocas.getArrayRef(), *DT);
     PromotableAllocas.clear();
     return true;
   }
@@ -3637,19 +3637,16 @@ bool SROA::runOnFunction(Function &F) {
       deleteDeadInstructions(DeletedAllocas);
 
       // Remove the deleted allocas from various lists so that we don't try to
-      // continue processing them.
-      if (!DeletedAllocas.empty()) {
-        auto IsInSet = [&](AllocaInst *AI) {
-          return DeletedAllocas.count(AI);
-        };
-        Worklist.remove_if(IsInSet);
-        PostPromotionWorklist.remove_if(IsInSet);
-        PromotableAllocas.erase(std::remove_if(PromotableAllocas.begin(),
-                                               PromotableAllocas.end(),
-                                               IsInSet),
-                                PromotableAllocas.end());
-        DeletedAllocas.clear();
+      // continue processing them.  Nearly every split deletes the alloca it
+      // split, which is rarely still queued anywhere, so look each deleted
+      // alloca up instead of filtering the lists: they can hold thousands of
+      // allocas.
+      for (AllocaInst *AI : DeletedAllocas) {
+        Worklist.remove(AI);
+        PostPromotionWorklist.remove(AI);
+        PromotableAllocas.remove(AI);
       }
+      DeletedAllocas.clear();
     }
 
     Changed |= promoteAllocas(F);
@@ -215,8 +215,11 @@ bool llvm::UnrollLoop(Loop *L, unsigned Count, unsigned TripCount,
   // if not outright eliminated.
   if (PP) {
     ScalarEvolution *SE = PP->getAnalysisIfAvailable<ScalarEvolution>();
-    if (SE)
+    if (SE) {
       SE->forgetLoop(L);
+      if (CompletelyUnroll)
+        SE->forgetValuesAtScope(L);
+    }
   }
 
   // If we know the trip count, we know the multiple...
@@ -13,15 +13,25 @@
 // traversing the function in depth-first order to rewrite loads and stores as
 // appropriate.
 //
-// The algorithm used here is based on:
+// The dominance frontier of every block is computed once, the first time an
+// alloca needs PHI nodes, and shared by all of the allocas promoted together.
+// The iterated frontier of each alloca is then a walk over the frontiers of
+// its defining blocks, pruned with per-variable liveness information.  For
+// most functions this makes the cost of placing PHI nodes proportional to the
+// size of the frontiers that are walked, rather than to the size of the
+// dominator subtrees below the definitions, which matters for functions with
+// thousands of allocas.  The frontiers are computed as described in:
 //
-//   Sreedhar and Gao. A linear time algorithm for placing phi-nodes.
-//   In Proceedings of the 22nd ACM SIGPLAN-SIGACT Symposium on Principles of
-//   Programming Languages
-//   POPL '95. ACM, New York, NY, 62-73.
+//   Cooper, Harvey and Kennedy. A simple, fast dominance algorithm.
+//   Software Practice and Experience, 2001.
+//
+// The frontiers of all blocks together can be quadratic in the size of the
+// function, as in deeply nested loops.  When they grow beyond a few entries
+// per block, PHI nodes are placed with a walk of the dominator tree for each
+// alloca instead, which is linear in the size of the function:
 //
-// It has been modified to not explicitly use the DJ graph data structure and to
-// directly compute pruned SSA using per-variable liveness information.
+//   Sreedhar and Gao. A linear time algorithm for placing phi-nodes.
+//   POPL '95.
 //
 //===----------------------------------------------------------------------===//
 
@@ -45,6 +55,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Metadata.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Transforms/Utils/Local.h"
 #include <algorithm>
 #include <queue>
@@ -57,6 +68,14 @@ STATISTIC(NumSingleStore,   "Number of alloca's promoted with a single store");
 STATISTIC(NumDeadAlloca,    "Number of dead alloca's removed");
 STATISTIC(NumPHIInsert,     "Number of PHI nodes inserted");
 
+static cl::opt<unsigned>
+MaxFrontierEntriesPerBlock("mem2reg-max-frontier-entries", cl::init(8),
+                           cl::Hidden,
+                           cl::desc("Most dominance frontier entries per "
+                                    "block kept for placing PHI nodes; "
+                                    "beyond this the dominator tree is "
+                                    "walked for each alloca"));
+
 bool llvm::isAllocaPromotable(const AllocaInst *AI) {
   // FIXME: If the memory unit is of pointer or integer type, we can permit
   // assignments to subsections of the memory unit.
@@ -271,7 +290,12 @@ struct PromoteMem2Reg {
   /// behavior.
   DenseMap<BasicBlock *, unsigned> BBNumbers;
 
-  /// Maps DomTreeNodes to their level in the dominator tree.
+  /// The dominance frontier of each block, indexed by its number in
+  /// BBNumbers.  Unreachable blocks have an empty frontier.
+  std::vector<SmallVector<BasicBlock *, 2> > DomFrontiers;
+
+  /// Maps DomTreeNodes to their level in the dominator tree, when the
+  /// frontiers are too large to keep.
   DenseMap<DomTreeNode *, unsigned> DomLevels;
 
   /// Lazily compute the number of predecessors a block has.
@@ -299,11 +323,22 @@ private:
     return NP - 1;
   }
 
+  bool ComputeDominanceFrontiers(Function &F);
+  void ComputeDomLevels();
+  void ComputeIDFFromFrontiers(
+      const SmallPtrSet<BasicBlock *, 32> &DefBlocks,
+      const SmallPtrSet<BasicBlock *, 32> &LiveInBlocks,
+      SmallVectorImpl<std::pair<unsigned, BasicBlock *> > &DFBlocks);
+  void ComputeIDFFromDomTree(
+      const SmallPtrSet<BasicBlock *, 32> &DefBlocks,
+      const SmallPtrSet<BasicBlock *, 32> &LiveInBlocks,
+      SmallVectorImpl<std::pair<unsigned, BasicBlock *> > &DFBlocks);
   void DetermineInsertionPoint(AllocaInst *AI, unsigned AllocaNum,
-                               AllocaInfo &Info);
+                               AllocaInfo &Info, LargeBlockInfo &LBI);
   void ComputeLiveInBlocks(AllocaInst *AI, AllocaInfo &Info,
                            const SmallPtrSet<BasicBlock *, 32> &DefBlocks,
-                           SmallPtrSet<BasicBlock *, 32> &LiveInBlocks);
+                           SmallPtrSet<BasicBlock *, 32> &LiveInBlocks,
+                           LargeBlockInfo &LBI);
   void RenamePass(BasicBlock *BB, BasicBlock *Pred,
                   RenamePassData::ValVector &IncVals,
                   std::vector<RenamePassData> &Worklist);
@@ -572,25 +607,6 @@ void PromoteMem2Reg::run() {
       continue;
     }
 
-    // If we haven't computed dominator tree levels, do so now.
-    if (DomLevels.empty()) {
-      SmallVector<DomTreeNode *, 32> Worklist;
-
-      DomTreeNode *Root = DT.getRootNode();
-      DomLevels[Root] = 0;
-      Worklist.push_back(Root);
-
-      while (!Worklist.empty()) {
-        DomTreeNode *Node = Worklist.pop_back_val();
-        unsigned ChildLevel = DomLevels[Node] + 1;
-        for (DomTreeNode::iterator CI = Node->begin(), CE = Node->end();
-             CI != CE; ++CI) {
-          DomLevels[*CI] = ChildLevel;
-          Worklist.push_back(*CI);
-        }
-      }
-    }
-
     // If we haven't computed a numbering for the BB's in the function, do so
     // now.
     if (BBNumbers.empty()) {
@@ -599,6 +615,12 @@ void PromoteMem2Reg::run() {
         BBNumbers[I] = ID++;
     }
 
+    // If we haven't computed the dominance frontiers, do so now, or the
+    // dominator tree levels if the frontiers are too large.
+    if (DomFrontiers.empty() && DomLevels.empty() &&
+        !ComputeDominanceFrontiers(F))
+      ComputeDomLevels();
+
     // If we have an AST to keep updated, remember some pointer value that is
     // stored into the alloca.
     if (AST)
@@ -615,7 +637,7 @@ void PromoteMem2Reg::run() {
     // the standard SSA construction algorithm.  Determine which blocks need PHI
     // nodes and see if we can optimize out some work by avoiding insertion of
     // dead phi nodes.
-    DetermineInsertionPoint(AI, AllocaNum, Info);
+    DetermineInsertionPoint(AI, AllocaNum, Info, LBI);
   }
 
   if (Allocas.empty())
@@ -767,7 +789,7 @@ void PromoteMem2Reg::run() {
 void PromoteMem2Reg::ComputeLiveInBlocks(
     AllocaInst *AI, AllocaInfo &Info,
     const SmallPtrSet<BasicBlock *, 32> &DefBlocks,
-    SmallPtrSet<BasicBlock *, 32> &LiveInBlocks) {
+    SmallPtrSet<BasicBlock *, 32> &LiveInBlocks, LargeBlockInfo &LBI) {
 
   // To determine liveness, we must iterate through the predecessors of blocks
   // where the def is live.  Blocks are added to the worklist if we need to
@@ -775,6 +797,20 @@ void PromoteMem2Reg::ComputeLiveInBlocks(
   SmallVector<BasicBlock *, 64> LiveInBlockWorklist(Info.UsingBlocks.begin(),
                                                     Info.UsingBlocks.end());
 
+  // Find the first reference to the alloca in each defining block.  The
+  // references are ordered by their cached index in the block rather than by
+  // scanning the block, which may hold the loads and stores of thousands of
+  // other allocas.
+  SmallDenseMap<BasicBlock *, Instruction *, 16> FirstReference;
+  for (User *U : AI->users()) {
+    Instruction *I = cast<Instruction>(U);
+    if (!DefBlocks.count(I->getParent()))
+      continue;
+    Instruction *&First = FirstReference[I->getParent()];
+    if (!First || LBI.getInstructionIndex(I) < LBI.getInstructionIndex(First))
+      First = I;
+  }
+
   // If any of the using blocks is also a definition block, check to see if the
   // definition occurs before or after the use.  If it happens before the use,
   // the value isn't really live-in.
@@ -785,27 +821,10 @@ void PromoteMem2Reg::ComputeLiveInBlocks(
 
     // Okay, this is a block that both uses and defines the value.  If the first
     // reference to the alloca is a def (store), then we know it isn't live-in.
-    for (BasicBlock::iterator I = BB->begin();; ++I) {
-      if (StoreInst *SI = dyn_cast<StoreInst>(I)) {
-        if (SI->getOperand(1) != AI)
-          continue;
-
-        // We found a store to the alloca before a load.  The alloca is not
-        // actually live-in here.
-        LiveInBlockWorklist[i] = LiveInBlockWorklist.back();
-        LiveInBlockWorklist.pop_back();
-        --i, --e;
-        break;
-      }
-
-      if (LoadInst *LI = dyn_cast<LoadInst>(I)) {
-        if (LI->getOperand(0) != AI)
-          continue;
-
-        // Okay, we found a load before a store to the alloca.  It is actually
-        // live into this block.
-        break;
-      }
+    if (isa<StoreInst>(FirstReference.lookup(BB))) {
+      LiveInBlockWorklist[i] = LiveInBlockWorklist.back();
+      LiveInBlockWorklist.pop_back();
+      --i, --e;
     }
   }
 
@@ -835,12 +854,71 @@ void PromoteMem2Reg::ComputeLiveInBlocks(
   }
 }
 
+/// \brief Compute the dominance frontier of every reachable block.
+///
+/// A block is in the frontier of each of its predecessors, and of their
+/// dominators up to, but not including, its own immediate dominator.
+/// Returns false, leaving no frontiers, if they would hold more than
+/// MaxFrontierEntriesPerBlock entries per block.
+bool PromoteMem2Reg::ComputeDominanceFrontiers(Function &F) {
+  DomFrontiers.resize(BBNumbers.size());
+  uint64_t MaxEntries = uint64_t(MaxFrontierEntriesPerBlock) * BBNumbers.size();
+  uint64_t NumEntries = 0;
+
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    DomTreeNode *Node = DT.getNode(BB);
+    if (!Node)
+      continue;
+    DomTreeNode *IDom = Node->getIDom();
+
+    for (pred_iterator PI = pred_begin(BB), PE = pred_end(BB); PI != PE;
+         ++PI) {
+      for (DomTreeNode *Runner = DT.getNode(*PI); Runner && Runner != IDom;
+           Runner = Runner->getIDom()) {
+        SmallVectorImpl<BasicBlock *> &DF =
+            DomFrontiers[BBNumbers[Runner->getBlock()]];
+
+        // If BB was already added here through another predecessor, so was
+        // it to every dominator above.
+        if (!DF.empty() && DF.back() == BB)
+          break;
+        DF.push_back(BB);
+        if (++NumEntries > MaxEntries) {
+          DomFrontiers.clear();
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/// \brief Compute the level of every node in the dominator tree.
+void PromoteMem2Reg::ComputeDomLevels() {
+  SmallVector<DomTreeNode *, 32> Worklist;
+
+  DomTreeNode *Root = DT.getRootNode();
+  DomLevels[Root] = 0;
+  Worklist.push_back(Root);
+
+  while (!Worklist.empty()) {
+    DomTreeNode *Node = Worklist.pop_back_val();
+    unsigned ChildLevel = DomLevels[Node] + 1;
+    for (DomTreeNode::iterator CI = Node->begin(), CE = Node->end(); CI != CE;
+         ++CI) {
+      DomLevels[*CI] = ChildLevel;
+      Worklist.push_back(*CI);
+    }
+  }
+}
+
 /// At this point, we're committed to promoting the alloca using IDF's, and the
 /// standard SSA construction algorithm.  Determine which blocks need phi nodes
 /// and see if we can optimize out some work by avoiding insertion of dead phi
 /// nodes.
 void PromoteMem2Reg::DetermineInsertionPoint(AllocaInst *AI, unsigned AllocaNum,
-                                             AllocaInfo &Info) {
+                                             AllocaInfo &Info,
+                                             LargeBlockInfo &LBI) {
   // Unique the set of defining blocks for efficient lookup.
   SmallPtrSet<BasicBlock *, 32> DefBlocks;
   DefBlocks.insert(Info.DefiningBlocks.begin(), Info.DefiningBlocks.end());
@@ -848,8 +926,61 @@ void PromoteMem2Reg::DetermineInsertionPoint(AllocaInst *AI, unsigned AllocaNum,
   // Determine which blocks the value is live in.  These are blocks which lead
   // to uses.
   SmallPtrSet<BasicBlock *, 32> LiveInBlocks;
-  ComputeLiveInBlocks(AI, Info, DefBlocks, LiveInBlocks);
+  ComputeLiveInBlocks(AI, Info, DefBlocks, LiveInBlocks, LBI);
 
+  // Find the blocks in the iterated dominance frontier of the definitions
+  // that the value is live into; those get a phi node.
+  SmallVector<std::pair<unsigned, BasicBlock *>, 32> DFBlocks;
+  if (DomLevels.empty())
+    ComputeIDFFromFrontiers(DefBlocks, LiveInBlocks, DFBlocks);
+  else
+    ComputeIDFFromDomTree(DefBlocks, LiveInBlocks, DFBlocks);
+
+  if (DFBlocks.size() > 1)
+    std::sort(DFBlocks.begin(), DFBlocks.end());
+
+  unsigned CurrentVersion = 0;
+  for (unsigned i = 0, e = DFBlocks.size(); i != e; ++i)
+    QueuePhiNode(DFBlocks[i].second, AllocaNum, CurrentVersion);
+}
+
+/// \brief Collect in DFBlocks the blocks of the iterated dominance frontier
+/// of DefBlocks that are in LiveInBlocks, using the frontier of each block.
+void PromoteMem2Reg::ComputeIDFFromFrontiers(
+    const SmallPtrSet<BasicBlock *, 32> &DefBlocks,
+    const SmallPtrSet<BasicBlock *, 32> &LiveInBlocks,
+    SmallVectorImpl<std::pair<unsigned, BasicBlock *> > &DFBlocks) {
+  // Walk the dominance frontiers starting from the defining blocks.  A block
+  // that gets a phi node defines the value too, so its frontier is walked in
+  // turn.  Blocks the value is not live into get no phi node, and neither do
+  // the blocks reached only through them.
+  SmallVector<BasicBlock *, 32> Worklist(DefBlocks.begin(), DefBlocks.end());
+  SmallPtrSet<BasicBlock *, 32> Visited;
+  while (!Worklist.empty()) {
+    BasicBlock *BB = Worklist.pop_back_val();
+    const SmallVectorImpl<BasicBlock *> &DF = DomFrontiers[BBNumbers[BB]];
+
+    for (unsigned i = 0, e = DF.size(); i != e; ++i) {
+      BasicBlock *FrontierBB = DF[i];
+      if (!Visited.insert(FrontierBB))
+        continue;
+
+      if (!LiveInBlocks.count(FrontierBB))
+        continue;
+
+      DFBlocks.push_back(std::make_pair(BBNumbers[FrontierBB], FrontierBB));
+      if (!DefBlocks.count(FrontierBB))
+        Worklist.push_back(FrontierBB);
+    }
+  }
+}
+
+/// \brief Collect in DFBlocks the blocks of the iterated dominance frontier
+/// of DefBlocks that are in LiveInBlocks, by walking the dominator tree.
+void PromoteMem2Reg::ComputeIDFFromDomTree(
+    const SmallPtrSet<BasicBlock *, 32> &DefBlocks,
+    const SmallPtrSet<BasicBlock *, 32> &LiveInBlocks,
+    SmallVectorImpl<std::pair<unsigned, BasicBlock *> > &DFBlocks) {
   // Use a priority queue keyed on dominator tree level so that inserted nodes
   // are handled from the bottom of the dominator tree upwards.
   typedef std::pair<DomTreeNode *, unsigned> DomTreeNodePair;
@@ -864,7 +995,6 @@ void PromoteMem2Reg::DetermineInsertionPoint(AllocaInst *AI, unsigned AllocaNum,
       PQ.push(std::make_pair(Node, DomLevels[Node]));
   }
 
-  SmallVector<std::pair<unsigned, BasicBlock *>, 32> DFBlocks;
   SmallPtrSet<DomTreeNode *, 32> Visited;
   SmallVector<DomTreeNode *, 32> Worklist;
   while (!PQ.empty()) {
@@ -917,13 +1047,6 @@ void PromoteMem2Reg::DetermineInsertionPoint(AllocaInst *AI, unsigned AllocaNum,
       }
     }
   }
-
-  if (DFBlocks.size() > 1)
-    std::sort(DFBlocks.begin(), DFBlocks.end());
-
-  unsigned CurrentVersion = 0;
-  for (unsigned i = 0, e = DFBlocks.size(); i != e; ++i)
-    QueuePhiNode(DFBlocks[i].second, AllocaNum, CurrentVersion);
 }
 
 /// \brief Queue a phi-node to be added to a basic-block for a specific Alloca.
@@ -101,6 +101,9 @@ using namespace llvm::PatternMatch;
 
 STATISTIC(LoopsVectorized, "Number of loops vectorized");
 STATISTIC(LoopsAnalyzed, "Number of loops analyzed for vectorization");
+STATISTIC(InterleaveGroupsVectorized,
+          "Number of interleaved access groups vectorized");
+STATISTIC(EpiloguesVectorized, "Number of loop remainders vectorized");
 
 static cl::opt<unsigned>
 VectorizationFactor("force-vector-width", cl::init(0), cl::Hidden,
@@ -138,12 +141,54 @@ static cl::opt<bool> EnableMemAccessVersioning(
     "enable-mem-access-versioning", cl::init(true), cl::Hidden,
     cl::desc("Enable symblic stride memory access versioning"));
 
+/// This enables vectorizing groups of strided loads or stores that together
+/// cover every element of a range, such as the fields of an array of structs,
+///   for (i = 0; i < N; ++i) {
+///     A[2 * i] = X[i];
+///     A[2 * i + 1] = Y[i];
+///   }
+/// with one wide access and shuffles instead of scalarizing each of them.
+/// Also lets the dependence checker treat such accesses as independent.
+/// Off by default until the cost tables are checked against measurements.
+static cl::opt<bool> EnableInterleavedMemAccesses(
+    "enable-interleaved-mem-accesses", cl::init(false), cl::Hidden,
+    cl::desc("Enable vectorizing interleaved memory access groups"));
+
+/// Maximum stride, in elements, of an interleaved access group.
+static const unsigned MaxInterleaveFactor = 8;
+
+/// This enables vectorizing the scalar remainder of a vectorized loop once
+/// more, at a narrower width. A loop vectorized with 16 elements per iteration
+/// otherwise spends up to 15 iterations in scalar code, which dominates loops
+/// with short trip counts. It is off by default because it duplicates the
+/// runtime checks and grows the code of every wide loop.
+static cl::opt<bool> EnableEpilogueVectorization(
+    "enable-epilogue-vectorization", cl::init(false), cl::Hidden,
+    cl::desc("Enable vectorizing the remainder of vectorized loops"));
+
+static cl::opt<unsigned> EpilogueVectorizationMinVF(
+    "epilogue-vectorization-min-vf", cl::init(16), cl::Hidden,
+    cl::desc("Only vectorize the remainder of loops whose vector body "
+             "handles at least this many iterations"));
+
 /// We don't unroll loops with a known constant trip count below this number.
 static const unsigned TinyTripCountUnrollThreshold = 128;
 
 /// When performing memory disambiguation checks at runtime do not make more
-/// than this number of comparisons.
-static const unsigned RuntimeMemoryCheckThreshold = 8;
+/// than this number of comparisons. A loop writing through one pointer and
+/// reading through N others needs N comparisons, so this admits kernels with
+/// up to 17 pointer arguments.
+static cl::opt<unsigned> RuntimeMemoryCheckThreshold(
+    "runtime-memory-check-threshold", cl::init(16), cl::Hidden,
+    cl::desc("The maximum number of runtime pointer range comparisons "
+             "inserted to vectorize a loop"));
+
+/// The same limit for loops that a pragma asks to vectorize.
+static cl::opt<unsigned> PragmaVectorizeMemoryCheckThreshold(
+    "pragma-vectorize-memory-check-threshold", cl::init(128), cl::Hidden,
+    cl::desc("The maximum number of runtime pointer range comparisons "
+             "inserted to vectorize a loop with vectorization forced by a "
+             "pragma"));
 
 /// Maximum simd width.
 static const unsigned MaxVectorWidth = 64;
@@ -339,6 +384,11 @@ protected:
   /// Vectorize Load and Store instructions,
   virtual void vectorizeMemoryInstruction(Instruction *Instr);
 
+  /// Vectorize a member of an interleaved access group. The wide access and
+  /// the shuffles for the whole group are emitted at its insert position;
+  /// nothing is emitted for the other members.
+  void vectorizeInterleaveGroup(Instruction *Instr);
+
   /// Create a broadcast instruction. This method generates a broadcast
   /// instruction (shuffle) for loop invariant values and for the induction
   /// value. If this is the induction variable then we extend it to N, N+1, ...
@@ -539,10 +589,11 @@ public:
 
   LoopVectorizationLegality(Loop *L, ScalarEvolution *SE, const DataLayout *DL,
                             DominatorTree *DT, TargetLibraryInfo *TLI,
-                            Function *F)
+                            Function *F, unsigned MaxRuntimeChecks)
       : NumLoads(0), NumStores(0), NumPredStores(0), TheLoop(L), SE(SE), DL(DL),
-        DT(DT), TLI(TLI), TheFunction(F), Induction(nullptr),
-        WidestIndTy(nullptr), HasFunNoNaNAttr(false), MaxSafeDepDistBytes(-1U) {
+        DT(DT), TLI(TLI), TheFunction(F), MaxRuntimeChecks(MaxRuntimeChecks),
+        Induction(nullptr), WidestIndTy(nullptr), HasFunNoNaNAttr(false),
+        MaxSafeDepDistBytes(-1U) {
   }
 
   /// This enum represents the kinds of reductions that we support.
@@ -621,6 +672,22 @@ public:
   struct RuntimePointerCheck {
     RuntimePointerCheck() : Need(false) {}
 
+    /// \brief A set of pointers that are checked against the other pointers
+    /// as one range, from the lowest start to the highest end among them.
+    struct CheckingPtrGroup {
+      CheckingPtrGroup(unsigned Index, const RuntimePointerCheck &RtCheck)
+          : Low(RtCheck.Starts[Index]), High(RtCheck.Ends[Index]) {
+        Members.push_back(Index);
+      }
+
+      /// The lowest start of the members.
+      const SCEV *Low;
+      /// The highest end of the members.
+      const SCEV *High;
+      /// The indices of the members in Pointers.
+      SmallVector<unsigned, 2> Members;
+    };
+
     /// Reset the state of the pointer runtime information.
     void reset() {
       Need = false;
@@ -629,12 +696,33 @@ public:
       Ends.clear();
       IsWritePtr.clear();
       DependencySetId.clear();
+      CheckingGroups.clear();
     }
 
     /// Insert a pointer and calculate the start and end SCEVs.
     void insert(ScalarEvolution *SE, Loop *Lp, Value *Ptr, bool WritePtr,
                 unsigned DepSetId, ValueToValueMap &Strides);
 
+    /// \brief Partition the pointers into CheckingGroups.
+    ///
+    /// Pointers that never need to be checked against each other and whose
+    /// bounds are a constant distance apart, such as A[i], A[i+1] and A[i+2],
+    /// share a group, so the number of checks grows with the number of
+    /// arrays rather than with the number of accesses.
+    void groupChecks(ScalarEvolution *SE);
+
+    /// Returns true if the pointers at \p I and \p J need to be checked
+    /// against each other.
+    bool needsChecking(unsigned I, unsigned J) const;
+
+    /// Returns true if any pointer of \p M needs to be checked against any
+    /// pointer of \p N.
+    bool needsChecking(const CheckingPtrGroup &M,
+                       const CheckingPtrGroup &N) const;
+
+    /// Returns the number of range comparisons between the groups.
+    unsigned getNumberOfChecks() const;
+
     /// This flag indicates if we need to add the runtime check.
     bool Need;
     /// Holds the pointers that we need to check.
@@ -648,6 +736,8 @@ public:
     /// Holds the id of the set of pointers that could be dependent because of a
     /// shared underlying object.
     SmallVector<unsigned, 2> DependencySetId;
+    /// Holds the groups the pointers are checked in.
+    SmallVector<CheckingPtrGroup, 2> CheckingGroups;
   };
 
   /// A struct for saving information about induction variables.
@@ -660,6 +750,40 @@ public:
     InductionKind IK;
   };
 
+  /// \brief A group of loads or stores whose pointers advance by the same
+  /// constant stride of several elements and start at different offsets
+  /// within it, such as the fields of an array of structs:
+  ///   for (i = 0; i < N; ++i) {
+  ///     R = A[3 * i]; G = A[3 * i + 1]; B = A[3 * i + 2];
+  ///     ...
+  ///   }
+  /// The group is vectorized as one wide access that covers 'Factor'
+  /// consecutive elements per iteration, plus shuffles.
+  struct InterleaveGroup {
+    InterleaveGroup() : Factor(0), Align(0), InsertPos(nullptr) {}
+
+    /// The stride of the members in elements.
+    unsigned Factor;
+    /// The alignment of the member at index 0.
+    unsigned Align;
+    /// The members indexed by their offset from the start of the group. A
+    /// load group may have gaps, which are null.
+    SmallVector<Instruction *, 4> Members;
+    /// The member at whose position the wide access is emitted: the first
+    /// load or the last store of the group in program order.
+    Instruction *InsertPos;
+
+    Instruction *getMember(unsigned Index) const { return Members[Index]; }
+
+    /// Returns the offset of the member \p I from the start of the group.
+    unsigned getIndex(const Instruction *I) const {
+      for (unsigned i = 0; i < Factor; ++i)
+        if (Members[i] == I)
+          return i;
+      llvm_unreachable("Not a member of this interleave group");
+    }
+  };
+
   /// ReductionList contains the reduction descriptors for all
   /// of the reductions that were found in the loop.
   typedef DenseMap<PHINode*, ReductionDescriptor> ReductionList;
@@ -711,6 +835,18 @@ public:
   /// Returns the information that we collected about runtime memory check.
   RuntimePointerCheck *getRuntimePointerCheck() { return &PtrRtCheck; }
 
+  /// Returns the interleaved access group that \p I is a member of, or null.
+  const InterleaveGroup *getInterleaveGroup(Instruction *I) const {
+    DenseMap<Instruction *, unsigned>::const_iterator It =
+        InterleaveGroupIdx.find(I);
+    if (It == InterleaveGroupIdx.end())
+      return nullptr;
+    return &InterleaveGroups[It->second];
+  }
+
+  /// Returns true if the loop has interleaved access groups.
+  bool hasInterleaveGroups() const { return !InterleaveGroups.empty(); }
+
   /// This function returns the identity element (or neutral element) for
   /// the operation K.
   static Constant *getReductionIdentity(ReductionKind K, Type *Tp);
@@ -743,6 +879,14 @@ private:
   /// Collect the variables that need to stay uniform after vectorization.
   void collectLoopUniforms();
 
+  /// Find the groups of interleaved loads and stores that can be vectorized
+  /// with wide accesses and shuffles.
+  void analyzeInterleaving();
+
+  /// Returns the stride, in elements, of the load or store \p I if it can be
+  /// a member of an interleaved access group, and zero otherwise.
+  unsigned getInterleaveFactor(Instruction *I);
+
   /// Return true if all of the instructions in the block can be speculatively
   /// executed. \p SafePtrs is a list of addresses that are known to be legal
   /// and we know that we can read from them without segfault.
@@ -794,6 +938,8 @@ private:
   TargetLibraryInfo *TLI;
   /// Parent function
   Function *TheFunction;
+  /// The maximum number of runtime pointer comparisons.
+  unsigned MaxRuntimeChecks;
 
   //  ---  vectorization state --- //
 
@@ -825,6 +971,11 @@ private:
 
   ValueToValueMap Strides;
   SmallPtrSet<Value *, 8> StrideSet;
+
+  /// Holds the interleaved access groups found in the loop and maps each of
+  /// their members to its group.
+  SmallVector<InterleaveGroup, 4> InterleaveGroups;
+  DenseMap<Instruction *, unsigned> InterleaveGroupIdx;
 };
 
 /// LoopVectorizationCostModel - estimates the expected speedups due to
@@ -855,6 +1006,11 @@ public:
                                                 unsigned UserVF,
                                                 bool ForceVectorization);
 
+  /// \return The most profitable vectorization factor for the remainder of
+  /// the loop once it is vectorized with width \p VF and unroll factor
+  /// \p UF, or 1 if the remainder is best left scalar.
+  unsigned selectEpilogueVectorizationFactor(unsigned VF, unsigned UF);
+
   /// \return The size (in bits) of the widest type in the code that
   /// needs to be vectorized. We ignore values that remain scalar such as
   /// 64 bit loop indices.
@@ -902,6 +1058,17 @@ private:
   /// as a vector operation.
   bool isConsecutiveLoadOrStore(Instruction *I);
 
+  /// Report an analysis message to assist the user in diagnosing loops that are
+  /// not vectorized.
+  void emitAnalysis(Report &Message) {
+    Function *F = TheLoop->getHeader()->getParent();
+    DebugLoc DL = TheLoop->getStartLoc();
+    if (Instruction *I = Message.getInstr())
+      DL = I->getDebugLoc();
+    emitOptimizationRemarkAnalysis(F->getContext(), DEBUG_TYPE, *F, DL,
+                                   Message.str());
+  }
+
   /// The loop that we evaluate.
   Loop *TheLoop;
   /// Scev analysis.
@@ -1232,13 +1399,21 @@ struct LoopVectorize : public FunctionPass {
         DEBUG(dbgs() << "\n");
         emitOptimizationRemarkAnalysis(
             F->getContext(), DEBUG_TYPE, *F, L->getStartLoc(),
-            "vectorization is not beneficial and is not explicitly forced");
+            Report() << "the trip count of " << TC << " is below the "
+                     << "vectorization threshold of "
+                     << TinyTripCountVectorThreshold);
         return false;
       }
     }
 
+    // Allow more runtime checks for loops that a pragma asks to vectorize.
+    unsigned MaxRuntimeChecks =
+        Hints.getForce() == LoopVectorizeHints::FK_Enabled
+            ? PragmaVectorizeMemoryCheckThreshold
+            : RuntimeMemoryCheckThreshold;
+
     // Check if it is legal to vectorize the loop.
-    LoopVectorizationLegality LVL(L, SE, DL, DT, TLI, F);
+    LoopVectorizationLegality LVL(L, SE, DL, DT, TLI, F, MaxRuntimeChecks);
     if (!LVL.canVectorize()) {
       DEBUG(dbgs() << "LV: Not vectorizing: Cannot prove legality.\n");
       emitOptimizationRemarkMissed(F->getContext(), DEBUG_TYPE, *F,
@@ -1301,7 +1476,10 @@ struct LoopVectorize : public FunctionPass {
       if (UF == 1) {
         emitOptimizationRemarkAnalysis(
             F->getContext(), DEBUG_TYPE, *F, L->getStartLoc(),
-            "not beneficial to vectorize and user disabled interleaving");
+            Report() << "the cost model found vectorization not beneficial"
+                     << (Hints.getUnroll() == 1
+                             ? " and interleaving is disabled"
+                             : " and interleaving not profitable"));
         return false;
       }
       DEBUG(dbgs() << "LV: Trying to at least unroll the loops.\n");
@@ -1317,6 +1495,12 @@ struct LoopVectorize : public FunctionPass {
       InnerLoopUnroller Unroller(L, SE, LI, DT, DL, TLI, UF);
       Unroller.vectorize(&LVL);
     } else {
+      // Decide on the remainder while the cost model still describes the
+      // original loop. A width chosen by the user applies to the whole loop.
+      unsigned EpilogueVF = 1;
+      if (EnableEpilogueVectorization && !OptForSize && !Hints.getWidth())
+        EpilogueVF = CM.selectEpilogueVectorizationFactor(VF.Width, UF);
+
       // If we decided that it is *legal* to vectorize the loop then do it.
       InnerLoopVectorizer LB(L, SE, LI, DT, DL, TLI, VF.Width, UF);
       LB.vectorize(&LVL);
@@ -1327,6 +1511,9 @@ struct LoopVectorize : public FunctionPass {
           F->getContext(), DEBUG_TYPE, *F, L->getStartLoc(),
           Twine("vectorized loop (vectorization factor: ") + Twine(VF.Width) +
               ", unrolling interleave factor: " + Twine(UF) + ")");
+
+      if (EpilogueVF > 1)
+        vectorizeEpilogue(L, EpilogueVF, MaxRuntimeChecks);
     }
 
     // Mark the loop as already vectorized to avoid vectorizing again.
@@ -1336,6 +1523,63 @@ struct LoopVectorize : public FunctionPass {
     return true;
   }
 
+  /// \brief Vectorize \p L, the scalar remainder of a loop that was just
+  /// vectorized, with width \p VF.
+  ///
+  /// The remainder is a loop like any other, except that it shares its exit
+  /// block with the vector loop's middle block. It runs when the vector loop
+  /// leaves iterations over, and also when the vector loop is skipped because
+  /// the trip count is small.
+  void vectorizeEpilogue(Loop *L, unsigned VF, unsigned MaxRuntimeChecks) {
+    DEBUG(dbgs() << "LV: Vectorizing the remainder with VF " << VF << ".\n");
+    formDedicatedExitBlock(L);
+
+    Function *F = L->getHeader()->getParent();
+    LoopVectorizationLegality LVL(L, SE, DL, DT, TLI, F, MaxRuntimeChecks);
+    if (!LVL.canVectorize()) {
+      DEBUG(dbgs() << "LV: Can't vectorize the remainder.\n");
+      return;
+    }
+
+    InnerLoopVectorizer LB(L, SE, LI, DT, DL, TLI, VF, 1);
+    LB.vectorize(&LVL);
+    ++EpiloguesVectorized;
+
+    emitOptimizationRemark(F->getContext(), DEBUG_TYPE, *F, L->getStartLoc(),
+                           Twine("vectorized loop remainder (vectorization "
+                                 "factor: ") + Twine(VF) + ")");
+  }
+
+  /// \brief Give \p L an exit block that only \p L branches to, and move the
+  /// LCSSA phis for the values that leave \p L into it.
+  void formDedicatedExitBlock(Loop *L) {
+    BasicBlock *Exiting = L->getExitingBlock();
+    BasicBlock *Exit = L->getExitBlock();
+    assert(Exiting && Exit && "Expected a single exit");
+    if (Exit->getSinglePredecessor())
+      return;
+
+    BasicBlock *NewExit = BasicBlock::Create(Exit->getContext(), "scalar.exit",
+                                             Exit->getParent(), Exit);
+    BranchInst::Create(Exit, NewExit);
+    Exiting->getTerminator()->replaceUsesOfWith(Exit, NewExit);
+
+    for (BasicBlock::iterator I = Exit->begin(); isa<PHINode>(I); ++I) {
+      PHINode *PN = cast<PHINode>(I);
+      int Idx = PN->getBasicBlockIndex(Exiting);
+      PHINode *LCSSAPhi = PHINode::Create(PN->getType(), 1,
+                                          PN->getName() + ".lcssa",
+                                          NewExit->getTerminator());
+      LCSSAPhi->addIncoming(PN->getIncomingValue(Idx), Exiting);
+      PN->setIncomingValue(Idx, LCSSAPhi);
+      PN->setIncomingBlock(Idx, NewExit);
+    }
+
+    if (Loop *ParentLoop = L->getParentLoop())
+      ParentLoop->addBasicBlockToLoop(NewExit, LI->getBase());
+    DT->addNewBlock(NewExit, Exiting);
+  }
+
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.addRequiredID(LoopSimplifyID);
     AU.addRequiredID(LCSSAID);
@@ -1407,14 +1651,104 @@ void LoopVectorizationLegality::RuntimePointerCheck::insert(
   const SCEVAddRecExpr *AR = dyn_cast<SCEVAddRecExpr>(Sc);
   assert(AR && "Invalid addrec expression");
   const SCEV *Ex = SE->getBackedgeTakenCount(Lp);
+  const SCEV *ScStart = AR->getStart();
   const SCEV *ScEnd = AR->evaluateAtIteration(Ex, *SE);
+
+  // A pointer that walks down the address space starts at the top of its
+  // range.
+  if (const SCEVConstant *Step =
+          dyn_cast<SCEVConstant>(AR->getStepRecurrence(*SE)))
+    if (Step->getValue()->isNegative())
+      std::swap(ScStart, ScEnd);
+
   Pointers.push_back(Ptr);
-  Starts.push_back(AR->getStart());
+  Starts.push_back(ScStart);
   Ends.push_back(ScEnd);
   IsWritePtr.push_back(WritePtr);
   DependencySetId.push_back(DepSetId);
 }
 
+bool LoopVectorizationLegality::RuntimePointerCheck::needsChecking(
+    unsigned I, unsigned J) const {
+  // No need to check if two readonly pointers intersect.
+  if (!IsWritePtr[I] && !IsWritePtr[J])
+    return false;
+
+  // Only need to check pointers between two different dependency sets.
+  return DependencySetId[I] != DependencySetId[J];
+}
+
+bool LoopVectorizationLegality::RuntimePointerCheck::needsChecking(
+    const CheckingPtrGroup &M, const CheckingPtrGroup &N) const {
+  for (unsigned I = 0, EI = M.Members.size(); I != EI; ++I)
+    for (unsigned J = 0, EJ = N.Members.size(); J != EJ; ++J)
+      if (needsChecking(M.Members[I], N.Members[J]))
+        return true;
+  return false;
+}
+
+/// \brief Returns the constant difference \p A - \p B, or null if it is not
+/// a constant.
+static const SCEVConstant *getConstantDifference(ScalarEvolution *SE,
+                                                 const SCEV *A,
+                                                 const SCEV *B) {
+  return dyn_cast<SCEVConstant>(SE->getMinusSCEV(A, B));
+}
+
+void LoopVectorizationLegality::RuntimePointerCheck::groupChecks(
+    ScalarEvolution *SE) {
+  CheckingGroups.clear();
+
+  for (unsigned I = 0, E = Pointers.size(); I != E; ++I) {
+    unsigned AS = Pointers[I]->getType()->getPointerAddressSpace();
+    bool Merged = false;
+
+    for (unsigned G = 0, GE = CheckingGroups.size(); G != GE && !Merged;
+         ++G) {
+      CheckingPtrGroup &Group = CheckingGroups[G];
+      unsigned Leader = Group.Members[0];
+      if (Pointers[Leader]->getType()->getPointerAddressSpace() != AS)
+        continue;
+
+      // The members of a group are never checked against each other.
+      bool Independent = true;
+      for (unsigned M = 0, ME = Group.Members.size(); M != ME; ++M)
+        Independent &= !needsChecking(I, Group.Members[M]);
+      if (!Independent)
+        continue;
+
+      // Only merge ranges that are known to be close together, so that the
+      // group's range is hardly larger than the union of the members'.
+      const SCEVConstant *StartDiff =
+          getConstantDifference(SE, Starts[I], Group.Low);
+      const SCEVConstant *EndDiff =
+          getConstantDifference(SE, Ends[I], Group.High);
+      if (!StartDiff || !EndDiff)
+        continue;
+
+      if (StartDiff->getValue()->isNegative())
+        Group.Low = Starts[I];
+      if (!EndDiff->getValue()->isNegative())
+        Group.High = Ends[I];
+      Group.Members.push_back(I);
+      Merged = true;
+    }
+
+    if (!Merged)
+      CheckingGroups.push_back(CheckingPtrGroup(I, *this));
+  }
+}
+
+unsigned
+LoopVectorizationLegality::RuntimePointerCheck::getNumberOfChecks() const {
+  unsigned NumChecks = 0;
+  for (unsigned I = 0, E = CheckingGroups.size(); I != E; ++I)
+    for (unsigned J = I + 1; J != E; ++J)
+      if (needsChecking(CheckingGroups[I], CheckingGroups[J]))
+        ++NumChecks;
+  return NumChecks;
+}
+
 Value *InnerLoopVectorizer::getBroadcastInstrs(Value *V) {
   // We need to place the broadcast of invariant variables outside the loop.
   Instruction *Instr = dyn_cast<Instruction>(V);
@@ -1457,6 +1791,20 @@ Value *InnerLoopVectorizer::getConsecutiveVector(Value* Val, int StartIdx,
   return Builder.CreateAdd(Val, Cv, "induction");
 }
 
+/// \brief Returns the pointer operand of the load or store \p I.
+static Value *getMemInstPointerOperand(Instruction *I) {
+  if (LoadInst *LI = dyn_cast<LoadInst>(I))
+    return LI->getPointerOperand();
+  return cast<StoreInst>(I)->getPointerOperand();
+}
+
+/// \brief Returns the type of the value loaded or stored by \p I.
+static Type *getMemInstValueType(Instruction *I) {
+  if (LoadInst *LI = dyn_cast<LoadInst>(I))
+    return LI->getType();
+  return cast<StoreInst>(I)->getValueOperand()->getType();
+}
+
 /// \brief Find the operand of the GEP that should be checked for consecutive
 /// stores. This ignores trailing indices that have no effect on the final
 /// pointer.
@@ -1606,6 +1954,134 @@ Value *InnerLoopVectorizer::reverseVector(Value *Vec) {
                                      "reverse");
 }
 
+/// \brief Returns the mask that selects every \p Stride th element of a vector,
+/// starting at \p Start: <Start, Start + Stride, ..., Start + (VF-1)*Stride>.
+static Constant *getStridedMask(IRBuilder<> &Builder, unsigned Start,
+                                unsigned Stride, unsigned VF) {
+  SmallVector<Constant *, 16> Mask;
+  for (unsigned i = 0; i < VF; ++i)
+    Mask.push_back(Builder.getInt32(Start + i * Stride));
+  return ConstantVector::get(Mask);
+}
+
+/// \brief Returns the mask that interleaves \p NumVecs concatenated vectors
+/// of \p VF elements: <0, VF, ..., (NumVecs-1)*VF, 1, VF + 1, ...>.
+static Constant *getInterleavedMask(IRBuilder<> &Builder, unsigned VF,
+                                    unsigned NumVecs) {
+  SmallVector<Constant *, 16> Mask;
+  for (unsigned i = 0; i < VF; ++i)
+    for (unsigned j = 0; j < NumVecs; ++j)
+      Mask.push_back(Builder.getInt32(j * VF + i));
+  return ConstantVector::get(Mask);
+}
+
+/// \brief Concatenates two vectors. \p V2 may be shorter than \p V1, in which
+/// case it is padded with undef elements first.
+static Value *concatenateTwoVectors(IRBuilder<> &Builder, Value *V1,
+                                    Value *V2) {
+  unsigned NumElts1 = V1->getType()->getVectorNumElements();
+  unsigned NumElts2 = V2->getType()->getVectorNumElements();
+  assert(NumElts1 >= NumElts2 && "Unexpected vector lengths");
+
+  if (NumElts1 > NumElts2) {
+    SmallVector<Constant *, 16> Mask;
+    for (unsigned i = 0; i < NumElts2; ++i)
+      Mask.push_back(Builder.getInt32(i));
+    for (unsigned i = NumElts2; i < NumElts1; ++i)
+      Mask.push_back(UndefValue::get(Builder.getInt32Ty()));
+    V2 = Builder.CreateShuffleVector(V2, UndefValue::get(V2->getType()),
+                                     ConstantVector::get(Mask));
+  }
+
+  SmallVector<Constant *, 16> Mask;
+  for (unsigned i = 0; i < NumElts1 + NumElts2; ++i)
+    Mask.push_back(Builder.getInt32(i));
+  return Builder.CreateShuffleVector(V1, V2, ConstantVector::get(Mask));
+}
+
+/// \brief Concatenates the vectors in \p Vecs, which all have the same type,
+/// pairwise.
+static Value *concatenateVectors(IRBuilder<> &Builder,
+                                 SmallVectorImpl<Value *> &Vecs) {
+  assert(!Vecs.empty() && "Nothing to concatenate");
+  while (Vecs.size() > 1) {
+    SmallVector<Value *, 8> Concatenated;
+    for (unsigned i = 0, e = Vecs.size(); i + 1 < e; i += 2)
+      Concatenated.push_back(concatenateTwoVectors(Builder, Vecs[i],
+                                                   Vecs[i + 1]));
+    // An odd vector out is carried over to the next round.
+    if (Vecs.size() % 2)
+      Concatenated.push_back(Vecs.back());
+    Vecs.swap(Concatenated);
+  }
+  return Vecs.front();
+}
+
+void InnerLoopVectorizer::vectorizeInterleaveGroup(Instruction *Instr) {
+  const LoopVectorizationLegality::InterleaveGroup *Group =
+      Legal->getInterleaveGroup(Instr);
+  assert(Group && "Not a member of an interleaved access group");
+  if (Instr != Group->InsertPos)
+    return;
+
+  LoadInst *LI = dyn_cast<LoadInst>(Instr);
+  Type *ScalarDataTy = getMemInstValueType(Instr);
+  Value *Ptr = getMemInstPointerOperand(Instr);
+  unsigned AddressSpace = Ptr->getType()->getPointerAddressSpace();
+  unsigned Factor = Group->Factor;
+  Type *WideTy = VectorType::get(ScalarDataTy, Factor * VF);
+  Type *WidePtrTy = WideTy->getPointerTo(AddressSpace);
+
+  // The wide access starts at the member at index 0, which is not
+  // necessarily the one at the insert position. All the lanes of the pointer
+  // are computed but only the first one is used.
+  setDebugLocFromInst(Builder, Ptr);
+  int Index = Group->getIndex(Instr);
+  SmallVector<Value *, 2> WidePtrs;
+  for (unsigned Part = 0; Part < UF; ++Part) {
+    Value *PartPtr = getVectorValue(Ptr)[Part];
+    PartPtr = Builder.CreateExtractElement(PartPtr, Builder.getInt32(0));
+    PartPtr = Builder.CreateGEP(PartPtr, Builder.getInt32(-Index));
+    WidePtrs.push_back(Builder.CreateBitCast(PartPtr, WidePtrTy));
+  }
+
+  setDebugLocFromInst(Builder, Instr);
+  ++InterleaveGroupsVectorized;
+
+  // Handle loads: the members are shuffled out of the wide vector.
+  if (LI) {
+    for (unsigned Part = 0; Part < UF; ++Part) {
+      LoadInst *WideLoad = Builder.CreateLoad(WidePtrs[Part], "wide.vec");
+      WideLoad->setAlignment(Group->Align);
+
+      for (unsigned i = 0; i < Factor; ++i) {
+        Instruction *Member = Group->getMember(i);
+        if (!Member)
+          continue;
+        WidenMap.get(Member)[Part] = Builder.CreateShuffleVector(
+            WideLoad, UndefValue::get(WideTy),
+            getStridedMask(Builder, i, Factor, VF), "strided.vec");
+      }
+    }
+    return;
+  }
+
+  // Handle stores: the members are concatenated and interleaved.
+  for (unsigned Part = 0; Part < UF; ++Part) {
+    SmallVector<Value *, 8> StoredVecs;
+    for (unsigned i = 0; i < Factor; ++i) {
+      StoreInst *Member = cast<StoreInst>(Group->getMember(i));
+      StoredVecs.push_back(getVectorValue(Member->getValueOperand())[Part]);
+    }
+
+    Value *WideVec = concatenateVectors(Builder, StoredVecs);
+    Value *IVec = Builder.CreateShuffleVector(
+        WideVec, UndefValue::get(WideVec->getType()),
+        getInterleavedMask(Builder, VF, Factor), "interleaved.vec");
+    Builder.CreateStore(IVec, WidePtrs[Part])->setAlignment(Group->Align);
+  }
+}
+
 void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr) {
   // Attempt to issue a wide load.
   LoadInst *LI = dyn_cast<LoadInst>(Instr);
@@ -1613,6 +2089,10 @@ void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr) {
 
   assert((LI || SI) && "Invalid Load/Store instruction");
 
+  // Interleaved accesses are vectorized a group at a time.
+  if (Legal->getInterleaveGroup(Instr))
+    return vectorizeInterleaveGroup(Instr);
+
   Type *ScalarDataTy = LI ? LI->getType() : SI->getValueOperand()->getType();
   Type *DataTy = VectorType::get(ScalarDataTy, VF);
   Value *Ptr = LI ? LI->getPointerOperand() : SI->getPointerOperand();
@@ -1910,10 +2390,13 @@ InnerLoopVectorizer::addRuntimeCheck(Instruction *Loc) {
   Legal->getRuntimePointerCheck();
 
   Instruction *tnullptr = nullptr;
-  if (!PtrRtCheck->Need)
+  if (!PtrRtCheck->Need || PtrRtCheck->CheckingGroups.empty())
     return std::pair<Instruction *, Instruction *>(tnullptr, tnullptr);
 
-  unsigned NumPointers = PtrRtCheck->Pointers.size();
+  typedef LoopVectorizationLegality::RuntimePointerCheck::CheckingPtrGroup
+      CheckingPtrGroup;
+  const SmallVectorImpl<CheckingPtrGroup> &Groups = PtrRtCheck->CheckingGroups;
+  unsigned NumGroups = Groups.size();
   SmallVector<TrackingVH<Value> , 2> Starts;
   SmallVector<TrackingVH<Value> , 2> Ends;
 
@@ -1921,24 +2404,28 @@ InnerLoopVectorizer::addRuntimeCheck(Instruction *Loc) {
   SCEVExpander Exp(*SE, "induction");
   Instruction *FirstInst = nullptr;
 
-  for (unsigned i = 0; i < NumPointers; ++i) {
-    Value *Ptr = PtrRtCheck->Pointers[i];
+  for (unsigned i = 0; i < NumGroups; ++i) {
+    const CheckingPtrGroup &Group = Groups[i];
+    Value *Ptr = PtrRtCheck->Pointers[Group.Members[0]];
     const SCEV *Sc = SE->getSCEV(Ptr);
 
-    if (SE->isLoopInvariant(Sc, OrigLoop)) {
+    if (Group.Members.size() == 1 && SE->isLoopInvariant(Sc, OrigLoop)) {
       DEBUG(dbgs() << "LV: Adding RT check for a loop invariant ptr:" <<
             *Ptr <<"\n");
       Starts.push_back(Ptr);
       Ends.push_back(Ptr);
     } else {
       DEBUG(dbgs() << "LV: Adding RT check for range:" << *Ptr << '\n');
+      DEBUG(if (Group.Members.size() > 1) dbgs()
+            << "LV: The range covers " << Group.Members.size()
+            << " pointers.\n");
       unsigned AS = Ptr->getType()->getPointerAddressSpace();
 
       // Use this type for pointer arithmetic.
       Type *PtrArithTy = Type::getInt8PtrTy(Ctx, AS);
 
-      Value *Start = Exp.expandCodeFor(PtrRtCheck->Starts[i], PtrArithTy, Loc);
-      Value *End = Exp.expandCodeFor(PtrRtCheck->Ends[i], PtrArithTy, Loc);
+      Value *Start = Exp.expandCodeFor(Group.Low, PtrArithTy, Loc);
+      Value *End = Exp.expandCodeFor(Group.High, PtrArithTy, Loc);
       Starts.push_back(Start);
       Ends.push_back(End);
     }
@@ -1947,16 +2434,12 @@ InnerLoopVectorizer::addRuntimeCheck(Instruction *Loc) {
   IRBuilder<> ChkBuilder(Loc);
   // Our instructions might fold to a constant.
   Value *MemoryRuntimeCheck = nullptr;
-  for (unsigned i = 0; i < NumPointers; ++i) {
-    for (unsigned j = i+1; j < NumPointers; ++j) {
-      // No need to check if two readonly pointers intersect.
-      if (!PtrRtCheck->IsWritePtr[i] && !PtrRtCheck->IsWritePtr[j])
+  for (unsigned i = 0; i < NumGroups; ++i) {
+    for (unsigned j = i+1; j < NumGroups; ++j) {
+      // Only check groups with a writer, from different dependency sets.
+      if (!PtrRtCheck->needsChecking(Groups[i], Groups[j]))
         continue;
 
-      // Only need to check pointers between two different dependency sets.
-      if (PtrRtCheck->DependencySetId[i] == PtrRtCheck->DependencySetId[j])
-       continue;
-
       unsigned AS0 = Starts[i]->getType()->getPointerAddressSpace();
       unsigned AS1 = Starts[j]->getType()->getPointerAddressSpace();
 
@@ -1987,6 +2470,9 @@ InnerLoopVectorizer::addRuntimeCheck(Instruction *Loc) {
     }
   }
 
+  if (!MemoryRuntimeCheck)
+    return std::pair<Instruction *, Instruction *>(tnullptr, tnullptr);
+
   // We have to do this trickery because the IRBuilder might fold the check to a
   // constant expression in which case there is no Instruction anchored in a
   // the block.
@@ -3424,6 +3910,9 @@ bool LoopVectorizationLegality::canVectorize() {
     return false;
   }
 
+  // Find the strided accesses that can be vectorized together.
+  analyzeInterleaving();
+
   // Collect all of the variables that remain uniform after vectorization.
   collectLoopUniforms();
 
@@ -3826,6 +4315,12 @@ void LoopVectorizationLegality::collectLoopUniforms() {
       if (I->getType()->isPointerTy() && isConsecutivePtr(I))
         Worklist.insert(Worklist.end(), I->op_begin(), I->op_end());
 
+  // Only the first lane of the pointers of interleaved accesses is used.
+  for (unsigned i = 0, e = InterleaveGroups.size(); i != e; ++i)
+    for (unsigned j = 0, je = InterleaveGroups[i].Factor; j != je; ++j)
+      if (Instruction *Member = InterleaveGroups[i].getMember(j))
+        Worklist.push_back(getMemInstPointerOperand(Member));
+
   while (Worklist.size()) {
     Instruction *I = dyn_cast<Instruction>(Worklist.back());
     Worklist.pop_back();
@@ -4013,7 +4508,11 @@ bool AccessAnalysis::canCheckPtrAtRT(
 
   if (IsDepCheckNeeded && CanDoRT && RunningDepId == 2)
     NumComparisons = 0; // Only one dependence set.
-  else {
+  else if (CanDoRT) {
+    // Compare groups of nearby pointers rather than every pair.
+    RtCheck.groupChecks(SE);
+    NumComparisons = RtCheck.getNumberOfChecks();
+  } else {
     NumComparisons = (NumWritePtrChecks * (NumReadPtrChecks +
                                            NumWritePtrChecks - 1));
   }
@@ -4338,6 +4837,71 @@ static int isStridedPtr(ScalarEvolution *SE, const DataLayout *DL, Value *Ptr,
   return Stride;
 }
 
+/// \brief Return the stride of the access through \p Ptr in elements, or zero
+/// if it is not a constant.
+///
+/// isStridedPtr only trusts a non-unit stride if the address recurrence is
+/// known not to wrap. An inbounds getelementptr that is actually accessed on
+/// every iteration cannot wrap around the address space either, which is all
+/// grouping and disjointness need.
+static int getInBoundsPtrStride(ScalarEvolution *SE, const DataLayout *DL,
+                                Value *Ptr, const Loop *Lp,
+                                ValueToValueMap &StridesMap) {
+  if (int Stride = isStridedPtr(SE, DL, Ptr, Lp, StridesMap))
+    return Stride;
+  if (!isInBoundsGep(Ptr))
+    return 0;
+
+  const SCEVAddRecExpr *AR = dyn_cast<SCEVAddRecExpr>(
+      replaceSymbolicStrideSCEV(SE, StridesMap, Ptr));
+  if (!AR || AR->getLoop() != Lp)
+    return 0;
+  const SCEVConstant *C = dyn_cast<SCEVConstant>(AR->getStepRecurrence(*SE));
+  if (!C || C->getValue()->getValue().getMinSignedBits() > 32)
+    return 0;
+
+  int64_t Size =
+      DL->getTypeAllocSize(Ptr->getType()->getPointerElementType());
+  int64_t StepVal = C->getValue()->getSExtValue();
+  if (!Size || StepVal % Size)
+    return 0;
+  return StepVal / Size;
+}
+
+/// \brief Check whether the accesses through \p APtr and \p BPtr can never
+/// touch the same memory.
+///
+/// This is the case for accesses to elements of the same type that advance
+/// by the same stride of several elements and whose distance is a constant
+/// that is not a multiple of that stride, such as the accesses to different
+/// fields of an array of structs.
+static bool areStridedAccessesDisjoint(ScalarEvolution *SE,
+                                       const DataLayout *DL, Value *APtr,
+                                       Value *BPtr, const Loop *Lp,
+                                       ValueToValueMap &StridesMap) {
+  Type *ATy = APtr->getType()->getPointerElementType();
+  Type *BTy = BPtr->getType()->getPointerElementType();
+  if (ATy != BTy)
+    return false;
+
+  int Stride = getInBoundsPtrStride(SE, DL, APtr, Lp, StridesMap);
+  if (Stride > -2 && Stride < 2)
+    return false;
+  if (getInBoundsPtrStride(SE, DL, BPtr, Lp, StridesMap) != Stride)
+    return false;
+
+  const SCEV *Dist =
+      SE->getMinusSCEV(replaceSymbolicStrideSCEV(SE, StridesMap, BPtr),
+                       replaceSymbolicStrideSCEV(SE, StridesMap, APtr));
+  const SCEVConstant *C = dyn_cast<SCEVConstant>(Dist);
+  if (!C || C->getValue()->getValue().getMinSignedBits() > 64)
+    return false;
+
+  int64_t Distance = C->getValue()->getSExtValue();
+  int64_t Size = DL->getTypeAllocSize(ATy);
+  return Distance % Size == 0 && Distance % (Size * Stride) != 0;
+}
+
 bool MemoryDepChecker::couldPreventStoreLoadForward(unsigned Distance,
                                                     unsigned TypeByteSize) {
   // If loads occur at a distance that is not a multiple of a feasible vector
@@ -4389,6 +4953,13 @@ bool MemoryDepChecker::isDependent(const MemAccessInfo &A, unsigned AIdx,
   if (!AIsWrite && !BIsWrite)
     return false;
 
+  // So are accesses to different fields of an array of structs.
+  if (EnableInterleavedMemAccesses &&
+      areStridedAccessesDisjoint(SE, DL, APtr, BPtr, InnermostLoop, Strides)) {
+    DEBUG(dbgs() << "LV: Strided accesses never overlap: NoDep\n");
+    return false;
+  }
+
   const SCEV *AScev = replaceSymbolicStrideSCEV(SE, Strides, APtr);
   const SCEV *BScev = replaceSymbolicStrideSCEV(SE, Strides, BPtr);
 
@@ -4705,7 +5276,8 @@ bool LoopVectorizationLegality::canVectorizeMemory() {
 
   // Check that we did not collect too many pointers or found an unsizeable
   // pointer.
-  if (!CanDoRT || NumComparisons > RuntimeMemoryCheckThreshold) {
+  bool TooManyChecks = CanDoRT && NumComparisons > MaxRuntimeChecks;
+  if (!CanDoRT || TooManyChecks) {
     PtrRtCheck.reset();
     CanDoRT = false;
   }
@@ -4714,6 +5286,15 @@ bool LoopVectorizationLegality::canVectorizeMemory() {
     DEBUG(dbgs() << "LV: We can perform a memory runtime check if needed.\n");
   }
 
+  if (NeedRTCheck && TooManyChecks) {
+    emitAnalysis(Report() << NumComparisons << " exceeds limit of "
+                          << MaxRuntimeChecks
+                          << " dependent memory operations checked at runtime");
+    DEBUG(dbgs() << "LV: We can't vectorize because we would need "
+                 << NumComparisons << " pointer comparisons.\n");
+    return false;
+  }
+
   if (NeedRTCheck && !CanDoRT) {
     emitAnalysis(Report() << "cannot identify array bounds");
     DEBUG(dbgs() << "LV: We can't vectorize because we can't find " <<
@@ -4745,14 +5326,14 @@ bool LoopVectorizationLegality::canVectorizeMemory() {
                                          TheLoop, Strides, true);
       // Check that we did not collect too many pointers or found an unsizeable
       // pointer.
-      if (!CanDoRT || NumComparisons > RuntimeMemoryCheckThreshold) {
+      if (!CanDoRT || NumComparisons > MaxRuntimeChecks) {
         if (!CanDoRT && NumComparisons > 0)
           emitAnalysis(Report()
                        << "cannot check memory dependencies at runtime");
         else
           emitAnalysis(Report()
                        << NumComparisons << " exceeds limit of "
-                       << RuntimeMemoryCheckThreshold
+                       << MaxRuntimeChecks
                        << " dependent memory operations checked at runtime");
         DEBUG(dbgs() << "LV: Can't vectorize with memory checks\n");
         PtrRtCheck.reset();
@@ -4772,6 +5353,159 @@ bool LoopVectorizationLegality::canVectorizeMemory() {
   return CanVecMem;
 }
 
+unsigned LoopVectorizationLegality::getInterleaveFactor(Instruction *I) {
+  LoadInst *LI = dyn_cast<LoadInst>(I);
+  StoreInst *SI = dyn_cast<StoreInst>(I);
+  if ((LI && !LI->isSimple()) || (SI && !SI->isSimple()))
+    return 0;
+
+  // The members become elements of a vector, so they must be scalars without
+  // padding.
+  Type *Ty = getMemInstValueType(I);
+  if (!Ty->isIntegerTy() && !Ty->isFloatingPointTy())
+    return 0;
+  if (DL->getTypeAllocSizeInBits(Ty) != Ty->getPrimitiveSizeInBits())
+    return 0;
+
+  Value *Ptr = getMemInstPointerOperand(I);
+  const SCEVAddRecExpr *AR = dyn_cast<SCEVAddRecExpr>(SE->getSCEV(Ptr));
+  if (!AR || AR->getLoop() != TheLoop)
+    return 0;
+
+  int Stride = getInBoundsPtrStride(SE, DL, Ptr, TheLoop, Strides);
+  if (Stride < 2 || Stride > (int)MaxInterleaveFactor)
+    return 0;
+  return Stride;
+}
+
+void LoopVectorizationLegality::analyzeInterleaving() {
+  if (!EnableInterleavedMemAccesses)
+    return;
+
+  for (Loop::block_iterator bb = TheLoop->block_begin(),
+       be = TheLoop->block_end(); bb != be; ++bb) {
+    // Predicated stores are scalarized, and a wide load may not be safe where
+    // only some of its elements are.
+    if (blockNeedsPredication(*bb))
+      continue;
+
+    // The loads and stores of the block in program order.
+    SmallVector<Instruction *, 16> Accesses;
+    for (BasicBlock::iterator it = (*bb)->begin(), e = (*bb)->end(); it != e;
+         ++it)
+      if (isa<LoadInst>(it) || isa<StoreInst>(it))
+        Accesses.push_back(it);
+
+    // Greedily group every access that is not in a group yet with the later
+    // accesses of the same kind, type and stride at constant distances from
+    // it.
+    SmallPtrSet<Instruction *, 16> Grouped;
+    for (unsigned i = 0, e = Accesses.size(); i != e; ++i) {
+      Instruction *Leader = Accesses[i];
+      unsigned Factor = getInterleaveFactor(Leader);
+      if (!Factor || Grouped.count(Leader))
+        continue;
+
+      bool IsLoad = isa<LoadInst>(Leader);
+      Type *Ty = getMemInstValueType(Leader);
+      int64_t Size = DL->getTypeAllocSize(Ty);
+      const SCEV *LeaderPtr = SE->getSCEV(getMemInstPointerOperand(Leader));
+
+      // The members as (offset from the leader in elements, position in
+      // Accesses) pairs.
+      SmallVector<std::pair<int64_t, unsigned>, 8> Found;
+      Found.push_back(std::make_pair(0, i));
+      int64_t MinOffset = 0, MaxOffset = 0;
+      for (unsigned j = i + 1; j != e; ++j) {
+        Instruction *I = Accesses[j];
+        if (isa<LoadInst>(I) != IsLoad || Grouped.count(I) ||
+            getMemInstValueType(I) != Ty || getInterleaveFactor(I) != Factor)
+          continue;
+
+        const SCEVConstant *Dist = dyn_cast<SCEVConstant>(
+            SE->getMinusSCEV(SE->getSCEV(getMemInstPointerOperand(I)),
+                             LeaderPtr));
+        if (!Dist || Dist->getValue()->getValue().getMinSignedBits() > 64)
+          continue;
+        int64_t Distance = Dist->getValue()->getSExtValue();
+        if (Distance % Size)
+          continue;
+
+        int64_t Offset = Distance / Size;
+        if (std::max(MaxOffset, Offset) - std::min(MinOffset, Offset) >=
+            (int64_t)Factor)
+          continue;
+        bool Taken = false;
+        for (unsigned k = 0, ke = Found.size(); k != ke; ++k)
+          Taken |= Found[k].first == Offset;
+        if (Taken)
+          continue;
+
+        Found.push_back(std::make_pair(Offset, j));
+        MinOffset = std::min(MinOffset, Offset);
+        MaxOffset = std::max(MaxOffset, Offset);
+      }
+
+      // A wide store overwrites every element it covers, so a store group
+      // must be complete. A wide load may read the gaps between the members
+      // but nothing outside the first and the last one.
+      if (Found.size() < 2 || MaxOffset - MinOffset != Factor - 1 ||
+          (!IsLoad && Found.size() != Factor))
+        continue;
+
+      InterleaveGroup Group;
+      Group.Factor = Factor;
+      Group.Members.assign(Factor, nullptr);
+      SmallPtrSet<Instruction *, 8> MemberSet;
+      unsigned LastPos = i;
+      for (unsigned k = 0, ke = Found.size(); k != ke; ++k) {
+        Instruction *Member = Accesses[Found[k].second];
+        Group.Members[Found[k].first - MinOffset] = Member;
+        MemberSet.insert(Member);
+        LastPos = std::max(LastPos, Found[k].second);
+      }
+      Group.InsertPos = IsLoad ? Leader : Accesses[LastPos];
+
+      // The loads are moved up to the first member and the stores down to
+      // the last one. They must not pass other accesses to the same memory
+      // on the way.
+      bool CanMove = true;
+      for (unsigned k = 0, ke = Found.size(); k != ke && CanMove; ++k) {
+        Instruction *Member = Accesses[Found[k].second];
+        unsigned From = IsLoad ? i : Found[k].second;
+        unsigned To = IsLoad ? Found[k].second : LastPos;
+        for (unsigned l = From + 1; l < To && CanMove; ++l) {
+          Instruction *Other = Accesses[l];
+          if (MemberSet.count(Other) || (IsLoad && isa<LoadInst>(Other)))
+            continue;
+          CanMove = areStridedAccessesDisjoint(
+              SE, DL, getMemInstPointerOperand(Other),
+              getMemInstPointerOperand(Member), TheLoop, Strides);
+        }
+      }
+      if (!CanMove)
+        continue;
+
+      Instruction *First = Group.Members[0];
+      Group.Align = IsLoad ? cast<LoadInst>(First)->getAlignment()
+                           : cast<StoreInst>(First)->getAlignment();
+      if (!Group.Align)
+        Group.Align = DL->getABITypeAlignment(Ty);
+
+      DEBUG(dbgs() << "LV: Found an interleaved " << (IsLoad ? "load" : "store")
+                   << " group of factor " << Factor << " with "
+                   << Found.size() << " members at " << *Group.InsertPos
+                   << "\n");
+      for (unsigned k = 0, ke = Found.size(); k != ke; ++k) {
+        Instruction *Member = Accesses[Found[k].second];
+        Grouped.insert(Member);
+        InterleaveGroupIdx[Member] = InterleaveGroups.size();
+      }
+      InterleaveGroups.push_back(Group);
+    }
+  }
+}
+
 static bool hasMultipleUsesOf(Instruction *I,
                               SmallPtrSet<Instruction *, 8> &Insts) {
   unsigned NumUses = 0;
@@ -5168,11 +5902,16 @@ LoopVectorizationCostModel::selectVectorizationFactor(bool OptForSize,
   // Width 1 means no vectorize
   VectorizationFactor Factor = { 1U, 0U };
   if (OptForSize && Legal->getRuntimePointerCheck()->Need) {
+    emitAnalysis(Report() << "runtime pointer checks needed. Enable "
+                             "vectorization of this loop with '#pragma clang "
+                             "loop vectorize(enable)' when compiling with -Os");
     DEBUG(dbgs() << "LV: Aborting. Runtime ptr check is required in Os.\n");
     return Factor;
   }
 
   if (!EnableCondStoresVectorization && Legal->NumPredStores) {
+    emitAnalysis(Report() << "store that is conditionally executed prevents "
+                             "vectorization");
     DEBUG(dbgs() << "LV: No vectorization. There are conditional stores.\n");
     return Factor;
   }
@@ -5207,6 +5946,9 @@ LoopVectorizationCostModel::selectVectorizationFactor(bool OptForSize,
   if (OptForSize) {
     // If we are unable to calculate the trip count then don't try to vectorize.
     if (TC < 2) {
+      emitAnalysis(Report() << "unable to calculate the loop count due to "
+                               "complex control flow, as needed to avoid a "
+                               "scalar remainder when optimizing for size");
       DEBUG(dbgs() << "LV: Aborting. A tail loop is required in Os.\n");
       return Factor;
     }
@@ -5220,6 +5962,8 @@ LoopVectorizationCostModel::selectVectorizationFactor(bool OptForSize,
     // If the trip count that we found modulo the vectorization factor is not
     // zero then we require a tail.
     if (VF < 2) {
+      emitAnalysis(Report() << "the trip count leaves a scalar remainder, "
+                               "which is not allowed when optimizing for size");
       DEBUG(dbgs() << "LV: Aborting. A tail loop is required in Os.\n");
       return Factor;
     }
@@ -5268,6 +6012,32 @@ LoopVectorizationCostModel::selectVectorizationFactor(bool OptForSize,
   return Factor;
 }
 
+unsigned LoopVectorizationCostModel::selectEpilogueVectorizationFactor(
+    unsigned VF, unsigned UF) {
+  // The remainder runs fewer than VF * UF iterations.
+  unsigned Step = VF * UF;
+  if (Step < EpilogueVectorizationMinVF)
+    return 1;
+
+  unsigned MaxWidth = std::min(VF, Step / 2);
+  unsigned TC = SE->getSmallConstantTripCount(TheLoop, TheLoop->getLoopLatch());
+  if (TC)
+    MaxWidth = std::min(MaxWidth, (unsigned)PowerOf2Floor(TC % Step));
+
+  float Cost = expectedCost(1);
+  unsigned Width = 1;
+  for (unsigned i = 2; i <= MaxWidth; i *= 2) {
+    float VectorCost = expectedCost(i) / (float)i;
+    if (VectorCost < Cost) {
+      Cost = VectorCost;
+      Width = i;
+    }
+  }
+
+  DEBUG(dbgs() << "LV: Selecting epilogue VF: " << Width << ".\n");
+  return Width;
+}
+
 unsigned LoopVectorizationCostModel::getWidestType() {
   unsigned MaxWidth = 8;
 
@@ -5410,6 +6180,15 @@ LoopVectorizationCostModel::selectUnrollFactor(bool OptForSize,
     return UF;
   }
 
+  // Unrolling the scalar loop would reorder the accesses of its interleaved
+  // groups, which are only known to be independent of each other.  A store
+  // group then writes to several strides at once instead of one after the
+  // other, which is slower than the loop as it is.
+  if (VF == 1 && Legal->hasInterleaveGroups()) {
+    DEBUG(dbgs() << "LV: Not unrolling the interleaved accesses.\n");
+    return 1;
+  }
+
   // Note that if we've already vectorized the loop we will have done the
   // runtime check and so unrolling won't require further checks.
   bool UnrollingRequiresRuntimePointerCheck =
@@ -5752,6 +6531,24 @@ LoopVectorizationCostModel::getInstructionCost(Instruction *I, unsigned VF) {
       return TTI.getAddressComputationCost(VectorTy) +
         TTI.getMemoryOpCost(I->getOpcode(), VectorTy, Alignment, AS);
 
+    // Interleaved accesses: the cost of the whole group is counted at its
+    // insert position.
+    if (const LoopVectorizationLegality::InterleaveGroup *Group =
+            Legal->getInterleaveGroup(I)) {
+      if (I != Group->InsertPos)
+        return 0;
+
+      Type *WideTy = VectorType::get(ValTy, VF * Group->Factor);
+      SmallVector<unsigned, 8> Indices;
+      for (unsigned i = 0; i < Group->Factor; ++i)
+        if (Group->getMember(i))
+          Indices.push_back(i);
+      return TTI.getAddressComputationCost(WideTy) +
+             TTI.getInterleavedMemoryOpCost(I->getOpcode(), WideTy,
+                                            Group->Factor, Indices,
+                                            Group->Align, AS);
+    }
+
     // Scalarized loads/stores.
     int ConsecutiveStride = Legal->isConsecutivePtr(Ptr);
     bool Reverse = ConsecutiveStride < 0;
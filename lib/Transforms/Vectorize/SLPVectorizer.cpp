@@ -53,6 +53,8 @@ static cl::opt<int>
                      cl::desc("Only vectorize if you gain more than this "
                               "number "));
 
+// Off by default: on SSE4.2 targets an eight-wide i32 add reduction is
+// slower vectorized than scalar, which the cost model doesn't see yet.
 static cl::opt<bool>
 ShouldVectorizeHor("slp-vectorize-hor", cl::init(false), cl::Hidden,
                    cl::desc("Attempt to vectorize horizontal reductions"));
@@ -66,7 +68,18 @@ namespace {
 
 static const unsigned MinVecRegSize = 128;
 
-static const unsigned RecursionMaxDepth = 12;
+/// Limits the depth of the use-def chains followed from the roots of a tree.
+static cl::opt<unsigned> RecursionMaxDepth(
+    "slp-recursion-max-depth", cl::init(12), cl::Hidden,
+    cl::desc("Limit the recursion depth when building a vectorizable tree"));
+
+/// Limits the number of stores compared with each store when looking for
+/// chains of consecutive stores, which keeps the search linear in the number of
+/// stores to the same object.
+static cl::opt<unsigned> MaxStoreLookup(
+    "slp-max-store-lookup", cl::init(32), cl::Hidden,
+    cl::desc("Maximum number of stores compared with each store when "
+             "looking for consecutive stores"));
 
 /// A helper class for numbering instructions in multiple blocks.
 /// Numbers start at zero for each basic block.
@@ -400,8 +413,10 @@ public:
   Value *vectorizeTree();
 
   /// \returns the vectorization cost of the subtree that starts at \p VL.
-  /// A negative number means that this is profitable.
-  int getTreeCost();
+  /// A negative number means that this is profitable. Trees of a single
+  /// bundle are only costed if \p AllowSingleBundle is set, for roots whose
+  /// users are vectorized too, such as the values of a horizontal reduction.
+  int getTreeCost(bool AllowSingleBundle = false);
 
   /// Construct a vectorizable tree that starts at \p Roots, ignoring users for
   /// the purpose of scheduling and extraction in the \p UserIgnoreLst.
@@ -1364,13 +1379,17 @@ bool BoUpSLP::isFullyVectorizableTinyTree() {
   return true;
 }
 
-int BoUpSLP::getTreeCost() {
+int BoUpSLP::getTreeCost(bool AllowSingleBundle) {
   int Cost = 0;
   DEBUG(dbgs() << "SLP: Calculating cost for tree of size " <<
         VectorizableTree.size() << ".\n");
 
+  bool IsSingleBundle = AllowSingleBundle && VectorizableTree.size() == 1 &&
+                        !VectorizableTree[0].NeedToGather;
+
   // We only vectorize tiny trees if it is fully vectorizable.
-  if (VectorizableTree.size() < 3 && !isFullyVectorizableTinyTree()) {
+  if (VectorizableTree.size() < 3 && !isFullyVectorizableTinyTree() &&
+      !IsSingleBundle) {
     if (!VectorizableTree.size()) {
       assert(!ExternalUses.size() && "We should not have any external users");
     }
@@ -2327,17 +2346,24 @@ bool SLPVectorizer::vectorizeStores(ArrayRef<StoreInst *> Stores,
   BoUpSLP::ValueSet VectorizedStores;
   bool Changed = false;
 
-  // Do a quadratic search on all of the given stores and find
-  // all of the pairs of stores that follow each other.
+  // Find the pairs of stores that follow each other. The store that follows
+  // a store is usually close to it in the block, so only look at the
+  // MaxStoreLookup stores around each store, nearest first.
   for (unsigned i = 0, e = Stores.size(); i < e; ++i) {
-    for (unsigned j = 0; j < e; ++j) {
-      if (i == j)
-        continue;
-
-      if (R.isConsecutiveAccess(Stores[i], Stores[j])) {
-        Tails.insert(Stores[j]);
+    for (unsigned Dist = 1; Dist <= MaxStoreLookup; ++Dist) {
+      if (Dist > i && i + Dist >= e)
+        break;
+      if (i + Dist < e && R.isConsecutiveAccess(Stores[i], Stores[i + Dist])) {
+        Tails.insert(Stores[i + Dist]);
         Heads.insert(Stores[i]);
-        ConsecutiveChain[Stores[i]] = Stores[j];
+        ConsecutiveChain[Stores[i]] = Stores[i + Dist];
+        break;
+      }
+      if (Dist <= i && R.isConsecutiveAccess(Stores[i], Stores[i - Dist])) {
+        Tails.insert(Stores[i - Dist]);
+        Heads.insert(Stores[i]);
+        ConsecutiveChain[Stores[i]] = Stores[i - Dist];
+        break;
       }
     }
   }
@@ -2570,10 +2596,43 @@ static Value *createRdxShuffleMask(unsigned VecLen, unsigned NumEltsToRdx,
 }
 
 
+/// \returns the predicate of \p I if it picks the minimum or the maximum of
+/// two values as 'select (cmp Pred A, B), A, B', and BAD_ICMP_PREDICATE
+/// otherwise.
+static CmpInst::Predicate getMinMaxPredicate(Instruction *I) {
+  SelectInst *SI = dyn_cast<SelectInst>(I);
+  if (!SI)
+    return CmpInst::BAD_ICMP_PREDICATE;
+
+  CmpInst *Cmp = dyn_cast<CmpInst>(SI->getCondition());
+  if (!Cmp || !Cmp->hasOneUse() || Cmp->getParent() != SI->getParent() ||
+      Cmp->getOperand(0) != SI->getTrueValue() ||
+      Cmp->getOperand(1) != SI->getFalseValue())
+    return CmpInst::BAD_ICMP_PREDICATE;
+
+  CmpInst::Predicate Pred = Cmp->getPredicate();
+  switch (Pred) {
+  case CmpInst::ICMP_UGT: case CmpInst::ICMP_UGE:
+  case CmpInst::ICMP_ULT: case CmpInst::ICMP_ULE:
+  case CmpInst::ICMP_SGT: case CmpInst::ICMP_SGE:
+  case CmpInst::ICMP_SLT: case CmpInst::ICMP_SLE:
+  case CmpInst::FCMP_OGT: case CmpInst::FCMP_OGE:
+  case CmpInst::FCMP_OLT: case CmpInst::FCMP_OLE:
+  case CmpInst::FCMP_UGT: case CmpInst::FCMP_UGE:
+  case CmpInst::FCMP_ULT: case CmpInst::FCMP_ULE:
+    return Pred;
+  default:
+    return CmpInst::BAD_ICMP_PREDICATE;
+  }
+}
+
 /// Model horizontal reductions.
 ///
-/// A horizontal reduction is a tree of reduction operations (currently add and
-/// fadd) that has operations that can be put into a vector as its leaf.
+/// A horizontal reduction is a tree of reduction operations that has
+/// operations that can be put into a vector as its leaf. The reduction
+/// operations are one associative operator (add, mul, and, or, xor, and fadd
+/// and fmul where reassociation is allowed) or one min/max idiom: a select of
+/// the two operands of the compare that controls it.
 /// For example, this tree:
 ///
 /// mul mul mul mul
@@ -2582,8 +2641,8 @@ static Value *createRdxShuffleMask(unsigned VecLen, unsigned NumEltsToRdx,
 ///    \     /
 ///       +
 /// This tree has "mul" as its reduced values and "+" as its reduction
-/// operations. A reduction might be feeding into a store or a binary operation
-/// feeding a phi.
+/// operations. A reduction might be feeding into a store, a return or a binary
+/// operation feeding a phi.
 ///    ...
 ///    \  /
 ///     +
@@ -2601,11 +2660,13 @@ class HorizontalReduction {
   SmallVector<Value *, 16> ReductionOps;
   SmallVector<Value *, 32> ReducedVals;
 
-  BinaryOperator *ReductionRoot;
+  Instruction *ReductionRoot;
   PHINode *ReductionPHI;
 
-  /// The opcode of the reduction.
+  /// The opcode of the reduction. This is Select for min/max reductions.
   unsigned ReductionOpcode;
+  /// The predicate of the compares of a min/max reduction.
+  CmpInst::Predicate MinMaxPred;
   /// The opcode of the values we perform a reduction on.
   unsigned ReducedValueOpcode;
   /// The width of one full horizontal reduction operation.
@@ -2614,13 +2675,17 @@ class HorizontalReduction {
   /// splits the vector in halves and adds those halves.
   bool IsPairwiseReduction;
 
+  /// Reductions narrower than this are left to the other SLP strategies.
+  static const unsigned MinReduxWidth = 4;
+
 public:
   HorizontalReduction()
     : ReductionRoot(nullptr), ReductionPHI(nullptr), ReductionOpcode(0),
-    ReducedValueOpcode(0), ReduxWidth(0), IsPairwiseReduction(false) {}
+    MinMaxPred(CmpInst::BAD_ICMP_PREDICATE), ReducedValueOpcode(0),
+    ReduxWidth(0), IsPairwiseReduction(false) {}
 
   /// \brief Try to find a reduction tree.
-  bool matchAssociativeReduction(PHINode *Phi, BinaryOperator *B,
+  bool matchAssociativeReduction(PHINode *Phi, Instruction *B,
                                  const DataLayout *DL) {
     assert((!Phi ||
             std::find(Phi->op_begin(), Phi->op_end(), B) != Phi->op_end()) &&
@@ -2629,13 +2694,15 @@ public:
     // We could have a initial reductions that is not an add.
     //  r *= v1 + v2 + v3 + v4
     // In such a case start looking for a tree rooted in the first '+'.
+    // The operands of a min/max idiom are those of its select.
     if (Phi) {
-      if (B->getOperand(0) == Phi) {
+      unsigned LHS = isa<SelectInst>(B) ? 1 : 0;
+      if (B->getOperand(LHS) == Phi) {
         Phi = nullptr;
-        B = dyn_cast<BinaryOperator>(B->getOperand(1));
-      } else if (B->getOperand(1) == Phi) {
+        B = dyn_cast<Instruction>(B->getOperand(LHS + 1));
+      } else if (B->getOperand(LHS + 1) == Phi) {
         Phi = nullptr;
-        B = dyn_cast<BinaryOperator>(B->getOperand(0));
+        B = dyn_cast<Instruction>(B->getOperand(LHS));
       }
     }
 
@@ -2643,31 +2710,59 @@ public:
       return false;
 
     Type *Ty = B->getType();
-    if (Ty->isVectorTy())
+    if (!Ty->isIntegerTy() && !Ty->isFloatingPointTy())
       return false;
 
     ReductionOpcode = B->getOpcode();
+    MinMaxPred = getMinMaxPredicate(B);
     ReducedValueOpcode = 0;
     ReduxWidth = MinVecRegSize / DL->getTypeSizeInBits(Ty);
     ReductionRoot = B;
     ReductionPHI = Phi;
 
-    if (ReduxWidth < 4)
+    if (ReduxWidth < MinReduxWidth)
       return false;
 
-    // We currently only support adds.
-    if (ReductionOpcode != Instruction::Add &&
-        ReductionOpcode != Instruction::FAdd)
+    switch (ReductionOpcode) {
+    case Instruction::Add:
+    case Instruction::FAdd:
+    case Instruction::Mul:
+    case Instruction::FMul:
+    case Instruction::And:
+    case Instruction::Or:
+    case Instruction::Xor:
+      break;
+    case Instruction::Select: {
+      if (MinMaxPred == CmpInst::BAD_ICMP_PREDICATE)
+        return false;
+      // The phi would have to be folded back in with another compare.
+      if (Phi)
+        return false;
+      // Reordering the compares of a floating point min/max is only safe if
+      // there are no NaNs.
+      Function *F = B->getParent()->getParent();
+      if (Ty->isFloatingPointTy() &&
+          F->getAttributes().getAttribute(AttributeSet::FunctionIndex,
+                                          "no-nans-fp-math")
+                  .getValueAsString() != "true")
+        return false;
+      break;
+    }
+    default:
       return false;
+    }
+
+    // The operands of a min/max idiom are used by its compare and its select.
+    unsigned NumUsesInTree = ReductionOpcode == Instruction::Select ? 2 : 1;
 
     // Post order traverse the reduction tree starting at B. We only handle true
-    // trees containing only binary operators.
-    SmallVector<std::pair<BinaryOperator *, unsigned>, 32> Stack;
+    // trees: every node but the root is used once by its parent.
+    SmallVector<std::pair<Instruction *, unsigned>, 32> Stack;
     Stack.push_back(std::make_pair(B, 0));
     while (!Stack.empty()) {
-      BinaryOperator *TreeN = Stack.back().first;
+      Instruction *TreeN = Stack.back().first;
       unsigned EdgeToVist = Stack.back().second++;
-      bool IsReducedValue = TreeN->getOpcode() != ReductionOpcode;
+      bool IsReducedValue = !isReductionOp(TreeN);
 
       // Only handle trees in the current basic block.
       if (TreeN->getParent() != B->getParent())
@@ -2675,7 +2770,7 @@ public:
 
       // Each tree node needs to have one user except for the ultimate
       // reduction.
-      if (!TreeN->hasOneUse() && TreeN != B)
+      if (TreeN != B && !TreeN->hasNUses(NumUsesInTree))
         return false;
 
       // Postorder vist.
@@ -2688,6 +2783,9 @@ public:
           else if (ReducedValueOpcode != TreeN->getOpcode())
             return false;
           ReducedVals.push_back(TreeN);
+        } else if (SelectInst *SI = dyn_cast<SelectInst>(TreeN)) {
+          ReductionOps.push_back(SI->getCondition());
+          ReductionOps.push_back(SI);
         } else {
           // We need to be able to reassociate the adds.
           if (!TreeN->isAssociative())
@@ -2700,24 +2798,30 @@ public:
       }
 
       // Visit left or right.
-      Value *NextV = TreeN->getOperand(EdgeToVist);
-      BinaryOperator *Next = dyn_cast<BinaryOperator>(NextV);
-      if (Next)
-        Stack.push_back(std::make_pair(Next, 0));
-      else if (NextV != Phi)
+      unsigned LHS = isa<SelectInst>(TreeN) ? 1 : 0;
+      Value *NextV = TreeN->getOperand(LHS + EdgeToVist);
+      if (NextV == Phi)
+        continue;
+      Instruction *Next = dyn_cast<Instruction>(NextV);
+      if (!Next)
         return false;
+      Stack.push_back(std::make_pair(Next, 0));
     }
     return true;
   }
 
   /// \brief Attempt to vectorize the tree found by
   /// matchAssociativeReduction.
+  ///
+  /// The reduced values are vectorized in groups of ReduxWidth, and what is
+  /// left over in narrower groups. Groups that are not profitable to vectorize
+  /// stay scalar, so a reduction can be partially vectorized.
   bool tryToReduce(BoUpSLP &V, TargetTransformInfo *TTI) {
     if (ReducedVals.empty())
       return false;
 
     unsigned NumReducedVals = ReducedVals.size();
-    if (NumReducedVals < ReduxWidth)
+    if (NumReducedVals < MinReduxWidth)
       return false;
 
     Value *VectorizedTree = nullptr;
@@ -2725,41 +2829,65 @@ public:
     FastMathFlags Unsafe;
     Unsafe.setUnsafeAlgebra();
     Builder.SetFastMathFlags(Unsafe);
+    SmallVector<Value *, 16> ScalarVals;
+    // The vectorized groups of one width are combined element-wise and only
+    // reduced horizontally once.
+    Value *VectorAcc = nullptr;
+    unsigned AccWidth = 0;
     unsigned i = 0;
 
-    for (; i < NumReducedVals - ReduxWidth + 1; i += ReduxWidth) {
-      ArrayRef<Value *> ValsToReduce(&ReducedVals[i], ReduxWidth);
+    while (i < NumReducedVals) {
+      unsigned Width =
+          std::min<unsigned>(ReduxWidth, PowerOf2Floor(NumReducedVals - i));
+      if (Width < MinReduxWidth)
+        break;
+
+      ArrayRef<Value *> ValsToReduce(&ReducedVals[i], Width);
+      i += Width;
       V.buildTree(ValsToReduce, ReductionOps);
 
       // Estimate cost.
-      int Cost = V.getTreeCost() + getReductionCost(TTI, ReducedVals[i]);
-      if (Cost >= -SLPCostThreshold)
-        break;
+      bool Accumulate = VectorAcc && AccWidth == Width;
+      int TreeCost = V.getTreeCost(true);
+      int Cost = TreeCost + getReductionCost(TTI, ValsToReduce, Accumulate);
+      if (TreeCost == INT_MAX || Cost >= -SLPCostThreshold) {
+        ScalarVals.append(ValsToReduce.begin(), ValsToReduce.end());
+        continue;
+      }
 
-      DEBUG(dbgs() << "SLP: Vectorizing horizontal reduction at cost:" << Cost
-                   << ". (HorRdx)\n");
+      DEBUG(dbgs() << "SLP: Vectorizing horizontal reduction of " << Width
+                   << " values at cost:" << Cost << ". (HorRdx)\n");
 
       // Vectorize a tree.
-      DebugLoc Loc = cast<Instruction>(ReducedVals[i])->getDebugLoc();
+      DebugLoc Loc = cast<Instruction>(ValsToReduce[0])->getDebugLoc();
       Value *VectorizedRoot = V.vectorizeTree();
+      Builder.SetCurrentDebugLocation(Loc);
+      if (Accumulate) {
+        VectorAcc = createOp(Builder, VectorAcc, VectorizedRoot, "bin.rdx");
+        continue;
+      }
 
-      // Emit a reduction.
-      Value *ReducedSubTree = emitReduction(VectorizedRoot, Builder);
-      if (VectorizedTree) {
-        Builder.SetCurrentDebugLocation(Loc);
-        VectorizedTree = createBinOp(Builder, ReductionOpcode, VectorizedTree,
-                                     ReducedSubTree, "bin.rdx");
-      } else
-        VectorizedTree = ReducedSubTree;
+      // Emit the reduction of the previous width.
+      if (VectorAcc) {
+        Value *Reduced = emitReduction(VectorAcc, AccWidth, Builder);
+        VectorizedTree = addToReduction(Builder, VectorizedTree, Reduced);
+      }
+      VectorAcc = VectorizedRoot;
+      AccWidth = Width;
+    }
+
+    if (VectorAcc) {
+      Value *Reduced = emitReduction(VectorAcc, AccWidth, Builder);
+      VectorizedTree = addToReduction(Builder, VectorizedTree, Reduced);
     }
 
     if (VectorizedTree) {
       // Finish the reduction.
-      for (; i < NumReducedVals; ++i) {
+      ScalarVals.append(ReducedVals.begin() + i, ReducedVals.end());
+      for (unsigned j = 0, e = ScalarVals.size(); j != e; ++j) {
         Builder.SetCurrentDebugLocation(
-          cast<Instruction>(ReducedVals[i])->getDebugLoc());
-        VectorizedTree = createBinOp(Builder, ReductionOpcode, VectorizedTree,
-                                     ReducedVals[i]);
+          cast<Instruction>(ScalarVals[j])->getDebugLoc());
+        VectorizedTree = createOp(Builder, VectorizedTree, ScalarVals[j]);
       }
       // Update users.
       if (ReductionPHI) {
@@ -2768,70 +2896,129 @@ public:
         ReductionRoot->setOperand(1, ReductionPHI);
       } else
         ReductionRoot->replaceAllUsesWith(VectorizedTree);
+
+      // Delete the scalar reduction, users first.
+      for (unsigned j = ReductionOps.size(); j != 0; --j) {
+        Instruction *I = cast<Instruction>(ReductionOps[j - 1]);
+        if (I->use_empty())
+          I->eraseFromParent();
+      }
     }
     return VectorizedTree != nullptr;
   }
 
 private:
 
-  /// \brief Calcuate the cost of a reduction.
-  int getReductionCost(TargetTransformInfo *TTI, Value *FirstReducedVal) {
-    Type *ScalarTy = FirstReducedVal->getType();
-    Type *VecTy = VectorType::get(ScalarTy, ReduxWidth);
-
-    int PairwiseRdxCost = TTI->getReductionCost(ReductionOpcode, VecTy, true);
-    int SplittingRdxCost = TTI->getReductionCost(ReductionOpcode, VecTy, false);
+  /// \returns true if \p I is one of the reduction operations, as opposed to
+  /// a reduced value.
+  bool isReductionOp(Instruction *I) const {
+    if (I->getOpcode() != ReductionOpcode)
+      return false;
+    return ReductionOpcode != Instruction::Select ||
+           getMinMaxPredicate(I) == MinMaxPred;
+  }
 
-    IsPairwiseReduction = PairwiseRdxCost < SplittingRdxCost;
-    int VecReduxCost = IsPairwiseReduction ? PairwiseRdxCost : SplittingRdxCost;
+  /// \brief Calcuate the cost of a reduction of \p Vals. If \p Accumulate is
+  /// set, the vector of \p Vals is combined with one that is reduced later,
+  /// which takes a single vector operation.
+  int getReductionCost(TargetTransformInfo *TTI, ArrayRef<Value *> Vals,
+                       bool Accumulate) {
+    unsigned Width = Vals.size();
+    Type *ScalarTy = Vals[0]->getType();
+    Type *VecTy = VectorType::get(ScalarTy, Width);
+
+    int PairwiseRdxCost, SplittingRdxCost, VecOpCost, ScalarOpCost;
+    if (ReductionOpcode == Instruction::Select) {
+      Type *ScalarCondTy = Type::getInt1Ty(ScalarTy->getContext());
+      Type *CondTy = VectorType::get(ScalarCondTy, Width);
+      PairwiseRdxCost = TTI->getMinMaxReductionCost(VecTy, CondTy, true);
+      SplittingRdxCost = TTI->getMinMaxReductionCost(VecTy, CondTy, false);
+      unsigned CmpOpcode = ScalarTy->isFloatingPointTy() ? Instruction::FCmp
+                                                         : Instruction::ICmp;
+      VecOpCost = TTI->getCmpSelInstrCost(CmpOpcode, VecTy, CondTy) +
+                  TTI->getCmpSelInstrCost(Instruction::Select, VecTy, CondTy);
+      ScalarOpCost =
+          TTI->getCmpSelInstrCost(CmpOpcode, ScalarTy, ScalarCondTy) +
+          TTI->getCmpSelInstrCost(Instruction::Select, ScalarTy, ScalarCondTy);
+    } else {
+      PairwiseRdxCost = TTI->getReductionCost(ReductionOpcode, VecTy, true);
+      SplittingRdxCost = TTI->getReductionCost(ReductionOpcode, VecTy, false);
+      VecOpCost = TTI->getArithmeticInstrCost(ReductionOpcode, VecTy);
+      ScalarOpCost = TTI->getArithmeticInstrCost(ReductionOpcode, ScalarTy);
+    }
 
-    int ScalarReduxCost =
-        ReduxWidth * TTI->getArithmeticInstrCost(ReductionOpcode, VecTy);
+    int VecReduxCost;
+    if (Accumulate) {
+      VecReduxCost = VecOpCost;
+    } else {
+      IsPairwiseReduction = PairwiseRdxCost < SplittingRdxCost;
+      VecReduxCost = IsPairwiseReduction ? PairwiseRdxCost : SplittingRdxCost;
+    }
+    int ScalarReduxCost = Width * ScalarOpCost;
 
     DEBUG(dbgs() << "SLP: Adding cost " << VecReduxCost - ScalarReduxCost
-                 << " for reduction that starts with " << *FirstReducedVal
-                 << " (It is a "
-                 << (IsPairwiseReduction ? "pairwise" : "splitting")
+                 << " for reduction that starts with " << *Vals[0]
+                 << " (It is " << (Accumulate ? "accumulated into a" : "a")
+                 << (IsPairwiseReduction ? " pairwise" : " splitting")
                  << " reduction)\n");
 
     return VecReduxCost - ScalarReduxCost;
   }
 
-  static Value *createBinOp(IRBuilder<> &Builder, unsigned Opcode, Value *L,
-                            Value *R, const Twine &Name = "") {
-    if (Opcode == Instruction::FAdd)
+  /// \brief Combine the partial result \p Val into \p Rdx, the reduction so
+  /// far, which may be null.
+  Value *addToReduction(IRBuilder<> &Builder, Value *Rdx, Value *Val) {
+    if (!Rdx)
+      return Val;
+    return createOp(Builder, Rdx, Val, "bin.rdx");
+  }
+
+  /// \brief Emit one reduction operation combining \p L and \p R.
+  Value *createOp(IRBuilder<> &Builder, Value *L, Value *R,
+                  const Twine &Name = "") {
+    if (ReductionOpcode == Instruction::Select) {
+      Value *Cmp = L->getType()->isFPOrFPVectorTy()
+                       ? Builder.CreateFCmp(MinMaxPred, L, R, "rdx.minmax.cmp")
+                       : Builder.CreateICmp(MinMaxPred, L, R, "rdx.minmax.cmp");
+      return Builder.CreateSelect(Cmp, L, R, Name);
+    }
+    if (ReductionOpcode == Instruction::FAdd)
       return Builder.CreateFAdd(L, R, Name);
-    return Builder.CreateBinOp((Instruction::BinaryOps)Opcode, L, R, Name);
+    if (ReductionOpcode == Instruction::FMul)
+      return Builder.CreateFMul(L, R, Name);
+    return Builder.CreateBinOp((Instruction::BinaryOps)ReductionOpcode, L, R,
+                               Name);
   }
 
-  /// \brief Emit a horizontal reduction of the vectorized value.
-  Value *emitReduction(Value *VectorizedValue, IRBuilder<> &Builder) {
+  /// \brief Emit a horizontal reduction of the vectorized value, which has
+  /// \p Width elements.
+  Value *emitReduction(Value *VectorizedValue, unsigned Width,
+                       IRBuilder<> &Builder) {
     assert(VectorizedValue && "Need to have a vectorized tree node");
     Instruction *ValToReduce = dyn_cast<Instruction>(VectorizedValue);
-    assert(isPowerOf2_32(ReduxWidth) &&
+    assert(isPowerOf2_32(Width) &&
            "We only handle power-of-two reductions for now");
 
     Value *TmpVec = ValToReduce;
-    for (unsigned i = ReduxWidth / 2; i != 0; i >>= 1) {
+    for (unsigned i = Width / 2; i != 0; i >>= 1) {
       if (IsPairwiseReduction) {
         Value *LeftMask =
-          createRdxShuffleMask(ReduxWidth, i, true, true, Builder);
+          createRdxShuffleMask(Width, i, true, true, Builder);
         Value *RightMask =
-          createRdxShuffleMask(ReduxWidth, i, true, false, Builder);
+          createRdxShuffleMask(Width, i, true, false, Builder);
 
         Value *LeftShuf = Builder.CreateShuffleVector(
           TmpVec, UndefValue::get(TmpVec->getType()), LeftMask, "rdx.shuf.l");
         Value *RightShuf = Builder.CreateShuffleVector(
           TmpVec, UndefValue::get(TmpVec->getType()), (RightMask),
           "rdx.shuf.r");
-        TmpVec = createBinOp(Builder, ReductionOpcode, LeftShuf, RightShuf,
-                             "bin.rdx");
+        TmpVec = createOp(Builder, LeftShuf, RightShuf, "bin.rdx");
       } else {
         Value *UpperHalf =
-          createRdxShuffleMask(ReduxWidth, i, false, false, Builder);
+          createRdxShuffleMask(Width, i, false, false, Builder);
         Value *Shuf = Builder.CreateShuffleVector(
           TmpVec, UndefValue::get(TmpVec->getType()), UpperHalf, "rdx.shuf");
-        TmpVec = createBinOp(Builder, ReductionOpcode, TmpVec, Shuf, "bin.rdx");
+        TmpVec = createOp(Builder, TmpVec, Shuf, "bin.rdx");
       }
     }
 
@@ -2954,22 +3141,26 @@ bool SLPVectorizer::vectorizeChainsInBlock(BasicBlock *BB, BoUpSLP &R) {
                ? (P->getIncomingValue(0))
                : (P->getIncomingBlock(1) == BB ? P->getIncomingValue(1)
                                                : nullptr));
+      // Try to match and vectorize a horizontal reduction, which may also be
+      // a min/max reduction.
+      Instruction *RdxI = dyn_cast_or_null<Instruction>(Rdx);
+      if (RdxI && (isa<BinaryOperator>(RdxI) || isa<SelectInst>(RdxI))) {
+        HorizontalReduction HorRdx;
+        if (ShouldVectorizeHor &&
+            HorRdx.matchAssociativeReduction(P, RdxI, DL) &&
+            HorRdx.tryToReduce(R, TTI)) {
+          Changed = true;
+          it = BB->begin();
+          e = BB->end();
+          continue;
+        }
+      }
+
       // Check if this is a Binary Operator.
       BinaryOperator *BI = dyn_cast_or_null<BinaryOperator>(Rdx);
       if (!BI)
         continue;
 
-      // Try to match and vectorize a horizontal reduction.
-      HorizontalReduction HorRdx;
-      if (ShouldVectorizeHor &&
-          HorRdx.matchAssociativeReduction(P, BI, DL) &&
-          HorRdx.tryToReduce(R, TTI)) {
-        Changed = true;
-        it = BB->begin();
-        e = BB->end();
-        continue;
-      }
-
      Value *Inst = BI->getOperand(0);
       if (Inst == P)
         Inst = BI->getOperand(1);
@@ -3002,6 +3193,22 @@ bool SLPVectorizer::vectorizeChainsInBlock(BasicBlock *BB, BoUpSLP &R) {
           }
         }
 
+    // Try to vectorize horizontal reductions whose result is returned.
+    if (ShouldVectorizeHor)
+      if (ReturnInst *RI = dyn_cast<ReturnInst>(it))
+        if (Instruction *Root =
+                dyn_cast_or_null<Instruction>(RI->getReturnValue()))
+          if (isa<BinaryOperator>(Root) || isa<SelectInst>(Root)) {
+            HorizontalReduction HorRdx;
+            if (HorRdx.matchAssociativeReduction(nullptr, Root, DL) &&
+                HorRdx.tryToReduce(R, TTI)) {
+              Changed = true;
+              it = BB->begin();
+              e = BB->end();
+              continue;
+            }
+          }
+
     // Try to vectorize trees that start at compare instructions.
     if (CmpInst *CI = dyn_cast<CmpInst>(it)) {
       if (tryToVectorizePair(CI->getOperand(0), CI->getOperand(1), R)) {
@@ -3061,12 +3268,7 @@ bool SLPVectorizer::vectorizeStoreChains(BoUpSLP &R) {
     DEBUG(dbgs() << "SLP: Analyzing a store chain of length "
           << it->second.size() << ".\n");
 
-    // Process the stores in chunks of 16.
-    for (unsigned CI = 0, CE = it->second.size(); CI < CE; CI+=16) {
-      unsigned Len = std::min<unsigned>(CE - CI, 16);
-      ArrayRef<StoreInst *> Chunk(&it->second[CI], Len);
-      Changed |= vectorizeStores(Chunk, -SLPCostThreshold, R);
-    }
+    Changed |= vectorizeStores(it->second, -SLPCostThreshold, R);
   }
   return Changed;
 }
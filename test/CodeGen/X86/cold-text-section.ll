@@ -0,0 +1,38 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu | FileCheck %s -check-prefix=DEFAULT
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -cold-text-section | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -cold-text-section -function-sections | FileCheck %s -check-prefix=SECTIONS
+
+; With -cold-text-section, functions marked cold go to .text.unlikely, away
+; from the hot code.  By default they stay in .text.
+
+; DEFAULT: .text
+; DEFAULT-NOT: .section
+; DEFAULT: cold:
+; DEFAULT-NOT: .section
+; DEFAULT: hot2:
+
+; CHECK: .text
+; CHECK-LABEL: hot:
+; CHECK: .section .text.unlikely,"ax",@progbits
+; CHECK-LABEL: cold:
+; CHECK: .text
+; CHECK-LABEL: hot2:
+
+; SECTIONS: .section .text.hot,"ax",@progbits
+; SECTIONS-LABEL: hot:
+; SECTIONS: .section .text.unlikely.cold,"ax",@progbits
+; SECTIONS-LABEL: cold:
+; SECTIONS: .section .text.hot2,"ax",@progbits
+; SECTIONS-LABEL: hot2:
+
+define void @hot() {
+  ret void
+}
+
+define void @cold() cold {
+  ret void
+}
+
+define void @hot2() {
+  ret void
+}
@@ -0,0 +1,43 @@
+; RUN: llc < %s -O0 -mtriple=x86_64-unknown-linux-gnu | FileCheck %s -check-prefix=DEFAULT
+; RUN: llc < %s -O0 -mtriple=x86_64-unknown-linux-gnu -fast-regalloc-local-liveness | FileCheck %s -check-prefix=LOCAL
+
+; %b is copied out of %esi into a virtual register that is never used. Without
+; local liveness the fast allocator still spills it at the end of the block;
+; with it the register is known to be dead there and the store is dropped.
+define i32 @unused(i32 %a, i32 %b) nounwind {
+; DEFAULT-LABEL: unused:
+; DEFAULT: movl %esi, -4(%rsp) # 4-byte Spill
+; DEFAULT: retq
+; LOCAL-LABEL: unused:
+; LOCAL-NOT: Spill
+; LOCAL: retq
+entry:
+  %c = shl i32 %a, 3
+  ret i32 %c
+}
+
+; %b and %c are used in other blocks, so both spills must stay.
+define i32 @liveout(i32 %a, i32 %b, i1 %f) nounwind {
+; DEFAULT-LABEL: liveout:
+; DEFAULT-DAG: movl %esi, [[B:-[0-9]+\(%rsp\)]] # 4-byte Spill
+; DEFAULT-DAG: movl %edi, [[C:-[0-9]+\(%rsp\)]] # 4-byte Spill
+; DEFAULT: jne
+; DEFAULT: movl [[C]], %eax # 4-byte Reload
+; DEFAULT: movl [[B]], %ecx # 4-byte Reload
+; LOCAL-LABEL: liveout:
+; LOCAL-DAG: movl %esi, [[B:-[0-9]+\(%rsp\)]] # 4-byte Spill
+; LOCAL-DAG: movl %edi, [[C:-[0-9]+\(%rsp\)]] # 4-byte Spill
+; LOCAL: jne
+; LOCAL: movl [[C]], %eax # 4-byte Reload
+; LOCAL: movl [[B]], %ecx # 4-byte Reload
+entry:
+  %c = shl i32 %a, 3
+  br i1 %f, label %then, label %exit
+
+then:
+  %d = add i32 %c, %b
+  ret i32 %d
+
+exit:
+  ret i32 %c
+}
@@ -0,0 +1,53 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -regalloc=greedy -greedy-report-regions -o /dev/null 2>&1 | FileCheck %s
+
+; -greedy-report-regions only reports how independent the blocks of a
+; function are; it doesn't change how registers are allocated.
+
+@g = global i32 0
+@h = global i32 0
+
+; Every block loads and stores its own values, so no virtual register is live
+; across a block boundary. The condition is used by the branch in the entry
+; block only.
+; CHECK: Allocation regions for three_regions: 4 virtual registers in 3 regions, largest has 2
+
+define void @three_regions(i1 %c) {
+entry:
+  %a = load i32* @g
+  %a2 = mul i32 %a, %a
+  store i32 %a2, i32* @g
+  br i1 %c, label %then, label %exit
+
+then:
+  %b = load i32* @h
+  %b2 = mul i32 %b, %b
+  store i32 %b2, i32* @h
+  br label %exit
+
+exit:
+  %d = load i32* @g
+  %d2 = add i32 %d, 1
+  store i32 %d2, i32* @h
+  ret void
+}
+
+; The induction variable and the sum join the loop to the blocks around it.
+; CHECK: Allocation regions for loop: 4 virtual registers in 1 regions, largest has 4
+
+define i32 @loop(i32* %p, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %q = getelementptr i32* %p, i32 %i
+  %v = load i32* %q
+  %s.next = add i32 %s, %v
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %s.next
+}
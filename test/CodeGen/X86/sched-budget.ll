@@ -0,0 +1,23 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -enable-misched \
+; RUN:   -misched-max-region-instrs=4 -pass-remarks-analysis=misched \
+; RUN:   -o /dev/null 2>&1 | FileCheck %s -check-prefix=MISCHED
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -pre-RA-sched-max-nodes=8 \
+; RUN:   -pass-remarks-analysis=isel -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s -check-prefix=ISEL
+;
+; Regions and blocks over the scheduling budget are left in source order.
+
+; MISCHED: remark: {{.*}}scheduling region left in source order: {{[0-9]+}} instructions is more than the limit of 4
+; ISEL: remark: {{.*}}block 'entry' has {{[0-9]+}} nodes, more than the scheduler limit of 8; linearizing it
+
+define i32 @f(i32* %p, i32 %a, i32 %b) {
+entry:
+  %x = load i32* %p
+  %m = mul i32 %x, %a
+  %s = add i32 %m, %b
+  %y = getelementptr i32* %p, i64 1
+  %z = load i32* %y
+  %t = sub i32 %s, %z
+  %u = xor i32 %t, %a
+  ret i32 %u
+}
@@ -0,0 +1,48 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.serial \
+// RUN:   -elf-parallel-write-threshold=0
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.parallel \
+// RUN:   -elf-parallel-write-threshold=1 -elf-parallel-write-threads=4
+// RUN: cmp %t.serial %t.parallel
+// RUN: llvm-readobj -s -sd %t.parallel | FileCheck %s
+
+// Sections rendered on worker threads must come out exactly as when they are
+// written directly, including nop and fill padding.  The thread count is
+// forced so that the sections are spread over several threads even on a
+// host with a single core.
+
+    .text
+f0:
+    .long 0
+    .align  8, 0x00000090
+    .long 0
+    .align  8
+
+    .data
+    .long 0x11223344
+    .align  8, 0x00000090
+    .fill 4, 1, 0xaa
+
+    .section .rodata,"a",@progbits
+    .quad 0x0102030405060708
+    .zero 3
+
+    .section .text.other,"ax",@progbits
+    .byte 0xc3
+    .align  4
+
+// CHECK:        Name: .text
+// CHECK:        SectionData (
+// CHECK-NEXT:     0000: 00000000 0F1F4000 00000000 0F1F4000
+// CHECK-NEXT:   )
+// CHECK:        Name: .data
+// CHECK:        SectionData (
+// CHECK-NEXT:     0000: 44332211 90909090 AAAAAAAA
+// CHECK-NEXT:   )
+// CHECK:        Name: .rodata
+// CHECK:        SectionData (
+// CHECK-NEXT:     0000: 08070605 04030201 000000
+// CHECK-NEXT:   )
+// CHECK:        Name: .text.other
+// CHECK:        SectionData (
+// CHECK-NEXT:     0000: C30F1F00
+// CHECK-NEXT:   )
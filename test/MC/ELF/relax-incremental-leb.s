@@ -0,0 +1,27 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.full \
+// RUN:   -mc-incremental-relaxation=false
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.incr
+// RUN: cmp %t.full %t.incr
+// RUN: llvm-readobj -s -sd %t.incr | FileCheck %s
+
+// The first sweep encodes the distance from .Lstart to .Lend, 128, in two
+// bytes and then relaxes the jump.  That moves .Lstart forward, the
+// alignment padding absorbs it, and the next sweep shrinks the ULEB128 to
+// one byte: a fragment that is resized by a negative delta.
+
+    .text
+    .uleb128 .Lend - .Lstart
+    .p2align 4
+    .fill 110, 1, 0x90
+    jmp .Lfar
+.Lstart:
+    .fill 20, 1, 0x90
+    .p2align 8
+.Lend:
+    .fill 200, 1, 0x90
+.Lfar:
+
+// CHECK:      Name: .text
+// CHECK:      SectionData (
+// CHECK-NEXT:   0000: 7D666666 6666662E 0F1F8400 00000000
+// CHECK:        0070: 90909090 90909090 90909090 9090E945
@@ -0,0 +1,20 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o /dev/null \
+// RUN:   -stats 2>&1 | FileCheck %s
+// REQUIRES: asserts
+
+// The ULEB128 grows in the first sweep and shrinks in the second; the jump
+// grows in the first.  Each resized fragment is counted once.
+
+    .text
+    .uleb128 .Lend - .Lstart
+    .p2align 4
+    .fill 110, 1, 0x90
+    jmp .Lfar
+.Lstart:
+    .fill 20, 1, 0x90
+    .p2align 8
+.Lend:
+    .fill 200, 1, 0x90
+.Lfar:
+
+// CHECK: 2 assembler - Number of resized fragments whose section wasn't laid out again until the end of a sweep
@@ -0,0 +1,26 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.full \
+// RUN:   -mc-incremental-relaxation=false
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.incr
+// RUN: cmp %t.full %t.incr
+// RUN: llvm-readobj -s -sd %t.incr | FileCheck %s
+
+// Relaxing the first jump pushes the second one's target out of range.  The
+// offsets seen later in the same sweep are adjusted for the growth, so both
+// are relaxed in one sweep, with the same result as sweeping until nothing
+// changes.
+
+    .text
+.Lback:
+    .fill 60, 1, 0x90
+    jmp .Lfar
+    .fill 64, 1, 0x90
+    jmp .Lback
+    .fill 200, 1, 0x90
+.Lfar:
+
+// CHECK:      Name: .text
+// CHECK:      Size: 334
+// CHECK:      SectionData (
+// CHECK:        0030: 90909090 90909090 90909090 E90D0100
+// CHECK-NEXT:   0040: 00909090
+// CHECK:        0080: 90E97AFF FFFF9090
@@ -0,0 +1,44 @@
+; REQUIRES: asserts
+; RUN: opt -correlated-propagation -lvi-max-cache-entries=1 -stats -S < %s 2>&1 | FileCheck %s
+
+; Every query on %a is over the limit of one cached block value. The values of
+; %b, queried before, are evicted, but %a keeps what was learned from the
+; branches on it, so the third branch on %a still folds after the first two
+; branches have been replaced by constants.
+
+define i32 @test1(i32 %a, i32 %b) nounwind {
+  %a.off = add i32 %a, -8
+  %cmp = icmp ult i32 %a.off, 8
+  br i1 %cmp, label %then, label %else
+
+then:
+  %bcmp = icmp eq i32 %b, 0
+  %dead = icmp eq i32 %a, 7
+  br i1 %dead, label %end, label %next
+
+next:
+  %dead2 = icmp ugt i32 %a, 15
+  br i1 %dead2, label %end, label %last
+
+last:
+  %dead3 = icmp ult i32 %a, 8
+  br i1 %dead3, label %end, label %else
+
+else:
+  ret i32 1
+
+end:
+  %r = select i1 %bcmp, i32 2, i32 3
+  ret i32 %r
+
+; CHECK-LABEL: @test1(
+; CHECK: then:
+; CHECK: br i1 false, label %end, label %next
+; CHECK: next:
+; CHECK-NEXT: br i1 false, label %end, label %last
+; CHECK: last:
+; CHECK-NEXT: br i1 false, label %end, label %else
+}
+
+; CHECK: 5 lazy-value-info - Number of value queries
+; CHECK: 2 lazy-value-info - Number of values evicted from the cache
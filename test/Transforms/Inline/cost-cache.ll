@@ -0,0 +1,41 @@
+; REQUIRES: asserts
+; RUN: opt -S -inline -stats < %s 2>&1 | FileCheck %s
+; RUN: opt -S -inline -inline-cost-cache-size=0 -stats < %s 2>&1 | FileCheck -check-prefix=NOCACHE %s
+
+; The calls to @callee that pass the same constant look the same to the cost
+; analysis, so only the first of them is analyzed.
+
+define i32 @callee(i32 %x) {
+entry:
+  %c = icmp eq i32 %x, 0
+  br i1 %c, label %zero, label %nonzero
+
+zero:
+  ret i32 0
+
+nonzero:
+  %y = mul i32 %x, %x
+  %z = add i32 %y, 1
+  ret i32 %z
+}
+
+define i32 @caller(i32 %a) {
+; CHECK-LABEL: @caller(
+; CHECK-NOT: call i32 @callee
+; CHECK: ret i32
+entry:
+  %r1 = call i32 @callee(i32 1)
+  %r2 = call i32 @callee(i32 1)
+  %r3 = call i32 @callee(i32 1)
+  %r4 = call i32 @callee(i32 %a)
+  %s1 = add i32 %r1, %r2
+  %s2 = add i32 %s1, %r3
+  %s3 = add i32 %s2, %r4
+  ret i32 %s3
+}
+
+; CHECK: 4 inline - Number of functions inlined
+; CHECK: 2 inline-cost - Number of inline costs reused from the cache
+
+; NOCACHE: 4 inline - Number of functions inlined
+; NOCACHE-NOT: reused from the cache
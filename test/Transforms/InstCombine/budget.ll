@@ -0,0 +1,24 @@
+; RUN: opt < %s -instcombine -S | FileCheck %s
+; RUN: opt < %s -instcombine -instcombine-max-visits=1 -S | FileCheck -check-prefix=VISITS %s
+; RUN: opt < %s -instcombine -instcombine-max-visits=1 -pass-remarks-analysis=instcombine -disable-output 2>&1 | FileCheck -check-prefix=REMARK %s
+; RUN: opt < %s -instcombine -instcombine-report=- -disable-output 2>&1 | FileCheck -check-prefix=REPORT %s
+; RUN: rm -f %t
+; RUN: opt < %s -instcombine -instcombine-report=%t -disable-output
+; RUN: FileCheck -check-prefix=REPORT %s < %t
+
+define i32 @test1(i32 %x) {
+  %a = add i32 %x, 0
+  %b = mul i32 %a, 1
+  ret i32 %b
+; CHECK-LABEL: @test1(
+; CHECK-NEXT: ret i32 %x
+
+; Only the add is visited before the budget runs out.
+; VISITS-LABEL: @test1(
+; VISITS-NEXT: %b = mul i32 %x, 1
+; VISITS-NEXT: ret i32 %b
+}
+
+; REMARK: remark: {{.*}} function left partly combined: it used up its budget after 1 iterations and 1 instruction visits
+
+; REPORT: {"function": "test1", "iterations": 2, "visits": {{[0-9]+}}, "revisits": {{[0-9]+}}, "dead": {{[0-9]+}}, "constfolds": 0, "overbudget": false, "combines": {"add": 1, "mul": 1}}
@@ -0,0 +1,218 @@
+; RUN: opt < %s -loop-vectorize -mcpu=core-avx2 -force-vector-width=4 -force-vector-unroll=1 -enable-interleaved-mem-accesses -S | FileCheck %s
+; RUN: opt < %s -loop-vectorize -mcpu=core-avx2 -force-vector-width=4 -force-vector-unroll=1 -S | FileCheck %s --check-prefix=DISABLED
+; RUN: opt < %s -loop-vectorize -mcpu=core-avx2 -enable-interleaved-mem-accesses -S | FileCheck %s --check-prefix=AVX2
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; Groups of strided accesses that together cover every element of a range are
+; vectorized as one wide load or store and shuffles.
+
+; for (i = 0; i < 1024; ++i)
+;   Out[i] = In[2*i] + In[2*i+1];
+
+; CHECK-LABEL: @load_factor2(
+; CHECK: %wide.vec = load <8 x i32>* %{{.*}}, align 4
+; CHECK: shufflevector <8 x i32> %wide.vec, <8 x i32> undef, <4 x i32> <i32 0, i32 2, i32 4, i32 6>
+; CHECK: shufflevector <8 x i32> %wide.vec, <8 x i32> undef, <4 x i32> <i32 1, i32 3, i32 5, i32 7>
+; CHECK: add nsw <4 x i32>
+; CHECK: store <4 x i32>
+
+; DISABLED-LABEL: @load_factor2(
+; DISABLED-NOT: %wide.vec
+; DISABLED: ret void
+
+; The cost model picks the interleaved loads on AVX2.
+; AVX2-LABEL: @load_factor2(
+; AVX2: %wide.vec = load <{{[0-9]+}} x i32>
+; AVX2: ret void
+
+define void @load_factor2(i32* noalias nocapture %In, i32* noalias nocapture %Out) {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %for.body ]
+  %idx0 = shl nsw i64 %i, 1
+  %idx1 = or i64 %idx0, 1
+  %p0 = getelementptr inbounds i32* %In, i64 %idx0
+  %p1 = getelementptr inbounds i32* %In, i64 %idx1
+  %v0 = load i32* %p0, align 4
+  %v1 = load i32* %p1, align 4
+  %sum = add nsw i32 %v0, %v1
+  %pout = getelementptr inbounds i32* %Out, i64 %i
+  store i32 %sum, i32* %pout, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, 1024
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; for (i = 0; i < 1024; ++i) {
+;   RGB[3*i] = R[i]; RGB[3*i+1] = G[i]; RGB[3*i+2] = B[i];
+; }
+
+; CHECK-LABEL: @store_factor3(
+; CHECK: %interleaved.vec = shufflevector <12 x float> %{{.*}}, <12 x float> undef, <12 x i32> <i32 0, i32 4, i32 8, i32 1, i32 5, i32 9, i32 2, i32 6, i32 10, i32 3, i32 7, i32 11>
+; CHECK: store <12 x float> %interleaved.vec, <12 x float>* %{{.*}}, align 4
+; CHECK-NOT: store float
+; CHECK: br i1
+
+; AVX2 merges a group of three element by element, which is no faster than
+; the scalar loop, so the cost model leaves it alone.  Unrolling it would
+; interleave the stores of several iterations, so it isn't unrolled either.
+; AVX2-LABEL: @store_factor3(
+; AVX2-NOT: x float>
+; AVX2: store float
+; AVX2: store float
+; AVX2: store float
+; AVX2-NOT: store float
+; AVX2: ret void
+
+define void @store_factor3(float* noalias nocapture %RGB, float* noalias nocapture %R, float* noalias nocapture %G, float* noalias nocapture %B) {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %for.body ]
+  %pr = getelementptr inbounds float* %R, i64 %i
+  %r = load float* %pr, align 4
+  %pg = getelementptr inbounds float* %G, i64 %i
+  %g = load float* %pg, align 4
+  %pb = getelementptr inbounds float* %B, i64 %i
+  %b = load float* %pb, align 4
+  %idx0 = mul nsw i64 %i, 3
+  %idx1 = add nsw i64 %idx0, 1
+  %idx2 = add nsw i64 %idx0, 2
+  %p0 = getelementptr inbounds float* %RGB, i64 %idx0
+  store float %r, float* %p0, align 4
+  %p1 = getelementptr inbounds float* %RGB, i64 %idx1
+  store float %g, float* %p1, align 4
+  %p2 = getelementptr inbounds float* %RGB, i64 %idx2
+  store float %b, float* %p2, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, 1024
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; Fields of an array of structs updated in place. The loads of the second
+; field move above the store to the first, and the store to the first field
+; moves below the load of the second: neither ever touches the other's
+; memory.
+;
+; for (i = 0; i < 1024; ++i) {
+;   P[i].x += 1; P[i].y *= 3;
+; }
+
+; CHECK-LABEL: @update_in_place(
+; CHECK: %wide.vec = load <8 x i32>* %{{.*}}, align 4
+; CHECK: %[[X:.*]] = shufflevector <8 x i32> %wide.vec, <8 x i32> undef, <4 x i32> <i32 0, i32 2, i32 4, i32 6>
+; CHECK: %[[Y:.*]] = shufflevector <8 x i32> %wide.vec, <8 x i32> undef, <4 x i32> <i32 1, i32 3, i32 5, i32 7>
+; CHECK: add nsw <4 x i32> %[[X]], <i32 1, i32 1, i32 1, i32 1>
+; CHECK: mul nsw <4 x i32> %[[Y]], <i32 3, i32 3, i32 3, i32 3>
+; CHECK: %interleaved.vec = shufflevector <8 x i32> %{{.*}}, <8 x i32> undef, <8 x i32> <i32 0, i32 4, i32 1, i32 5, i32 2, i32 6, i32 3, i32 7>
+; CHECK: store <8 x i32> %interleaved.vec, <8 x i32>* %{{.*}}, align 4
+
+%struct.pair = type { i32, i32 }
+
+define void @update_in_place(%struct.pair* noalias nocapture %P) {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %for.body ]
+  %px = getelementptr inbounds %struct.pair* %P, i64 %i, i32 0
+  %x = load i32* %px, align 4
+  %x.inc = add nsw i32 %x, 1
+  store i32 %x.inc, i32* %px, align 4
+  %py = getelementptr inbounds %struct.pair* %P, i64 %i, i32 1
+  %y = load i32* %py, align 4
+  %y.mul = mul nsw i32 %y, 3
+  store i32 %y.mul, i32* %py, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, 1024
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; A load group may skip members in the middle: the alpha channel is loaded
+; but not used.
+;
+; for (i = 0; i < 1024; ++i)
+;   Out[i] = RGBA[4*i] + RGBA[4*i+1] + RGBA[4*i+3];
+
+; CHECK-LABEL: @load_factor4_gap(
+; CHECK: %wide.vec = load <16 x i32>* %{{.*}}, align 4
+; CHECK: shufflevector <16 x i32> %wide.vec, <16 x i32> undef, <4 x i32> <i32 0, i32 4, i32 8, i32 12>
+; CHECK: shufflevector <16 x i32> %wide.vec, <16 x i32> undef, <4 x i32> <i32 1, i32 5, i32 9, i32 13>
+; CHECK-NOT: <i32 2, i32 6, i32 10, i32 14>
+; CHECK: shufflevector <16 x i32> %wide.vec, <16 x i32> undef, <4 x i32> <i32 3, i32 7, i32 11, i32 15>
+
+define void @load_factor4_gap(i32* noalias nocapture %RGBA, i32* noalias nocapture %Out) {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %for.body ]
+  %idx0 = shl nsw i64 %i, 2
+  %idx1 = or i64 %idx0, 1
+  %idx3 = or i64 %idx0, 3
+  %p0 = getelementptr inbounds i32* %RGBA, i64 %idx0
+  %p1 = getelementptr inbounds i32* %RGBA, i64 %idx1
+  %p3 = getelementptr inbounds i32* %RGBA, i64 %idx3
+  %v0 = load i32* %p0, align 4
+  %v1 = load i32* %p1, align 4
+  %v3 = load i32* %p3, align 4
+  %s0 = add nsw i32 %v0, %v1
+  %s1 = add nsw i32 %s0, %v3
+  %pout = getelementptr inbounds i32* %Out, i64 %i
+  store i32 %s1, i32* %pout, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, 1024
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; A wide store would overwrite the field in the gap, so stores with a gap are
+; not grouped.
+;
+; for (i = 0; i < 1024; ++i) {
+;   A[3*i] = X[i]; A[3*i+2] = Y[i];
+; }
+
+; CHECK-LABEL: @store_gap(
+; CHECK-NOT: %interleaved.vec
+; CHECK: ret void
+
+define void @store_gap(i32* noalias nocapture %A, i32* noalias nocapture %X, i32* noalias nocapture %Y) {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %for.body ]
+  %px = getelementptr inbounds i32* %X, i64 %i
+  %x = load i32* %px, align 4
+  %py = getelementptr inbounds i32* %Y, i64 %i
+  %y = load i32* %py, align 4
+  %idx0 = mul nsw i64 %i, 3
+  %idx2 = add nsw i64 %idx0, 2
+  %p0 = getelementptr inbounds i32* %A, i64 %idx0
+  store i32 %x, i32* %p0, align 4
+  %p2 = getelementptr inbounds i32* %A, i64 %idx2
+  store i32 %y, i32* %p2, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, 1024
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
@@ -0,0 +1,120 @@
+; RUN: opt < %s -loop-vectorize -mcpu=core-avx2 -enable-epilogue-vectorization -S | FileCheck %s
+; RUN: opt < %s -loop-vectorize -mcpu=core-avx2 -S | FileCheck %s --check-prefix=DISABLED
+; RUN: opt < %s -loop-vectorize -mcpu=core-avx2 -enable-epilogue-vectorization -pass-remarks=loop-vectorize -S -o /dev/null 2>&1 | FileCheck %s --check-prefix=REMARK
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; The vector body handles 32 iterations at a time. Whatever is left over, and
+; trip counts too small for the vector body, run through a second vector loop
+; of 8 lanes before the scalar loop.
+
+; CHECK-LABEL: @saxpy(
+; CHECK: vector.body:
+; CHECK: store <8 x float>
+; CHECK: store <8 x float>
+; CHECK: store <8 x float>
+; CHECK: store <8 x float>
+; CHECK: middle.block:
+; CHECK: scalar.ph:
+; CHECK: vector.body{{[0-9]+}}:
+; CHECK: store <8 x float>
+; CHECK-NOT: store <8 x float>
+; CHECK: middle.block{{[0-9]+}}:
+; CHECK: for.body:
+; CHECK: scalar.exit:
+; CHECK: ret void
+
+; DISABLED-LABEL: @saxpy(
+; DISABLED-NOT: vector.body{{[0-9]+}}:
+; DISABLED: ret void
+
+; REMARK: remark: <unknown>:0:0: vectorized loop (vectorization factor: 8, unrolling interleave factor: 4)
+; REMARK: remark: <unknown>:0:0: vectorized loop remainder (vectorization factor: 8)
+
+define void @saxpy(float* noalias nocapture %y, float* noalias nocapture readonly %x, float %a, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %px = getelementptr inbounds float* %x, i64 %i
+  %vx = load float* %px, align 4
+  %mul = fmul float %vx, %a
+  %py = getelementptr inbounds float* %y, i64 %i
+  %vy = load float* %py, align 4
+  %add = fadd float %mul, %vy
+  store float %add, float* %py, align 4
+  %i.next = add nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; Reductions continue from the vector body into the remainder's vector loop,
+; and from there into the scalar loop.
+
+; CHECK-LABEL: @sum(
+; CHECK: vector.body:
+; CHECK: add <8 x i32>
+; CHECK: scalar.ph:
+; CHECK: %[[RDX:.*]] = phi i32 [ 0, %entry ], [ %{{.*}}, %middle.block ]
+; CHECK: vector.body{{[0-9]+}}:
+; CHECK: add <8 x i32>
+; CHECK: scalar.ph{{[0-9]+}}:
+; CHECK: %[[RDX2:.*]] = phi i32 [ %[[RDX]], %scalar.ph ], [ %{{.*}}, %middle.block{{[0-9]+}} ]
+; CHECK: for.body:
+; CHECK: phi i32 [ %s.next, %for.body ], [ %[[RDX2]], %scalar.ph{{[0-9]+}} ]
+; CHECK: scalar.exit:
+; CHECK: %[[EXIT:.*]] = phi i32 [ %s.next, %for.body ], [ %{{.*}}, %middle.block{{[0-9]+}} ]
+; CHECK: for.end:
+; CHECK: phi i32 [ %[[EXIT]], %scalar.exit ], [ %{{.*}}, %middle.block ]
+
+define i32 @sum(i32* nocapture readonly %x, i64 %n) {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %s = phi i32 [ %s.next, %for.body ], [ 0, %entry ]
+  %px = getelementptr inbounds i32* %x, i64 %i
+  %vx = load i32* %px, align 4
+  %s.next = add i32 %vx, %s
+  %i.next = add nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret i32 %s.next
+}
+
+; A trip count that is a multiple of the vector body's leaves no remainder
+; to vectorize.
+
+; CHECK-LABEL: @no_remainder(
+; CHECK: vector.body:
+; CHECK-NOT: vector.body{{[0-9]+}}:
+; CHECK: ret void
+
+define void @no_remainder(float* noalias nocapture %y, float* noalias nocapture readonly %x) {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %px = getelementptr inbounds float* %x, i64 %i
+  %vx = load float* %px, align 4
+  %py = getelementptr inbounds float* %y, i64 %i
+  %vy = load float* %py, align 4
+  %add = fadd float %vx, %vy
+  store float %add, float* %py, align 4
+  %i.next = add nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, 1024
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
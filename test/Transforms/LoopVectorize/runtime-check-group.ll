@@ -0,0 +1,178 @@
+; RUN: opt < %s -loop-vectorize -force-vector-unroll=1 -force-vector-width=4 -S | FileCheck %s
+; RUN: opt < %s -loop-vectorize -force-vector-unroll=1 -force-vector-width=4 -runtime-memory-check-threshold=2 -pass-remarks-analysis=loop-vectorize -S -o /dev/null 2>&1 | FileCheck %s --check-prefix=LIMIT
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; Accesses to the same array at constant distances are checked as one range.
+; Every pair of pointers would need 9 comparisons here; the three ranges of B,
+; C and D only need one comparison each against A.
+;
+; void stencil(int *A, int *B, int *C, int *D, long n) {
+;   for (long i = 0; i < n; ++i)
+;     A[i] = B[i] + B[i+1] + B[i+2] + C[i] + C[i+1] + C[i+2] +
+;            D[i] + D[i+1] + D[i+2];
+; }
+
+; CHECK-LABEL: @stencil(
+; CHECK: %found.conflict = and i1
+; CHECK: %found.conflict{{[0-9]+}} = and i1
+; CHECK: %found.conflict{{[0-9]+}} = and i1
+; CHECK-NOT: %found.conflict{{[0-9]*}} = and i1
+; CHECK: vector.memcheck:
+; CHECK: br i1 %memcheck.conflict, label %middle.block, label %vector.ph
+; CHECK: load <4 x i32>
+
+; LIMIT: remark: <unknown>:0:0: loop not vectorized: 3 exceeds limit of 2 dependent memory operations checked at runtime
+
+define void @stencil(i32* %A, i32* %B, i32* %C, i32* %D, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %i1 = add nsw i64 %i, 1
+  %i2 = add nsw i64 %i, 2
+  %pb0 = getelementptr inbounds i32* %B, i64 %i
+  %pb1 = getelementptr inbounds i32* %B, i64 %i1
+  %pb2 = getelementptr inbounds i32* %B, i64 %i2
+  %pc0 = getelementptr inbounds i32* %C, i64 %i
+  %pc1 = getelementptr inbounds i32* %C, i64 %i1
+  %pc2 = getelementptr inbounds i32* %C, i64 %i2
+  %pd0 = getelementptr inbounds i32* %D, i64 %i
+  %pd1 = getelementptr inbounds i32* %D, i64 %i1
+  %pd2 = getelementptr inbounds i32* %D, i64 %i2
+  %b0 = load i32* %pb0, align 4
+  %b1 = load i32* %pb1, align 4
+  %b2 = load i32* %pb2, align 4
+  %c0 = load i32* %pc0, align 4
+  %c1 = load i32* %pc1, align 4
+  %c2 = load i32* %pc2, align 4
+  %d0 = load i32* %pd0, align 4
+  %d1 = load i32* %pd1, align 4
+  %d2 = load i32* %pd2, align 4
+  %s1 = add i32 %b0, %b1
+  %s2 = add i32 %s1, %b2
+  %s3 = add i32 %s2, %c0
+  %s4 = add i32 %s3, %c1
+  %s5 = add i32 %s4, %c2
+  %s6 = add i32 %s5, %d0
+  %s7 = add i32 %s6, %d1
+  %s8 = add i32 %s7, %d2
+  %pa = getelementptr inbounds i32* %A, i64 %i
+  store i32 %s8, i32* %pa, align 4
+  %i.next = add nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; A pointer that walks down the address space is checked from the end it
+; reaches last up to the one it starts at.
+;
+; void reverse(int *A, int *B, long n) {
+;   for (long i = 0; i < n; ++i)
+;     A[n - i] = B[i];
+; }
+
+; CHECK-LABEL: @reverse(
+; CHECK: %[[ALOW:.*]] = getelementptr i32* %A, i64 1
+; CHECK: %[[ALOWC:.*]] = bitcast i32* %[[ALOW]] to i8*
+; CHECK: %[[AHIGH:.*]] = getelementptr i32* %A, i64 %n
+; CHECK: %[[AHIGHC:.*]] = bitcast i32* %[[AHIGH]] to i8*
+; CHECK: %[[BHIGH:.*]] = bitcast i32* %{{.*}} to i8*
+; CHECK: %bound0 = icmp ule i8* %[[ALOWC]], %[[BHIGH]]
+; CHECK: %bound1 = icmp ule i8* %{{.*}}, %[[AHIGHC]]
+
+define void @reverse(i32* %A, i32* %B, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %pb = getelementptr inbounds i32* %B, i64 %i
+  %v = load i32* %pb, align 4
+  %j = sub nsw i64 %n, %i
+  %pa = getelementptr inbounds i32* %A, i64 %j
+  store i32 %v, i32* %pa, align 4
+  %i.next = add nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; Ten distinct arrays, one written and nine read, need nine comparisons, which
+; is within the default limit.
+;
+; void sum9(int *A, int *B, int *C, int *D, int *E, int *F, int *G, int *H,
+;           int *I, int *J, long n) {
+;   for (long i = 0; i < n; ++i)
+;     A[i] = B[i] + C[i] + D[i] + E[i] + F[i] + G[i] + H[i] + I[i] + J[i];
+; }
+
+; CHECK-LABEL: @sum9(
+; CHECK: %found.conflict = and i1
+; CHECK: %found.conflict{{[0-9]+}} = and i1
+; CHECK: %found.conflict{{[0-9]+}} = and i1
+; CHECK: %found.conflict{{[0-9]+}} = and i1
+; CHECK: %found.conflict{{[0-9]+}} = and i1
+; CHECK: %found.conflict{{[0-9]+}} = and i1
+; CHECK: %found.conflict{{[0-9]+}} = and i1
+; CHECK: %found.conflict{{[0-9]+}} = and i1
+; CHECK: %found.conflict{{[0-9]+}} = and i1
+; CHECK-NOT: %found.conflict{{[0-9]*}} = and i1
+; CHECK: vector.memcheck:
+; CHECK: vector.body:
+; CHECK: store <4 x i32>
+
+; LIMIT: remark: <unknown>:0:0: loop not vectorized: 9 exceeds limit of 2 dependent memory operations checked at runtime
+
+define void @sum9(i32* %A, i32* %B, i32* %C, i32* %D, i32* %E, i32* %F,
+                  i32* %G, i32* %H, i32* %I, i32* %J, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %pb = getelementptr inbounds i32* %B, i64 %i
+  %pc = getelementptr inbounds i32* %C, i64 %i
+  %pd = getelementptr inbounds i32* %D, i64 %i
+  %pe = getelementptr inbounds i32* %E, i64 %i
+  %pf = getelementptr inbounds i32* %F, i64 %i
+  %pg = getelementptr inbounds i32* %G, i64 %i
+  %ph = getelementptr inbounds i32* %H, i64 %i
+  %pi = getelementptr inbounds i32* %I, i64 %i
+  %pj = getelementptr inbounds i32* %J, i64 %i
+  %b = load i32* %pb, align 4
+  %c = load i32* %pc, align 4
+  %d = load i32* %pd, align 4
+  %e = load i32* %pe, align 4
+  %f = load i32* %pf, align 4
+  %g = load i32* %pg, align 4
+  %h = load i32* %ph, align 4
+  %v = load i32* %pi, align 4
+  %j = load i32* %pj, align 4
+  %s1 = add i32 %b, %c
+  %s2 = add i32 %s1, %d
+  %s3 = add i32 %s2, %e
+  %s4 = add i32 %s3, %f
+  %s5 = add i32 %s4, %g
+  %s6 = add i32 %s5, %h
+  %s7 = add i32 %s6, %v
+  %s8 = add i32 %s7, %j
+  %pa = getelementptr inbounds i32* %A, i64 %i
+  store i32 %s8, i32* %pa, align 4
+  %i.next = add nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
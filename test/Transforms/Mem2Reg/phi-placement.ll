@@ -0,0 +1,63 @@
+; RUN: opt -mem2reg -S < %s | FileCheck %s
+; RUN: opt -mem2reg -mem2reg-max-frontier-entries=0 -S < %s | FileCheck %s
+
+; A state machine: a loop around a switch where each case updates one of the
+; variables. Each variable needs a phi in the latch, where the cases meet, and
+; one in the loop header. The loop can also be left from the switch, so %exit
+; needs a phi for %a. %b is stored before it is loaded in %exit, so it needs
+; none there.
+
+; CHECK-LABEL: @state_machine(
+; CHECK: loop:
+; CHECK-DAG: %a.0 = phi i32 [ 0, %entry ], [ %a.1, %latch ]
+; CHECK-DAG: %b.0 = phi i32 [ 0, %entry ], [ %b.1, %latch ]
+; CHECK: case.a:
+; CHECK-NOT: phi
+; CHECK: latch:
+; CHECK-DAG: %a.1 = phi i32 [ %a.0, %loop ], [ %a.0, %case.b ], [ %a.next, %case.a ]
+; CHECK-DAG: %b.1 = phi i32 [ %b.0, %loop ], [ %b.next, %case.b ], [ %b.0, %case.a ]
+; CHECK: exit:
+; CHECK-NEXT: %a.2 = phi i32 [ %a.1, %latch ], [ %a.0, %loop ]
+; CHECK-NOT: phi
+; CHECK: add i32 %a.2, %i
+
+define i32 @state_machine(i32* %in, i32 %n) {
+entry:
+  %a = alloca i32
+  %b = alloca i32
+  store i32 0, i32* %a
+  store i32 0, i32* %b
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %p = getelementptr i32* %in, i32 %i
+  %s = load i32* %p
+  switch i32 %s, label %latch [ i32 0, label %case.a
+                                i32 1, label %case.b
+                                i32 -1, label %exit ]
+
+case.a:
+  %a.old = load i32* %a
+  %a.next = add i32 %a.old, %s
+  store i32 %a.next, i32* %a
+  br label %latch
+
+case.b:
+  %b.old = load i32* %b
+  %b.next = mul i32 %b.old, %s
+  store i32 %b.next, i32* %b
+  br label %latch
+
+latch:
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  store i32 %i, i32* %b
+  %b.final = load i32* %b
+  %a.final = load i32* %a
+  %r = add i32 %a.final, %b.final
+  ret i32 %r
+}
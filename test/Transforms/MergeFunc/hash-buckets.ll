@@ -0,0 +1,48 @@
+; REQUIRES: asserts
+; RUN: opt < %s -mergefunc -stats -disable-output 2>&1 | FileCheck %s
+
+; These functions differ only in one opcode, so their structural hashes
+; differ and they are told apart without a full comparison.  Only @twin1 and
+; @twin2 have to be compared, and are merged.  The function tree needs two
+; comparisons, one in each direction, to find that they are equal.
+
+; CHECK: 2 mergefunc - Number of full function comparisons
+; CHECK: 1 mergefunc - Number of functions merged
+
+define i32 @add(i32 %x, i32 %y) {
+  %a = add i32 %x, %y
+  %b = mul i32 %a, %y
+  ret i32 %b
+}
+
+define i32 @sub(i32 %x, i32 %y) {
+  %a = sub i32 %x, %y
+  %b = mul i32 %a, %y
+  ret i32 %b
+}
+
+define i32 @xor(i32 %x, i32 %y) {
+  %a = xor i32 %x, %y
+  %b = mul i32 %a, %y
+  ret i32 %b
+}
+
+define i32 @and(i32 %x, i32 %y) {
+  %a = and i32 %x, %y
+  %b = mul i32 %a, %y
+  ret i32 %b
+}
+
+define i32 @twin1(i32 %x, i32 %y) {
+  %a = or i32 %x, %y
+  %b = mul i32 %a, %y
+  %c = add i32 %b, 7
+  ret i32 %c
+}
+
+define i32 @twin2(i32 %x, i32 %y) {
+  %a = or i32 %x, %y
+  %b = mul i32 %a, %y
+  %c = add i32 %b, 7
+  ret i32 %c
+}
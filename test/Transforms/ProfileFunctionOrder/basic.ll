@@ -0,0 +1,33 @@
+; RUN: llvm-profdata merge %S/Inputs/basic.proftext -o %t.profdata
+; RUN: opt < %s -profile-function-order -function-order-profile=%t.profdata -S | FileCheck %s
+
+; Profiled functions come first, hottest first, then the functions without
+; profile data in their original order, then the ones never entered, which
+; are also marked cold.
+
+; CHECK: define void @hot()
+; CHECK: define void @warm()
+; CHECK: define void @unprofiled1()
+; CHECK: define void @unprofiled2()
+; CHECK: define void @never() [[COLD:#[0-9]+]]
+; CHECK: attributes [[COLD]] = { cold }
+
+define void @never() {
+  ret void
+}
+
+define void @unprofiled1() {
+  ret void
+}
+
+define void @warm() {
+  ret void
+}
+
+define void @unprofiled2() {
+  ret void
+}
+
+define void @hot() {
+  ret void
+}
@@ -0,0 +1,314 @@
+; RUN: opt -slp-vectorizer -slp-vectorize-hor -S < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7-avx | FileCheck %s
+; RUN: opt -slp-vectorizer -S < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7-avx | FileCheck %s --check-prefix=NOHOR
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; Horizontal reductions of loads whose result is returned. Vectors of the same
+; width are combined element-wise before a single horizontal reduction.
+;
+; int add8(int *p) { return p[0] + p[1] + ... + p[7]; }
+
+; CHECK-LABEL: @add8(
+; CHECK: %[[V0:.*]] = load <4 x i32>*
+; CHECK: %[[V1:.*]] = load <4 x i32>*
+; CHECK: %bin.rdx = add <4 x i32> %[[V0]], %[[V1]]
+; CHECK: shufflevector <4 x i32> %bin.rdx, <4 x i32> undef, <4 x i32> <i32 2, i32 3, i32 undef, i32 undef>
+; CHECK: shufflevector <4 x i32> %{{.*}}, <4 x i32> undef, <4 x i32> <i32 1, i32 undef, i32 undef, i32 undef>
+; CHECK: %[[R:.*]] = extractelement <4 x i32> %{{.*}}, i32 0
+; CHECK-NOT: add i32
+; CHECK: ret i32 %[[R]]
+
+; NOHOR-LABEL: @add8(
+; NOHOR-NOT: <4 x i32>
+; NOHOR: ret i32
+
+define i32 @add8(i32* %p) {
+entry:
+  %g0 = getelementptr inbounds i32* %p, i64 0
+  %v0 = load i32* %g0, align 4
+  %g1 = getelementptr inbounds i32* %p, i64 1
+  %v1 = load i32* %g1, align 4
+  %g2 = getelementptr inbounds i32* %p, i64 2
+  %v2 = load i32* %g2, align 4
+  %g3 = getelementptr inbounds i32* %p, i64 3
+  %v3 = load i32* %g3, align 4
+  %g4 = getelementptr inbounds i32* %p, i64 4
+  %v4 = load i32* %g4, align 4
+  %g5 = getelementptr inbounds i32* %p, i64 5
+  %v5 = load i32* %g5, align 4
+  %g6 = getelementptr inbounds i32* %p, i64 6
+  %v6 = load i32* %g6, align 4
+  %g7 = getelementptr inbounds i32* %p, i64 7
+  %v7 = load i32* %g7, align 4
+  %r1 = add i32 %v0, %v1
+  %r2 = add i32 %r1, %v2
+  %r3 = add i32 %r2, %v3
+  %r4 = add i32 %r3, %v4
+  %r5 = add i32 %r4, %v5
+  %r6 = add i32 %r5, %v6
+  %r7 = add i32 %r6, %v7
+  ret i32 %r7
+}
+
+; Values that do not fill a vector are added as scalars.
+
+; CHECK-LABEL: @add_i16(
+; CHECK: load <4 x i16>*
+; CHECK: %[[V4:.*]] = load i16*
+; CHECK: %[[R:.*]] = extractelement <4 x i16> %{{.*}}, i32 0
+; CHECK: add i16 %[[R]], %[[V4]]
+
+define i16 @add_i16(i16* %p) {
+entry:
+  %g0 = getelementptr inbounds i16* %p, i64 0
+  %v0 = load i16* %g0, align 2
+  %g1 = getelementptr inbounds i16* %p, i64 1
+  %v1 = load i16* %g1, align 2
+  %g2 = getelementptr inbounds i16* %p, i64 2
+  %v2 = load i16* %g2, align 2
+  %g3 = getelementptr inbounds i16* %p, i64 3
+  %v3 = load i16* %g3, align 2
+  %g4 = getelementptr inbounds i16* %p, i64 4
+  %v4 = load i16* %g4, align 2
+  %r1 = add i16 %v0, %v1
+  %r2 = add i16 %r1, %v2
+  %r3 = add i16 %r2, %v3
+  %r4 = add i16 %r3, %v4
+  ret i16 %r4
+}
+
+; CHECK-LABEL: @xor4(
+; CHECK: load <4 x i32>*
+; CHECK: xor <4 x i32>
+; CHECK: xor <4 x i32>
+; CHECK: extractelement <4 x i32>
+
+define i32 @xor4(i32* %p) {
+entry:
+  %g0 = getelementptr inbounds i32* %p, i64 0
+  %v0 = load i32* %g0, align 4
+  %g1 = getelementptr inbounds i32* %p, i64 1
+  %v1 = load i32* %g1, align 4
+  %g2 = getelementptr inbounds i32* %p, i64 2
+  %v2 = load i32* %g2, align 4
+  %g3 = getelementptr inbounds i32* %p, i64 3
+  %v3 = load i32* %g3, align 4
+  %r1 = xor i32 %v0, %v1
+  %r2 = xor i32 %r1, %v2
+  %r3 = xor i32 %r2, %v3
+  ret i32 %r3
+}
+
+; Min/max reductions are selects of the operands of the compare controlling
+; them.
+;
+; int smax8(int *p) {
+;   int m = p[0];
+;   for (int i = 1; i < 8; ++i)
+;     m = m > p[i] ? m : p[i];
+;   return m;
+; }
+
+; CHECK-LABEL: @smax8(
+; CHECK: %[[V0:.*]] = load <4 x i32>*
+; CHECK: %[[V1:.*]] = load <4 x i32>*
+; CHECK: %rdx.minmax.cmp = icmp sgt <4 x i32> %[[V0]], %[[V1]]
+; CHECK: %bin.rdx = select <4 x i1> %rdx.minmax.cmp, <4 x i32> %[[V0]], <4 x i32> %[[V1]]
+; CHECK: icmp sgt <4 x i32>
+; CHECK: select <4 x i1>
+; CHECK: icmp sgt <4 x i32>
+; CHECK: select <4 x i1>
+; CHECK: %[[R:.*]] = extractelement <4 x i32> %{{.*}}, i32 0
+; CHECK-NOT: icmp sgt i32
+; CHECK: ret i32 %[[R]]
+
+define i32 @smax8(i32* %p) {
+entry:
+  %g0 = getelementptr inbounds i32* %p, i64 0
+  %v0 = load i32* %g0, align 4
+  %g1 = getelementptr inbounds i32* %p, i64 1
+  %v1 = load i32* %g1, align 4
+  %g2 = getelementptr inbounds i32* %p, i64 2
+  %v2 = load i32* %g2, align 4
+  %g3 = getelementptr inbounds i32* %p, i64 3
+  %v3 = load i32* %g3, align 4
+  %g4 = getelementptr inbounds i32* %p, i64 4
+  %v4 = load i32* %g4, align 4
+  %g5 = getelementptr inbounds i32* %p, i64 5
+  %v5 = load i32* %g5, align 4
+  %g6 = getelementptr inbounds i32* %p, i64 6
+  %v6 = load i32* %g6, align 4
+  %g7 = getelementptr inbounds i32* %p, i64 7
+  %v7 = load i32* %g7, align 4
+  %c1 = icmp sgt i32 %v0, %v1
+  %m1 = select i1 %c1, i32 %v0, i32 %v1
+  %c2 = icmp sgt i32 %m1, %v2
+  %m2 = select i1 %c2, i32 %m1, i32 %v2
+  %c3 = icmp sgt i32 %m2, %v3
+  %m3 = select i1 %c3, i32 %m2, i32 %v3
+  %c4 = icmp sgt i32 %m3, %v4
+  %m4 = select i1 %c4, i32 %m3, i32 %v4
+  %c5 = icmp sgt i32 %m4, %v5
+  %m5 = select i1 %c5, i32 %m4, i32 %v5
+  %c6 = icmp sgt i32 %m5, %v6
+  %m6 = select i1 %c6, i32 %m5, i32 %v6
+  %c7 = icmp sgt i32 %m6, %v7
+  %m7 = select i1 %c7, i32 %m6, i32 %v7
+  ret i32 %m7
+}
+
+; CHECK-LABEL: @umin4(
+; CHECK: load <4 x i32>*
+; CHECK: icmp ult <4 x i32>
+; CHECK: icmp ult <4 x i32>
+; CHECK: extractelement <4 x i32>
+
+define i32 @umin4(i32* %p) {
+entry:
+  %g0 = getelementptr inbounds i32* %p, i64 0
+  %v0 = load i32* %g0, align 4
+  %g1 = getelementptr inbounds i32* %p, i64 1
+  %v1 = load i32* %g1, align 4
+  %g2 = getelementptr inbounds i32* %p, i64 2
+  %v2 = load i32* %g2, align 4
+  %g3 = getelementptr inbounds i32* %p, i64 3
+  %v3 = load i32* %g3, align 4
+  %c1 = icmp ult i32 %v0, %v1
+  %m1 = select i1 %c1, i32 %v0, i32 %v1
+  %c2 = icmp ult i32 %m1, %v2
+  %m2 = select i1 %c2, i32 %m1, i32 %v2
+  %c3 = icmp ult i32 %m2, %v3
+  %m3 = select i1 %c3, i32 %m2, i32 %v3
+  ret i32 %m3
+}
+
+; Floating point min/max reductions may only be reassociated without NaNs.
+
+; CHECK-LABEL: @fmax8(
+; CHECK: fcmp ogt <4 x float>
+; CHECK: select <4 x i1>
+; CHECK: extractelement <4 x float>
+
+; CHECK-LABEL: @fmax8_nans(
+; CHECK-NOT: <4 x float>
+; CHECK: ret float
+
+define float @fmax8(float* %p) #0 {
+entry:
+  %g0 = getelementptr inbounds float* %p, i64 0
+  %v0 = load float* %g0, align 4
+  %g1 = getelementptr inbounds float* %p, i64 1
+  %v1 = load float* %g1, align 4
+  %g2 = getelementptr inbounds float* %p, i64 2
+  %v2 = load float* %g2, align 4
+  %g3 = getelementptr inbounds float* %p, i64 3
+  %v3 = load float* %g3, align 4
+  %g4 = getelementptr inbounds float* %p, i64 4
+  %v4 = load float* %g4, align 4
+  %g5 = getelementptr inbounds float* %p, i64 5
+  %v5 = load float* %g5, align 4
+  %g6 = getelementptr inbounds float* %p, i64 6
+  %v6 = load float* %g6, align 4
+  %g7 = getelementptr inbounds float* %p, i64 7
+  %v7 = load float* %g7, align 4
+  %c1 = fcmp ogt float %v0, %v1
+  %m1 = select i1 %c1, float %v0, float %v1
+  %c2 = fcmp ogt float %m1, %v2
+  %m2 = select i1 %c2, float %m1, float %v2
+  %c3 = fcmp ogt float %m2, %v3
+  %m3 = select i1 %c3, float %m2, float %v3
+  %c4 = fcmp ogt float %m3, %v4
+  %m4 = select i1 %c4, float %m3, float %v4
+  %c5 = fcmp ogt float %m4, %v5
+  %m5 = select i1 %c5, float %m4, float %v5
+  %c6 = fcmp ogt float %m5, %v6
+  %m6 = select i1 %c6, float %m5, float %v6
+  %c7 = fcmp ogt float %m6, %v7
+  %m7 = select i1 %c7, float %m6, float %v7
+  ret float %m7
+}
+
+define float @fmax8_nans(float* %p) {
+entry:
+  %g0 = getelementptr inbounds float* %p, i64 0
+  %v0 = load float* %g0, align 4
+  %g1 = getelementptr inbounds float* %p, i64 1
+  %v1 = load float* %g1, align 4
+  %g2 = getelementptr inbounds float* %p, i64 2
+  %v2 = load float* %g2, align 4
+  %g3 = getelementptr inbounds float* %p, i64 3
+  %v3 = load float* %g3, align 4
+  %g4 = getelementptr inbounds float* %p, i64 4
+  %v4 = load float* %g4, align 4
+  %g5 = getelementptr inbounds float* %p, i64 5
+  %v5 = load float* %g5, align 4
+  %g6 = getelementptr inbounds float* %p, i64 6
+  %v6 = load float* %g6, align 4
+  %g7 = getelementptr inbounds float* %p, i64 7
+  %v7 = load float* %g7, align 4
+  %c1 = fcmp ogt float %v0, %v1
+  %m1 = select i1 %c1, float %v0, float %v1
+  %c2 = fcmp ogt float %m1, %v2
+  %m2 = select i1 %c2, float %m1, float %v2
+  %c3 = fcmp ogt float %m2, %v3
+  %m3 = select i1 %c3, float %m2, float %v3
+  %c4 = fcmp ogt float %m3, %v4
+  %m4 = select i1 %c4, float %m3, float %v4
+  %c5 = fcmp ogt float %m4, %v5
+  %m5 = select i1 %c5, float %m4, float %v5
+  %c6 = fcmp ogt float %m5, %v6
+  %m6 = select i1 %c6, float %m5, float %v6
+  %c7 = fcmp ogt float %m6, %v7
+  %m7 = select i1 %c7, float %m6, float %v7
+  ret float %m7
+}
+
+; A min/max reduction into a phi.
+;
+; for (i = 0; i < n; ++i)
+;   m = max(m, max(max(max(p[4*i], p[4*i+1]), p[4*i+2]), p[4*i+3]));
+
+; CHECK-LABEL: @smax_loop(
+; CHECK: %m = phi i32 [ 0, %entry ], [ %m4, %loop ]
+; CHECK: load <4 x i32>*
+; CHECK: %[[R:.*]] = extractelement <4 x i32> %{{.*}}, i32 0
+; CHECK: %c4 = icmp sgt i32 %m, %[[R]]
+; CHECK: %m4 = select i1 %c4, i32 %m, i32 %[[R]]
+
+define i32 @smax_loop(i32* %p, i64 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %m = phi i32 [ 0, %entry ], [ %m4, %loop ]
+  %base = shl i64 %i, 2
+  %g0 = getelementptr inbounds i32* %p, i64 %base
+  %v0 = load i32* %g0, align 4
+  %i1 = or i64 %base, 1
+  %g1 = getelementptr inbounds i32* %p, i64 %i1
+  %v1 = load i32* %g1, align 4
+  %i2 = or i64 %base, 2
+  %g2 = getelementptr inbounds i32* %p, i64 %i2
+  %v2 = load i32* %g2, align 4
+  %i3 = or i64 %base, 3
+  %g3 = getelementptr inbounds i32* %p, i64 %i3
+  %v3 = load i32* %g3, align 4
+  %c1 = icmp sgt i32 %v0, %v1
+  %m1 = select i1 %c1, i32 %v0, i32 %v1
+  %c2 = icmp sgt i32 %m1, %v2
+  %m2 = select i1 %c2, i32 %m1, i32 %v2
+  %c3 = icmp sgt i32 %m2, %v3
+  %m3 = select i1 %c3, i32 %m2, i32 %v3
+  %c4 = icmp sgt i32 %m, %m3
+  %m4 = select i1 %c4, i32 %m, i32 %m3
+  %i.next = add i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %m4
+}
+
+attributes #0 = { "no-nans-fp-math"="true" }
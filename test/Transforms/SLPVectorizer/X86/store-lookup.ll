@@ -0,0 +1,193 @@
+; RUN: opt -basicaa -slp-vectorizer -S < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7-avx | FileCheck %s
+; RUN: opt -basicaa -slp-vectorizer -slp-max-store-lookup=8 -S < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7-avx | FileCheck %s --check-prefix=SHORT
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; The stores to the even elements come before the stores to the odd ones, so
+; every store is 16 stores away from the next consecutive one. The chain is
+; only found if the search for consecutive stores looks that far.
+;
+; for (i = 0; i < 32; i += 2) A[i] = B[i] + i;
+; for (i = 1; i < 32; i += 2) A[i] = B[i] + i;   // fully unrolled
+
+; CHECK-LABEL: @evens_then_odds(
+; CHECK: store <4 x i32>
+; CHECK: store <4 x i32>
+; CHECK: store <4 x i32>
+; CHECK: store <4 x i32>
+; CHECK: store <4 x i32>
+; CHECK: store <4 x i32>
+; CHECK: store <4 x i32>
+; CHECK: store <4 x i32>
+; CHECK-NOT: store i32
+; CHECK: ret void
+
+; SHORT-LABEL: @evens_then_odds(
+; SHORT-NOT: store <4 x i32>
+; SHORT: ret void
+
+define void @evens_then_odds(i32* noalias %A, i32* noalias %B) {
+entry:
+  %pb0 = getelementptr inbounds i32* %B, i64 0
+  %b0 = load i32* %pb0, align 4
+  %x0 = add i32 %b0, 0
+  %pa0 = getelementptr inbounds i32* %A, i64 0
+  store i32 %x0, i32* %pa0, align 4
+  %pb2 = getelementptr inbounds i32* %B, i64 2
+  %b2 = load i32* %pb2, align 4
+  %x2 = add i32 %b2, 2
+  %pa2 = getelementptr inbounds i32* %A, i64 2
+  store i32 %x2, i32* %pa2, align 4
+  %pb4 = getelementptr inbounds i32* %B, i64 4
+  %b4 = load i32* %pb4, align 4
+  %x4 = add i32 %b4, 4
+  %pa4 = getelementptr inbounds i32* %A, i64 4
+  store i32 %x4, i32* %pa4, align 4
+  %pb6 = getelementptr inbounds i32* %B, i64 6
+  %b6 = load i32* %pb6, align 4
+  %x6 = add i32 %b6, 6
+  %pa6 = getelementptr inbounds i32* %A, i64 6
+  store i32 %x6, i32* %pa6, align 4
+  %pb8 = getelementptr inbounds i32* %B, i64 8
+  %b8 = load i32* %pb8, align 4
+  %x8 = add i32 %b8, 8
+  %pa8 = getelementptr inbounds i32* %A, i64 8
+  store i32 %x8, i32* %pa8, align 4
+  %pb10 = getelementptr inbounds i32* %B, i64 10
+  %b10 = load i32* %pb10, align 4
+  %x10 = add i32 %b10, 10
+  %pa10 = getelementptr inbounds i32* %A, i64 10
+  store i32 %x10, i32* %pa10, align 4
+  %pb12 = getelementptr inbounds i32* %B, i64 12
+  %b12 = load i32* %pb12, align 4
+  %x12 = add i32 %b12, 12
+  %pa12 = getelementptr inbounds i32* %A, i64 12
+  store i32 %x12, i32* %pa12, align 4
+  %pb14 = getelementptr inbounds i32* %B, i64 14
+  %b14 = load i32* %pb14, align 4
+  %x14 = add i32 %b14, 14
+  %pa14 = getelementptr inbounds i32* %A, i64 14
+  store i32 %x14, i32* %pa14, align 4
+  %pb16 = getelementptr inbounds i32* %B, i64 16
+  %b16 = load i32* %pb16, align 4
+  %x16 = add i32 %b16, 16
+  %pa16 = getelementptr inbounds i32* %A, i64 16
+  store i32 %x16, i32* %pa16, align 4
+  %pb18 = getelementptr inbounds i32* %B, i64 18
+  %b18 = load i32* %pb18, align 4
+  %x18 = add i32 %b18, 18
+  %pa18 = getelementptr inbounds i32* %A, i64 18
+  store i32 %x18, i32* %pa18, align 4
+  %pb20 = getelementptr inbounds i32* %B, i64 20
+  %b20 = load i32* %pb20, align 4
+  %x20 = add i32 %b20, 20
+  %pa20 = getelementptr inbounds i32* %A, i64 20
+  store i32 %x20, i32* %pa20, align 4
+  %pb22 = getelementptr inbounds i32* %B, i64 22
+  %b22 = load i32* %pb22, align 4
+  %x22 = add i32 %b22, 22
+  %pa22 = getelementptr inbounds i32* %A, i64 22
+  store i32 %x22, i32* %pa22, align 4
+  %pb24 = getelementptr inbounds i32* %B, i64 24
+  %b24 = load i32* %pb24, align 4
+  %x24 = add i32 %b24, 24
+  %pa24 = getelementptr inbounds i32* %A, i64 24
+  store i32 %x24, i32* %pa24, align 4
+  %pb26 = getelementptr inbounds i32* %B, i64 26
+  %b26 = load i32* %pb26, align 4
+  %x26 = add i32 %b26, 26
+  %pa26 = getelementptr inbounds i32* %A, i64 26
+  store i32 %x26, i32* %pa26, align 4
+  %pb28 = getelementptr inbounds i32* %B, i64 28
+  %b28 = load i32* %pb28, align 4
+  %x28 = add i32 %b28, 28
+  %pa28 = getelementptr inbounds i32* %A, i64 28
+  store i32 %x28, i32* %pa28, align 4
+  %pb30 = getelementptr inbounds i32* %B, i64 30
+  %b30 = load i32* %pb30, align 4
+  %x30 = add i32 %b30, 30
+  %pa30 = getelementptr inbounds i32* %A, i64 30
+  store i32 %x30, i32* %pa30, align 4
+  %pb1 = getelementptr inbounds i32* %B, i64 1
+  %b1 = load i32* %pb1, align 4
+  %x1 = add i32 %b1, 1
+  %pa1 = getelementptr inbounds i32* %A, i64 1
+  store i32 %x1, i32* %pa1, align 4
+  %pb3 = getelementptr inbounds i32* %B, i64 3
+  %b3 = load i32* %pb3, align 4
+  %x3 = add i32 %b3, 3
+  %pa3 = getelementptr inbounds i32* %A, i64 3
+  store i32 %x3, i32* %pa3, align 4
+  %pb5 = getelementptr inbounds i32* %B, i64 5
+  %b5 = load i32* %pb5, align 4
+  %x5 = add i32 %b5, 5
+  %pa5 = getelementptr inbounds i32* %A, i64 5
+  store i32 %x5, i32* %pa5, align 4
+  %pb7 = getelementptr inbounds i32* %B, i64 7
+  %b7 = load i32* %pb7, align 4
+  %x7 = add i32 %b7, 7
+  %pa7 = getelementptr inbounds i32* %A, i64 7
+  store i32 %x7, i32* %pa7, align 4
+  %pb9 = getelementptr inbounds i32* %B, i64 9
+  %b9 = load i32* %pb9, align 4
+  %x9 = add i32 %b9, 9
+  %pa9 = getelementptr inbounds i32* %A, i64 9
+  store i32 %x9, i32* %pa9, align 4
+  %pb11 = getelementptr inbounds i32* %B, i64 11
+  %b11 = load i32* %pb11, align 4
+  %x11 = add i32 %b11, 11
+  %pa11 = getelementptr inbounds i32* %A, i64 11
+  store i32 %x11, i32* %pa11, align 4
+  %pb13 = getelementptr inbounds i32* %B, i64 13
+  %b13 = load i32* %pb13, align 4
+  %x13 = add i32 %b13, 13
+  %pa13 = getelementptr inbounds i32* %A, i64 13
+  store i32 %x13, i32* %pa13, align 4
+  %pb15 = getelementptr inbounds i32* %B, i64 15
+  %b15 = load i32* %pb15, align 4
+  %x15 = add i32 %b15, 15
+  %pa15 = getelementptr inbounds i32* %A, i64 15
+  store i32 %x15, i32* %pa15, align 4
+  %pb17 = getelementptr inbounds i32* %B, i64 17
+  %b17 = load i32* %pb17, align 4
+  %x17 = add i32 %b17, 17
+  %pa17 = getelementptr inbounds i32* %A, i64 17
+  store i32 %x17, i32* %pa17, align 4
+  %pb19 = getelementptr inbounds i32* %B, i64 19
+  %b19 = load i32* %pb19, align 4
+  %x19 = add i32 %b19, 19
+  %pa19 = getelementptr inbounds i32* %A, i64 19
+  store i32 %x19, i32* %pa19, align 4
+  %pb21 = getelementptr inbounds i32* %B, i64 21
+  %b21 = load i32* %pb21, align 4
+  %x21 = add i32 %b21, 21
+  %pa21 = getelementptr inbounds i32* %A, i64 21
+  store i32 %x21, i32* %pa21, align 4
+  %pb23 = getelementptr inbounds i32* %B, i64 23
+  %b23 = load i32* %pb23, align 4
+  %x23 = add i32 %b23, 23
+  %pa23 = getelementptr inbounds i32* %A, i64 23
+  store i32 %x23, i32* %pa23, align 4
+  %pb25 = getelementptr inbounds i32* %B, i64 25
+  %b25 = load i32* %pb25, align 4
+  %x25 = add i32 %b25, 25
+  %pa25 = getelementptr inbounds i32* %A, i64 25
+  store i32 %x25, i32* %pa25, align 4
+  %pb27 = getelementptr inbounds i32* %B, i64 27
+  %b27 = load i32* %pb27, align 4
+  %x27 = add i32 %b27, 27
+  %pa27 = getelementptr inbounds i32* %A, i64 27
+  store i32 %x27, i32* %pa27, align 4
+  %pb29 = getelementptr inbounds i32* %B, i64 29
+  %b29 = load i32* %pb29, align 4
+  %x29 = add i32 %b29, 29
+  %pa29 = getelementptr inbounds i32* %A, i64 29
+  store i32 %x29, i32* %pa29, align 4
+  %pb31 = getelementptr inbounds i32* %B, i64 31
+  %b31 = load i32* %pb31, align 4
+  %x31 = add i32 %b31, 31
+  %pa31 = getelementptr inbounds i32* %A, i64 31
+  store i32 %x31, i32* %pa31, align 4
+  ret void
+}
@@ -14,6 +14,7 @@
 #include "gtest/gtest.h"
 #include "llvm/ADT/FoldingSet.h"
 #include <string>
+#include <vector>
 
 using namespace llvm;
 
@@ -35,5 +36,42 @@ TEST(FoldingSetTest, UnalignedStringTest) {
   EXPECT_EQ(a.ComputeHash(), b.ComputeHash());
 }
 
+struct TrivialNode : FoldingSetNode {
+  unsigned Value;
+  explicit TrivialNode(unsigned Value) : Value(Value) {}
+  void Profile(FoldingSetNodeID &ID) const { ID.AddInteger(Value); }
+};
+
+TEST(FoldingSetTest, ClearShrinksBuckets) {
+  // clear() leaves the removed nodes alone, so each node is inserted once.
+  std::vector<TrivialNode> Nodes;
+  for (unsigned i = 0; i != 1003; ++i)
+    Nodes.push_back(TrivialNode(i));
+
+  FoldingSet<TrivialNode> Set;
+  unsigned InitialCapacity = Set.capacity();
+  for (unsigned i = 0; i != 1000; ++i)
+    Set.InsertNode(&Nodes[i]);
+  unsigned FullCapacity = Set.capacity();
+  EXPECT_LE(1000u, FullCapacity);
+
+  // Clearing a full set keeps its buckets for the next round.
+  Set.clear();
+  EXPECT_TRUE(Set.empty());
+  EXPECT_EQ(FullCapacity, Set.capacity());
+
+  // Clearing a set that only holds a few nodes gives the memory back.
+  Set.InsertNode(&Nodes[1000]);
+  Set.InsertNode(&Nodes[1001]);
+  Set.clear();
+  EXPECT_EQ(InitialCapacity, Set.capacity());
+
+  Set.InsertNode(&Nodes[1002]);
+  FoldingSetNodeID ID;
+  Nodes[1002].Profile(ID);
+  void *InsertPos;
+  EXPECT_EQ(&Nodes[1002], Set.FindNodeOrInsertPos(ID, InsertPos));
+}
+
 }
 
@@ -0,0 +1,394 @@
+//===- llvm/unittest/ADT/GroupedDenseMapTest.cpp - GroupedDenseMap tests --===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+#include "llvm/ADT/GroupedDenseMap.h"
+#include <map>
+#include <set>
+
+using namespace llvm;
+
+namespace {
+
+uint32_t getTestKey(int i, uint32_t *) { return i; }
+uint32_t getTestValue(int i, uint32_t *) { return 42 + i; }
+
+uint32_t *getTestKey(int i, uint32_t **) {
+  static uint32_t dummy_arr1[8192];
+  assert(i < 8192 && "Only support 8192 dummy keys.");
+  return &dummy_arr1[i];
+}
+uint32_t *getTestValue(int i, uint32_t **) {
+  static uint32_t dummy_arr1[8192];
+  assert(i < 8192 && "Only support 8192 dummy keys.");
+  return &dummy_arr1[i];
+}
+
+/// \brief A test class that tries to check that construction and destruction
+/// occur correctly.
+class CtorTester {
+  static std::set<CtorTester *> Constructed;
+  int Value;
+
+public:
+  explicit CtorTester(int Value = 0) : Value(Value) {
+    EXPECT_TRUE(Constructed.insert(this).second);
+  }
+  CtorTester(uint32_t Value) : Value(Value) {
+    EXPECT_TRUE(Constructed.insert(this).second);
+  }
+  CtorTester(const CtorTester &Arg) : Value(Arg.Value) {
+    EXPECT_TRUE(Constructed.insert(this).second);
+  }
+  CtorTester &operator=(const CtorTester &Arg) {
+    Value = Arg.Value;
+    return *this;
+  }
+  ~CtorTester() {
+    EXPECT_EQ(1u, Constructed.erase(this));
+  }
+  operator uint32_t() const { return Value; }
+
+  int getValue() const { return Value; }
+  bool operator==(const CtorTester &RHS) const { return Value == RHS.Value; }
+
+  static unsigned getNumConstructed() { return Constructed.size(); }
+};
+
+std::set<CtorTester *> CtorTester::Constructed;
+
+struct CtorTesterMapInfo {
+  static unsigned getHashValue(const CtorTester &Val) {
+    return Val.getValue() * 37u;
+  }
+  static bool isEqual(const CtorTester &LHS, const CtorTester &RHS) {
+    return LHS == RHS;
+  }
+};
+
+CtorTester getTestKey(int i, CtorTester *) { return CtorTester(i); }
+CtorTester getTestValue(int i, CtorTester *) { return CtorTester(42 + i); }
+
+template <typename T>
+class GroupedDenseMapTest : public ::testing::Test {
+protected:
+  T Map;
+
+  static typename T::key_type *const dummy_key_ptr;
+  static typename T::mapped_type *const dummy_value_ptr;
+
+  typename T::key_type getKey(int i = 0) {
+    return getTestKey(i, dummy_key_ptr);
+  }
+  typename T::mapped_type getValue(int i = 0) {
+    return getTestValue(i, dummy_value_ptr);
+  }
+};
+
+template <typename T>
+typename T::key_type *const GroupedDenseMapTest<T>::dummy_key_ptr = nullptr;
+template <typename T>
+typename T::mapped_type *const GroupedDenseMapTest<T>::dummy_value_ptr =
+    nullptr;
+
+// Register these types for testing.
+typedef ::testing::Types<GroupedDenseMap<uint32_t, uint32_t>,
+                         GroupedDenseMap<uint32_t *, uint32_t *>,
+                         GroupedDenseMap<CtorTester, CtorTester,
+                                         CtorTesterMapInfo>
+                         > GroupedDenseMapTestTypes;
+TYPED_TEST_CASE(GroupedDenseMapTest, GroupedDenseMapTestTypes);
+
+// Empty map tests
+TYPED_TEST(GroupedDenseMapTest, EmptyIntMapTest) {
+  // Size tests
+  EXPECT_EQ(0u, this->Map.size());
+  EXPECT_TRUE(this->Map.empty());
+
+  // Iterator tests
+  EXPECT_TRUE(this->Map.begin() == this->Map.end());
+
+  // Lookup tests
+  EXPECT_FALSE(this->Map.count(this->getKey()));
+  EXPECT_TRUE(this->Map.find(this->getKey()) == this->Map.end());
+  EXPECT_EQ(typename TypeParam::mapped_type(),
+            this->Map.lookup(this->getKey()));
+  EXPECT_EQ(0u, this->Map.getMemorySize());
+}
+
+// A map with a single entry
+TYPED_TEST(GroupedDenseMapTest, SingleEntryMapTest) {
+  this->Map[this->getKey()] = this->getValue();
+
+  // Size tests
+  EXPECT_EQ(1u, this->Map.size());
+  EXPECT_FALSE(this->Map.begin() == this->Map.end());
+  EXPECT_FALSE(this->Map.empty());
+
+  // Iterator tests
+  typename TypeParam::iterator it = this->Map.begin();
+  EXPECT_EQ(this->getKey(), it->first);
+  EXPECT_EQ(this->getValue(), it->second);
+  ++it;
+  EXPECT_TRUE(it == this->Map.end());
+
+  // Lookup tests
+  EXPECT_TRUE(this->Map.count(this->getKey()));
+  EXPECT_TRUE(this->Map.find(this->getKey()) == this->Map.begin());
+  EXPECT_EQ(this->getValue(), this->Map.lookup(this->getKey()));
+  EXPECT_EQ(this->getValue(), this->Map[this->getKey()]);
+}
+
+// Test clear() method
+TYPED_TEST(GroupedDenseMapTest, ClearTest) {
+  this->Map[this->getKey()] = this->getValue();
+  this->Map.clear();
+
+  EXPECT_EQ(0u, this->Map.size());
+  EXPECT_TRUE(this->Map.empty());
+  EXPECT_TRUE(this->Map.begin() == this->Map.end());
+}
+
+// Test erase(iterator) method
+TYPED_TEST(GroupedDenseMapTest, EraseTest) {
+  this->Map[this->getKey()] = this->getValue();
+  this->Map.erase(this->Map.begin());
+
+  EXPECT_EQ(0u, this->Map.size());
+  EXPECT_TRUE(this->Map.empty());
+  EXPECT_TRUE(this->Map.begin() == this->Map.end());
+}
+
+// Test erase(value) method
+TYPED_TEST(GroupedDenseMapTest, EraseTest2) {
+  this->Map[this->getKey()] = this->getValue();
+  EXPECT_TRUE(this->Map.erase(this->getKey()));
+  EXPECT_FALSE(this->Map.erase(this->getKey()));
+
+  EXPECT_EQ(0u, this->Map.size());
+  EXPECT_TRUE(this->Map.empty());
+  EXPECT_TRUE(this->Map.begin() == this->Map.end());
+}
+
+// Test insert() method
+TYPED_TEST(GroupedDenseMapTest, InsertTest) {
+  EXPECT_TRUE(this->Map.insert(std::make_pair(this->getKey(),
+                                              this->getValue())).second);
+  EXPECT_FALSE(this->Map.insert(std::make_pair(this->getKey(),
+                                               this->getValue(1))).second);
+  EXPECT_EQ(1u, this->Map.size());
+  EXPECT_EQ(this->getValue(), this->Map[this->getKey()]);
+}
+
+// Test copy constructor method
+TYPED_TEST(GroupedDenseMapTest, CopyConstructorTest) {
+  for (int Key = 0; Key < 100; ++Key)
+    this->Map[this->getKey(Key)] = this->getValue(Key);
+  TypeParam copyMap(this->Map);
+
+  EXPECT_EQ(100u, copyMap.size());
+  for (int Key = 0; Key < 100; ++Key)
+    EXPECT_EQ(this->getValue(Key), copyMap[this->getKey(Key)]);
+}
+
+// Test copying from a default-constructed map.
+TYPED_TEST(GroupedDenseMapTest, CopyConstructorFromDefaultTest) {
+  TypeParam copyMap(this->Map);
+
+  EXPECT_TRUE(copyMap.empty());
+}
+
+// Test assignment operator method
+TYPED_TEST(GroupedDenseMapTest, AssignmentTest) {
+  this->Map[this->getKey()] = this->getValue();
+  TypeParam copyMap;
+  copyMap = this->Map;
+
+  EXPECT_EQ(1u, copyMap.size());
+  EXPECT_EQ(this->getValue(), copyMap[this->getKey()]);
+}
+
+// Test swap method
+TYPED_TEST(GroupedDenseMapTest, SwapTest) {
+  this->Map[this->getKey()] = this->getValue();
+  TypeParam otherMap;
+
+  this->Map.swap(otherMap);
+  EXPECT_EQ(0u, this->Map.size());
+  EXPECT_TRUE(this->Map.empty());
+  EXPECT_EQ(1u, otherMap.size());
+  EXPECT_EQ(this->getValue(), otherMap[this->getKey()]);
+
+  this->Map.swap(otherMap);
+  EXPECT_EQ(0u, otherMap.size());
+  EXPECT_TRUE(otherMap.empty());
+  EXPECT_EQ(1u, this->Map.size());
+  EXPECT_EQ(this->getValue(), this->Map[this->getKey()]);
+}
+
+// Test move construction.
+TYPED_TEST(GroupedDenseMapTest, MoveConstructorTest) {
+  this->Map[this->getKey()] = this->getValue();
+  TypeParam otherMap(std::move(this->Map));
+
+  EXPECT_EQ(1u, otherMap.size());
+  EXPECT_EQ(this->getValue(), otherMap[this->getKey()]);
+}
+
+// A more complex iteration test
+TYPED_TEST(GroupedDenseMapTest, IterationTest) {
+  bool visited[100];
+  std::map<typename TypeParam::key_type, unsigned> visitedIndex;
+
+  // Insert 100 numbers into the map
+  for (int i = 0; i < 100; ++i) {
+    visited[i] = false;
+    visitedIndex[this->getKey(i)] = i;
+
+    this->Map[this->getKey(i)] = this->getValue(i);
+  }
+
+  // Iterate over all numbers and mark each one found.
+  for (typename TypeParam::iterator it = this->Map.begin();
+       it != this->Map.end(); ++it)
+    visited[visitedIndex[it->first]] = true;
+
+  // Ensure every number was visited.
+  for (int i = 0; i < 100; ++i)
+    ASSERT_TRUE(visited[i]) << "Entry #" << i << " was never visited";
+}
+
+// Grow past many group boundaries while churning tombstones, and check the
+// contents against std::map.
+TYPED_TEST(GroupedDenseMapTest, ChurnTest) {
+  std::map<unsigned, unsigned> Reference;
+  for (int Round = 0; Round < 4; ++Round) {
+    for (int i = 0; i < 2000; ++i) {
+      this->Map[this->getKey(i)] = this->getValue(i);
+      Reference[i] = i;
+    }
+    for (int i = Round; i < 2000; i += 3) {
+      EXPECT_TRUE(this->Map.erase(this->getKey(i)));
+      Reference.erase(i);
+    }
+    ASSERT_EQ(Reference.size(), this->Map.size());
+    for (int i = 0; i < 2000; ++i)
+      EXPECT_EQ(Reference.count(i), this->Map.count(this->getKey(i)));
+  }
+
+  unsigned Visited = 0;
+  for (typename TypeParam::const_iterator it = this->Map.begin(),
+         e = this->Map.end(); it != e; ++it)
+    ++Visited;
+  EXPECT_EQ(Reference.size(), Visited);
+}
+
+// const_iterator test
+TYPED_TEST(GroupedDenseMapTest, ConstIteratorTest) {
+  // Check conversion from iterator to const_iterator.
+  typename TypeParam::iterator it = this->Map.begin();
+  typename TypeParam::const_iterator cit(it);
+  EXPECT_TRUE(it == cit);
+
+  // Check copying of const_iterators.
+  typename TypeParam::const_iterator cit2(cit);
+  EXPECT_TRUE(cit == cit2);
+}
+
+// Every key and value constructed by the map is destroyed exactly once.
+TEST(GroupedDenseMapCustomTest, CtorDtorBalanceTest) {
+  unsigned Before = CtorTester::getNumConstructed();
+  {
+    GroupedDenseMap<CtorTester, CtorTester, CtorTesterMapInfo> Map;
+    for (int i = 0; i < 500; ++i)
+      Map[CtorTester(i)] = CtorTester(i + 1);
+    for (int i = 0; i < 500; i += 2)
+      Map.erase(CtorTester(i));
+    EXPECT_EQ(Before + 500u, CtorTester::getNumConstructed());
+    Map.clear();
+    EXPECT_EQ(Before, CtorTester::getNumConstructed());
+    for (int i = 0; i < 10; ++i)
+      Map[CtorTester(i)] = CtorTester(i + 1);
+  }
+  EXPECT_EQ(Before, CtorTester::getNumConstructed());
+}
+
+// Key traits that allows lookup with either an unsigned or char* key;
+// In the latter case, "a" == 0, "b" == 1 and so on.
+struct TestGroupedDenseMapInfo {
+  static unsigned getHashValue(const unsigned& Val) { return Val * 37U; }
+  static unsigned getHashValue(const char* Val) {
+    return (unsigned)(Val[0] - 'a') * 37U;
+  }
+  static bool isEqual(const unsigned& LHS, const unsigned& RHS) {
+    return LHS == RHS;
+  }
+  static bool isEqual(const char* LHS, const unsigned& RHS) {
+    return (unsigned)(LHS[0] - 'a') == RHS;
+  }
+};
+
+// find_as() tests
+TEST(GroupedDenseMapCustomTest, FindAsTest) {
+  GroupedDenseMap<unsigned, unsigned, TestGroupedDenseMapInfo> map;
+  map[0] = 1;
+  map[1] = 2;
+  map[2] = 3;
+
+  // Size tests
+  EXPECT_EQ(3u, map.size());
+
+  // Normal lookup tests
+  EXPECT_EQ(1u, map.count(1));
+  EXPECT_EQ(1u, map.find(0)->second);
+  EXPECT_EQ(2u, map.find(1)->second);
+  EXPECT_EQ(3u, map.find(2)->second);
+  EXPECT_TRUE(map.find(3) == map.end());
+
+  // find_as() tests
+  EXPECT_EQ(1u, map.find_as("a")->second);
+  EXPECT_EQ(2u, map.find_as("b")->second);
+  EXPECT_EQ(3u, map.find_as("c")->second);
+  EXPECT_TRUE(map.find_as("d") == map.end());
+}
+
+// Keys that all hash to the same value must still be found, including when
+// the probe sequence wraps around the end of the table.
+struct CollidingMapInfo {
+  static unsigned getHashValue(const unsigned &) { return 0; }
+  static bool isEqual(const unsigned &LHS, const unsigned &RHS) {
+    return LHS == RHS;
+  }
+};
+
+TEST(GroupedDenseMapCustomTest, CollisionTest) {
+  GroupedDenseMap<unsigned, unsigned, CollidingMapInfo> map;
+  for (unsigned i = 0; i < 100; ++i)
+    map[i] = i + 1;
+  for (unsigned i = 0; i < 100; i += 2)
+    map.erase(i);
+  for (unsigned i = 0; i < 100; ++i)
+    EXPECT_EQ(i % 2 ? i + 1 : 0u, map.lookup(i));
+  EXPECT_TRUE(map.find(100) == map.end());
+}
+
+// Reserving space up front must not lose entries or change lookups.
+TEST(GroupedDenseMapCustomTest, ResizeTest) {
+  GroupedDenseMap<unsigned, unsigned> map;
+  map[1] = 2;
+  map.resize(1000);
+  size_t Size = map.getMemorySize();
+  for (unsigned i = 0; i < 1000; ++i)
+    map[i] = i;
+  EXPECT_EQ(Size, map.getMemorySize());
+  EXPECT_EQ(1000u, map.size());
+  EXPECT_EQ(999u, map.lookup(999));
+}
+
+}
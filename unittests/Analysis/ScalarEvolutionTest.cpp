@@ -230,5 +230,38 @@ TEST_F(ScalarEvolutionsTest, SCEVMultiplyAddRecs) {
   EXPECT_EQ(Product->getOperand(8), SE.getAddExpr(Sum));
 }
 
+TEST_F(ScalarEvolutionsTest, SCEVForgetValuesAtScope) {
+  Type *Ty = Type::getInt32Ty(Context);
+  SmallVector<Type *, 2> Types;
+  Types.append(2, Ty);
+  FunctionType *FTy = FunctionType::get(Type::getVoidTy(Context), Types, false);
+  Function *F = cast<Function>(M.getOrInsertFunction("f", FTy));
+  BasicBlock *BB = BasicBlock::Create(Context, "entry", F);
+  ReturnInst::Create(Context, nullptr, BB);
+
+  // Create a ScalarEvolution and "run" it so that it gets initialized.
+  PM.add(&SE);
+  PM.run(M);
+
+  Loop L;
+  const_cast<std::vector<BasicBlock*>&>(L.getBlocks()).push_back(BB);
+
+  Function::arg_iterator AI = F->arg_begin();
+  const SCEV *Start = SE.getSCEV(&*AI++);
+  const SCEV *Step = SE.getSCEV(&*AI++);
+  const SCEV *Rec = SE.getAddRecExpr(Start, Step, &L, SCEV::FlagAnyWrap);
+  const SCEV *Sum = SE.getAddExpr(Rec, Start);
+  ASSERT_EQ(cast<SCEVNAryExpr>(Sum)->getNumOperands(), 2u);
+
+  // Evicting the memoized results for a scope must not change the answers
+  // that are recomputed afterwards.
+  EXPECT_EQ(SE.getSCEVAtScope(Sum, &L), Sum);
+  EXPECT_EQ(SE.getSCEVAtScope(Rec, &L), Rec);
+  SE.forgetValuesAtScope(&L);
+  EXPECT_EQ(SE.getSCEVAtScope(Sum, &L), Sum);
+  EXPECT_EQ(SE.getSCEVAtScope(Rec, &L), Rec);
+  SE.forgetValuesAtScope(&L);
+}
+
 }  // end anonymous namespace
 }  // end namespace llvm
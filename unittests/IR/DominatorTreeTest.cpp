@@ -10,6 +10,7 @@
 #include "llvm/IR/Dominators.h"
 #include "llvm/Analysis/PostDominators.h"
 #include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
@@ -223,6 +224,150 @@ namespace llvm {
       Passes.add(P);
       Passes.run(*M);
     }
+
+    // Every block of @f ends in a switch on %x, so that edges can be added and
+    // removed by adding and removing cases.  Apart from the entry, the blocks
+    // start out unreachable.
+    Module *makeSwitchModule() {
+      const char *ModuleString =
+        "define void @f(i32 %x) {\n"
+        "entry:\n"
+        "  switch i32 %x, label %exit [ i32 0, label %bb1 ]\n"
+        "bb1:\n"
+        "  switch i32 %x, label %exit [ ]\n"
+        "bb2:\n"
+        "  switch i32 %x, label %exit [ ]\n"
+        "bb3:\n"
+        "  switch i32 %x, label %exit [ ]\n"
+        "bb4:\n"
+        "  switch i32 %x, label %exit [ ]\n"
+        "bb5:\n"
+        "  switch i32 %x, label %exit [ ]\n"
+        "bb6:\n"
+        "  switch i32 %x, label %exit [ ]\n"
+        "bb7:\n"
+        "  switch i32 %x, label %exit [ ]\n"
+        "exit:\n"
+        "  ret void\n"
+        "}\n";
+      LLVMContext &C = getGlobalContext();
+      SMDiagnostic Err;
+      return ParseAssemblyString(ModuleString, nullptr, Err, C);
+    }
+
+    // Toggle pseudo-random edges of @f, updating a dominator and a
+    // post-dominator tree one edge at a time or in batches, and check both
+    // against trees computed from scratch.
+    TEST(DominatorTree, IncrementalUpdates) {
+      std::unique_ptr<Module> M(makeSwitchModule());
+      Function *F = M->getFunction("f");
+      Type *Int32Ty = Type::getInt32Ty(F->getContext());
+      std::vector<BasicBlock *> Blocks;
+      for (Function::iterator BB = F->begin(), E = F->end(); BB != E; ++BB)
+        if (isa<SwitchInst>(BB->getTerminator()))
+          Blocks.push_back(BB);
+
+      DominatorTree DT;
+      DT.recalculate(*F);
+      DominatorTreeBase<BasicBlock> PDT(true);
+      PDT.recalculate(*F);
+
+      unsigned Seed = 1, CaseValue = 1;
+      for (unsigned Round = 0; Round != 300; ++Round) {
+        Seed = Seed * 1103515245 + 12345;
+        unsigned BatchSize = 1 + (Seed >> 4) % 6;
+        std::vector<DominatorTree::UpdateType> Updates;
+        for (unsigned i = 0; i != BatchSize; ++i) {
+          Seed = Seed * 1103515245 + 12345;
+          BasicBlock *From = Blocks[(Seed >> 8) % Blocks.size()];
+          // Nothing may branch to the entry block.
+          BasicBlock *To = Blocks[1 + (Seed >> 16) % (Blocks.size() - 1)];
+          SwitchInst *SI = cast<SwitchInst>(From->getTerminator());
+          SwitchInst::CaseIt Case = SI->case_begin();
+          while (Case != SI->case_end() && Case.getCaseSuccessor() != To)
+            ++Case;
+          if (Case != SI->case_end()) {
+            SI->removeCase(Case);
+            Updates.push_back(
+                DominatorTree::UpdateType(DominatorTree::Delete, From, To));
+          } else {
+            SI->addCase(ConstantInt::get(cast<IntegerType>(Int32Ty),
+                                         CaseValue++),
+                        To);
+            Updates.push_back(
+                DominatorTree::UpdateType(DominatorTree::Insert, From, To));
+          }
+        }
+
+        if (Updates.size() == 1 && Updates[0].Kind == DominatorTree::Insert) {
+          DT.insertEdge(Updates[0].From, Updates[0].To);
+          PDT.insertEdge(Updates[0].From, Updates[0].To);
+        } else if (Updates.size() == 1) {
+          DT.deleteEdge(Updates[0].From, Updates[0].To);
+          PDT.deleteEdge(Updates[0].From, Updates[0].To);
+        } else {
+          DT.applyUpdates(Updates);
+          PDT.applyUpdates(Updates);
+        }
+        ASSERT_TRUE(DT.verify()) << "dominator tree wrong after round "
+                                 << Round;
+        ASSERT_TRUE(PDT.verify()) << "post-dominator tree wrong after round "
+                                  << Round;
+      }
+
+      // A batch may insert an edge that the CFG holds more than once.  Every
+      // copy has to be hidden until the insertion is applied, or bb2 would be
+      // seen as a successor of bb1 while still missing from the trees.
+      const char *MultiEdgeString =
+        "define void @g(i32 %x) {\n"
+        "entry:\n"
+        "  switch i32 %x, label %bb0 [ ]\n"
+        "bb0:\n"
+        "  br label %bb1\n"
+        "bb1:\n"
+        "  switch i32 %x, label %exit [ ]\n"
+        "bb2:\n"
+        "  br label %exit\n"
+        "exit:\n"
+        "  ret void\n"
+        "}\n";
+      SMDiagnostic Err;
+      std::unique_ptr<Module> MultiEdgeM(
+          ParseAssemblyString(MultiEdgeString, nullptr, Err,
+                              getGlobalContext()));
+      Function *G = MultiEdgeM->getFunction("g");
+      Function::iterator GI = G->begin();
+      BasicBlock *Entry = GI++;
+      ++GI;
+      BasicBlock *BB1 = GI++;
+      BasicBlock *BB2 = GI++;
+      BasicBlock *Exit = GI;
+
+      DominatorTree GDT;
+      GDT.recalculate(*G);
+      DominatorTreeBase<BasicBlock> GPDT(true);
+      GPDT.recalculate(*G);
+
+      IntegerType *GInt32Ty = Type::getInt32Ty(G->getContext());
+      cast<SwitchInst>(Entry->getTerminator())
+          ->addCase(ConstantInt::get(GInt32Ty, 0), BB1);
+      SwitchInst *BB1Switch = cast<SwitchInst>(BB1->getTerminator());
+      BB1Switch->setDefaultDest(BB2);
+      BB1Switch->addCase(ConstantInt::get(GInt32Ty, 1), BB2);
+
+      std::vector<DominatorTree::UpdateType> Updates;
+      Updates.push_back(
+          DominatorTree::UpdateType(DominatorTree::Insert, Entry, BB1));
+      Updates.push_back(
+          DominatorTree::UpdateType(DominatorTree::Delete, BB1, Exit));
+      Updates.push_back(
+          DominatorTree::UpdateType(DominatorTree::Insert, BB1, BB2));
+      GDT.applyUpdates(Updates);
+      GPDT.applyUpdates(Updates);
+      EXPECT_TRUE(GDT.verify());
+      EXPECT_TRUE(GPDT.verify());
+      EXPECT_EQ(GDT.getNode(BB2)->getIDom()->getBlock(), BB1);
+    }
   }
 }
 
@@ -14,8 +14,11 @@
 #include "llvm/IR/GlobalAlias.h"
 #include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
 #include "gtest/gtest.h"
 
 namespace llvm {
@@ -60,5 +63,58 @@ TEST(VerifierTest, InvalidRetAttribute) {
       "Attribute 'uwtable' only applies to functions!"));
 }
 
+/// Builds functions that read a register named by broken metadata, one node
+/// shared by all of them and one node of their own, and returns what
+/// verifyModule reports with \p Threads threads.
+static std::string verifyWithThreads(unsigned Threads) {
+  StringMap<cl::Option *> Options;
+  cl::getRegisteredOptions(Options);
+  cl::opt<unsigned> *VerifyThreads =
+      static_cast<cl::opt<unsigned> *>(Options["verify-threads"]);
+  *VerifyThreads = Threads;
+
+  LLVMContext C;
+  Module M("M", C);
+  Type *I64 = Type::getInt64Ty(C);
+  Function *ReadRegister =
+      Intrinsic::getDeclaration(&M, Intrinsic::read_register, I64);
+  FunctionType *FTy = FunctionType::get(I64, I64, /*isVarArg=*/false);
+  MDNode *Shared = nullptr;
+  for (unsigned i = 0; i != 4; ++i) {
+    Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage,
+                                   "f" + Twine(i), &M);
+    BasicBlock *Entry = BasicBlock::Create(C, "entry", F);
+
+    // A node that isn't function local may not refer to an argument.
+    Value *Arg = F->arg_begin();
+    MDNode *Own = MDNode::getWhenValsUnresolved(C, Arg, false);
+    if (!Shared)
+      Shared = Own;
+    CallInst::Create(ReadRegister, Shared, "", Entry);
+    Value *V = CallInst::Create(ReadRegister, Own, "", Entry);
+    ReturnInst::Create(C, V, Entry);
+  }
+  M.getOrInsertNamedMetadata("shared")->addOperand(Shared);
+
+  std::string Error;
+  raw_string_ostream ErrorOS(Error);
+  EXPECT_TRUE(verifyModule(M, &ErrorOS));
+  *VerifyThreads = 1;
+  return ErrorOS.str();
+}
+
+TEST(VerifierTest, ParallelMatchesSequential) {
+  std::string Sequential = verifyWithThreads(1);
+  std::string Parallel = verifyWithThreads(4);
+  EXPECT_EQ(Sequential, Parallel);
+
+  // Each node is reported once, however many functions refer to it.
+  unsigned Count = 0;
+  for (size_t Pos = Parallel.find("Invalid operand"); Pos != std::string::npos;
+       Pos = Parallel.find("Invalid operand", Pos + 1))
+    ++Count;
+  EXPECT_EQ(4u, Count);
+}
+
 }
 }
@@ -30,6 +30,12 @@ static cl::opt<bool>
 OmitComments("omit-comments", cl::desc("Do not generate comments"),
              cl::init(false));
 
+static cl::opt<unsigned>
+IndexedSwitchCases("isel-indexed-switch-cases",
+                   cl::desc("Emit opcode and type switches with at least this "
+                            "many cases as indexed switches (0 to disable)"),
+                   cl::init(8));
+
 namespace {
 class MatcherTableEmitter {
   const CodeGenDAGPatterns &CGP;
@@ -47,6 +53,8 @@ class MatcherTableEmitter {
   DenseMap<Record*, unsigned> NodeXFormMap;
   std::vector<Record*> NodeXForms;
 
+  DenseMap<const Matcher*, unsigned> SwitchNumberMap;
+
 public:
   MatcherTableEmitter(const CodeGenDAGPatterns &cgp)
     : CGP(cgp) {}
@@ -96,6 +104,17 @@ private:
     return Entry-1;
   }
 
+  /// getSwitchNumber - Return the number identifying an indexed switch to the
+  /// matcher, which keeps its case table under this number.  A switch may be
+  /// emitted several times while the sizes of scopes are worked out, so the
+  /// number is tied to the matcher rather than handed out per emission.
+  unsigned getSwitchNumber(const Matcher *N) {
+    unsigned &Entry = SwitchNumberMap[N];
+    if (Entry == 0)
+      Entry = SwitchNumberMap.size();
+    return Entry-1;
+  }
+
 };
 } // end anonymous namespace.
 
@@ -275,19 +294,30 @@ EmitMatcher(const Matcher *N, unsigned Indent, unsigned CurrentIdx,
     unsigned StartIdx = CurrentIdx;
 
     unsigned NumCases;
-    if (const SwitchOpcodeMatcher *SOM = dyn_cast<SwitchOpcodeMatcher>(N)) {
-      OS << "OPC_SwitchOpcode ";
+    if (const SwitchOpcodeMatcher *SOM = dyn_cast<SwitchOpcodeMatcher>(N))
       NumCases = SOM->getNumCases();
-    } else {
-      OS << "OPC_SwitchType ";
+    else
       NumCases = cast<SwitchTypeMatcher>(N)->getNumCases();
-    }
 
+    // Large switches are looked up in a table the matcher builds the first
+    // time it reaches them, instead of being scanned case by case.  The
+    // switch at the start of the table already gets that treatment, so it is
+    // left alone.
+    bool Indexed = IndexedSwitchCases && NumCases >= IndexedSwitchCases &&
+                   CurrentIdx != 0;
+
+    OS << (isa<SwitchOpcodeMatcher>(N) ? "OPC_SwitchOpcode" : "OPC_SwitchType");
+    if (Indexed)
+      OS << "Indexed";
+    OS << ' ';
     if (!OmitComments)
       OS << "/*" << NumCases << " cases */";
     OS << ", ";
     ++CurrentIdx;
 
+    if (Indexed)
+      CurrentIdx += EmitVBRValue(getSwitchNumber(N), OS);
+
     // For each case we emit the size, then the opcode, then the matcher.
     for (unsigned i = 0, e = NumCases; i != e; ++i) {
       const Matcher *Child;
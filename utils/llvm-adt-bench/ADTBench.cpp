@@ -0,0 +1,170 @@
+//===- ADTBench - Benchmark the ADT containers ----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program runs the ADT containers through the access patterns that
+// dominate their use in the compiler and reports, per operation, the time
+// taken, the number of operator new calls made and, where the host allows it,
+// the number of hardware cache misses.
+//
+// Results are printed as a table, or with -json as a JSON document that can
+// be saved and compared between builds.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdlib>
+#include <new>
+
+using namespace llvm;
+using namespace adtbench;
+
+static cl::list<unsigned>
+Sizes("sizes", cl::CommaSeparated,
+      cl::desc("Number of elements in each benchmarked container (default "
+               "16,256,4096,65536)"));
+
+static cl::opt<unsigned>
+MinOps("min-ops", cl::init(1 << 22),
+       cl::desc("Minimum number of operations timed per measurement"));
+
+static cl::opt<unsigned>
+Stride("key-stride", cl::init(64),
+       cl::desc("Distance in bytes between consecutive pointer keys"));
+
+static cl::opt<std::string>
+Filter("filter", cl::init(""),
+       cl::desc("Only run the containers whose name contains this string"));
+
+static cl::opt<bool>
+JSON("json", cl::desc("Print the results as JSON"));
+
+//===----------------------------------------------------------------------===//
+// Allocation counting
+//===----------------------------------------------------------------------===//
+
+// Count calls to the global operator new.  Containers that grow through
+// malloc directly (SmallVector, StringMap, MallocAllocator) are not seen
+// here, so their allocs/op only covers the objects they construct with new.
+// The tool is single threaded.
+static uint64_t NumAllocations = 0;
+
+uint64_t adtbench::getNumAllocations() { return NumAllocations; }
+
+static void *countedAlloc(size_t Size) {
+  ++NumAllocations;
+  void *P = std::malloc(Size ? Size : 1);
+  if (!P)
+    report_fatal_error("llvm-adt-bench: out of memory");
+  return P;
+}
+
+void *operator new(size_t Size) { return countedAlloc(Size); }
+void *operator new[](size_t Size) { return countedAlloc(Size); }
+void operator delete(void *P) LLVM_NOEXCEPT { std::free(P); }
+void operator delete[](void *P) LLVM_NOEXCEPT { std::free(P); }
+
+//===----------------------------------------------------------------------===//
+// Key sets
+//===----------------------------------------------------------------------===//
+
+volatile uintptr_t adtbench::Sink;
+
+PointerKeys::PointerKeys(unsigned N, unsigned Stride)
+  : Slab(size_t(N) * 2 * Stride + 1) {
+  for (unsigned i = 0; i != N; ++i) {
+    Inserted.push_back(&Slab[size_t(i) * 2 * Stride]);
+    Missing.push_back(&Slab[size_t(i) * 2 * Stride + Stride]);
+  }
+  Shuffled = Inserted;
+  shuffle(Shuffled);
+}
+
+StringKeys::StringKeys(unsigned N) {
+  static const char *const Stems[] = {
+    "tmp", "call", "arrayidx", "add", "cmp", "retval", "_ZN4llvm5Value",
+    "for.body", "if.then", "conv"
+  };
+  for (unsigned i = 0; i != N; ++i) {
+    std::string Stem = Stems[i % array_lengthof(Stems)];
+    std::string Suffix = utostr(i / array_lengthof(Stems));
+    Inserted.push_back(Stem + Suffix);
+    Missing.push_back(Stem + "." + Suffix);
+  }
+  Shuffled = Inserted;
+  shuffle(Shuffled);
+}
+
+//===----------------------------------------------------------------------===//
+// Reporting
+//===----------------------------------------------------------------------===//
+
+void Runner::printText(raw_ostream &OS) const {
+  OS << "container          pattern              size        ns/op"
+        "    allocs/op    misses/op\n";
+  for (unsigned i = 0, e = Results.size(); i != e; ++i) {
+    const Result &R = Results[i];
+    OS << format("%-18s %-16s %8u %12.2f %12.3f ", R.Container.c_str(),
+                 R.Pattern.c_str(), R.Size, R.NsPerOp, R.AllocsPerOp);
+    if (R.HaveCacheMisses)
+      OS << format("%12.3f\n", R.CacheMissesPerOp);
+    else
+      OS << "         n/a\n";
+  }
+}
+
+void Runner::printJSON(raw_ostream &OS) const {
+  // Container and pattern names are plain identifiers, so nothing needs to
+  // be escaped.
+  OS << "{\n  \"benchmarks\": [";
+  for (unsigned i = 0, e = Results.size(); i != e; ++i) {
+    const Result &R = Results[i];
+    OS << (i ? ",\n" : "\n") << "    { \"container\": \"" << R.Container
+       << "\", \"pattern\": \"" << R.Pattern << "\", \"size\": " << R.Size
+       << format(", \"ns_per_op\": %.3f, \"allocs_per_op\": %.4f",
+                 R.NsPerOp, R.AllocsPerOp)
+       << ", \"cache_misses_per_op\": ";
+    if (R.HaveCacheMisses)
+      OS << format("%.4f", R.CacheMissesPerOp);
+    else
+      OS << "null";
+    OS << " }";
+  }
+  OS << "\n  ]\n}\n";
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "ADT container benchmarks\n");
+
+  std::vector<unsigned> N(Sizes.begin(), Sizes.end());
+  if (N.empty()) {
+    static const unsigned DefaultSizes[] = { 16, 256, 4096, 65536 };
+    N.assign(DefaultSizes, DefaultSizes + array_lengthof(DefaultSizes));
+  }
+
+  Runner R(MinOps, Filter);
+  for (unsigned i = 0, e = N.size(); i != e; ++i) {
+    runMapBenchmarks(R, N[i], Stride);
+    runSetBenchmarks(R, N[i], Stride);
+    runVectorBenchmarks(R, N[i]);
+    runTreeBenchmarks(R, N[i]);
+    runAllocatorBenchmarks(R, N[i]);
+  }
+
+  if (JSON)
+    R.printJSON(outs());
+  else
+    R.printText(outs());
+  return 0;
+}
@@ -0,0 +1,171 @@
+//===- Benchmark.h - ADT benchmark harness ----------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the harness shared by the llvm-adt-bench benchmarks: the
+// runner that times a benchmark body and samples the allocation and hardware
+// counters around it, and the key sets the benchmarks are run over.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_BENCH_BENCHMARK_H
+#define LLVM_ADT_BENCH_BENCHMARK_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/Timer.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+class raw_ostream;
+
+namespace adtbench {
+
+/// getNumAllocations - The number of calls to the global operator new made so
+/// far by this process.
+uint64_t getNumAllocations();
+
+/// PerfCounter - A portable shim over the hardware cache-miss counter.  On
+/// hosts (or in sandboxes) where the counter can't be opened, isAvailable()
+/// returns false and readings are reported as missing.
+class PerfCounter {
+  int FD;
+public:
+  PerfCounter();
+  ~PerfCounter();
+
+  bool isAvailable() const { return FD >= 0; }
+
+  /// start - Reset the counter and start counting.
+  void start();
+
+  /// stop - Stop counting and return the number of events since start().
+  uint64_t stop();
+};
+
+/// Result - One measurement of one benchmark.
+struct Result {
+  std::string Container;
+  std::string Pattern;
+  unsigned Size;
+  double NsPerOp;
+  double AllocsPerOp;
+  double CacheMissesPerOp;
+  bool HaveCacheMisses;
+};
+
+/// Runner - Times benchmark bodies and collects the results.
+class Runner {
+  unsigned MinOps;
+  std::string Filter;
+  PerfCounter CacheMisses;
+  std::vector<Result> Results;
+
+public:
+  Runner(unsigned MinOps, StringRef Filter)
+    : MinOps(MinOps), Filter(Filter) {}
+
+  /// isEnabled - Return true if the benchmarks of Container were selected on
+  /// the command line.
+  bool isEnabled(StringRef Container) const {
+    return Filter.empty() || Container.find(Filter) != StringRef::npos;
+  }
+
+  /// run - Run Body, which performs OpsPerRun operations, enough times to
+  /// perform at least MinOps operations, and record the cost per operation.
+  template <typename BodyT>
+  void run(StringRef Container, StringRef Pattern, unsigned Size,
+           unsigned OpsPerRun, BodyT Body) {
+    if (!isEnabled(Container))
+      return;
+    if (OpsPerRun == 0)
+      OpsPerRun = 1;
+    unsigned Runs = MinOps / OpsPerRun;
+    if (Runs == 0)
+      Runs = 1;
+
+    // Warm up the caches and the allocator once before measuring.
+    Body();
+
+    uint64_t StartAllocs = getNumAllocations();
+    CacheMisses.start();
+    double Start = TimeRecord::getCurrentTime(true).getWallTime();
+    for (unsigned R = 0; R != Runs; ++R)
+      Body();
+    double End = TimeRecord::getCurrentTime(false).getWallTime();
+    uint64_t Misses = CacheMisses.stop();
+    uint64_t Allocs = getNumAllocations() - StartAllocs;
+
+    double Ops = double(Runs) * OpsPerRun;
+    Result R;
+    R.Container = Container;
+    R.Pattern = Pattern;
+    R.Size = Size;
+    R.NsPerOp = (End - Start) * 1e9 / Ops;
+    R.AllocsPerOp = Allocs / Ops;
+    R.HaveCacheMisses = CacheMisses.isAvailable();
+    R.CacheMissesPerOp = R.HaveCacheMisses ? Misses / Ops : 0;
+    Results.push_back(R);
+  }
+
+  /// printText - Print one line per result in a human readable table.
+  void printText(raw_ostream &OS) const;
+
+  /// printJSON - Print the results as a JSON document, for comparing runs of
+  /// different builds.
+  void printJSON(raw_ostream &OS) const;
+};
+
+/// Sink - Stores to this keep the optimizer from deleting benchmark loops.
+extern volatile uintptr_t Sink;
+
+/// PointerKeys - Pointer keys laid out like IR objects: addresses carved out
+/// of one slab with a fixed stride, in allocation order, plus the same keys
+/// in a shuffled lookup order and keys that are never inserted.
+struct PointerKeys {
+  std::vector<char> Slab;
+  std::vector<void *> Inserted;
+  std::vector<void *> Shuffled;
+  std::vector<void *> Missing;
+
+  PointerKeys(unsigned N, unsigned Stride);
+};
+
+/// StringKeys - Identifier-like string keys, in the shape of value and
+/// symbol names: a few common stems with numeric and dotted suffixes.
+struct StringKeys {
+  std::vector<std::string> Inserted;
+  std::vector<std::string> Shuffled;
+  std::vector<std::string> Missing;
+
+  explicit StringKeys(unsigned N);
+};
+
+/// shuffle - Deterministically shuffle V, so that every run and every build
+/// sees the same order.
+template <typename T>
+void shuffle(std::vector<T> &V) {
+  uint64_t Seed = 0x2545F4914F6CDD1DULL;
+  for (size_t i = V.size(); i > 1; --i) {
+    Seed = Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    std::swap(V[i - 1], V[(Seed >> 33) % i]);
+  }
+}
+
+// The benchmark groups.
+void runMapBenchmarks(Runner &R, unsigned N, unsigned Stride);
+void runSetBenchmarks(Runner &R, unsigned N, unsigned Stride);
+void runVectorBenchmarks(Runner &R, unsigned N);
+void runTreeBenchmarks(Runner &R, unsigned N);
+void runAllocatorBenchmarks(Runner &R, unsigned N);
+
+} // end namespace adtbench
+} // end namespace llvm
+
+#endif
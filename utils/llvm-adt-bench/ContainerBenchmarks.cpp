@@ -0,0 +1,214 @@
+//===- ContainerBenchmarks.cpp - Vector, tree and allocator benchmarks ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file benchmarks SmallVector, FoldingSet, ImmutableMap, IntervalMap and
+// BumpPtrAllocator, each on the usage pattern it is chosen for in the
+// compiler.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/ImmutableMap.h"
+#include "llvm/ADT/IntervalMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
+
+using namespace llvm;
+using namespace adtbench;
+
+namespace {
+
+/// UniqueNode - A node uniqued by opcode and two operands, the shape of the
+/// SCEV and SDNode uniquing tables.
+class UniqueNode : public FoldingSetNode {
+  unsigned Opcode;
+  const void *LHS, *RHS;
+public:
+  UniqueNode(unsigned Opcode, const void *LHS, const void *RHS)
+    : Opcode(Opcode), LHS(LHS), RHS(RHS) {}
+
+  static void Profile(FoldingSetNodeID &ID, unsigned Opcode, const void *LHS,
+                      const void *RHS) {
+    ID.AddInteger(Opcode);
+    ID.AddPointer(LHS);
+    ID.AddPointer(RHS);
+  }
+  void Profile(FoldingSetNodeID &ID) const { Profile(ID, Opcode, LHS, RHS); }
+};
+
+void runSmallVector(Runner &R, unsigned N) {
+  StringRef Container = "SmallVector";
+  if (!R.isEnabled(Container))
+    return;
+
+  // Short-lived operand lists: most stay within the inline storage.
+  R.run(Container, "push-back-small", N, N * 4, [&] {
+    uintptr_t Sum = 0;
+    for (unsigned i = 0; i != N; ++i) {
+      SmallVector<unsigned, 4> Ops;
+      for (unsigned j = 0, e = 1 + (i & 3); j != e; ++j)
+        Ops.push_back(i + j);
+      Sum += Ops.size();
+    }
+    Sink = Sum;
+  });
+
+  // Worklists that grow past the inline storage to N elements.
+  R.run(Container, "push-back-grow", N, N, [&] {
+    SmallVector<unsigned, 8> V;
+    for (unsigned i = 0; i != N; ++i)
+      V.push_back(i);
+    Sink = V.size();
+  });
+
+  SmallVector<unsigned, 8> V;
+  for (unsigned i = 0; i != N; ++i)
+    V.push_back(i);
+  R.run(Container, "iterate", N, N, [&] {
+    uintptr_t Sum = 0;
+    for (SmallVectorImpl<unsigned>::iterator I = V.begin(), E = V.end();
+         I != E; ++I)
+      Sum += *I;
+    Sink = Sum;
+  });
+}
+
+void runFoldingSet(Runner &R, unsigned N) {
+  StringRef Container = "FoldingSet";
+  if (!R.isEnabled(Container))
+    return;
+
+  PointerKeys Operands(N, 32);
+  BumpPtrAllocator Alloc;
+  FoldingSet<UniqueNode> Set;
+  R.run(Container, "get-or-insert", N, N, [&] {
+    Set.clear();
+    Alloc.Reset();
+    for (unsigned i = 0; i != N; ++i) {
+      FoldingSetNodeID ID;
+      UniqueNode::Profile(ID, i & 7, Operands.Inserted[i],
+                          Operands.Inserted[(i * 7) % N]);
+      void *IP;
+      if (!Set.FindNodeOrInsertPos(ID, IP))
+        Set.InsertNode(new (Alloc) UniqueNode(i & 7, Operands.Inserted[i],
+                                              Operands.Inserted[(i * 7) % N]),
+                       IP);
+    }
+    Sink = Set.size();
+  });
+
+  // Re-request every node, as when the same expression is built again.
+  R.run(Container, "lookup-hit", N, N, [&] {
+    uintptr_t Sum = 0;
+    for (unsigned i = 0; i != N; ++i) {
+      unsigned j = (i * 13) % N;
+      FoldingSetNodeID ID;
+      UniqueNode::Profile(ID, j & 7, Operands.Inserted[j],
+                          Operands.Inserted[(j * 7) % N]);
+      void *IP;
+      Sum += Set.FindNodeOrInsertPos(ID, IP) != nullptr;
+    }
+    Sink = Sum;
+  });
+}
+
+void runImmutableMap(Runner &R, unsigned N) {
+  StringRef Container = "ImmutableMap";
+  if (!R.isEnabled(Container))
+    return;
+
+  std::vector<unsigned> Keys;
+  for (unsigned i = 0; i != N; ++i)
+    Keys.push_back(i * 2654435761U);
+  shuffle(Keys);
+
+  // Building up program state one binding at a time, as the static analyzer
+  // does.
+  R.run(Container, "add", N, N, [&] {
+    ImmutableMap<unsigned, unsigned>::Factory F;
+    ImmutableMap<unsigned, unsigned> M = F.getEmptyMap();
+    for (unsigned i = 0; i != N; ++i)
+      M = F.add(M, Keys[i], i);
+    Sink = M.getHeight();
+  });
+
+  ImmutableMap<unsigned, unsigned>::Factory F;
+  ImmutableMap<unsigned, unsigned> M = F.getEmptyMap();
+  for (unsigned i = 0; i != N; ++i)
+    M = F.add(M, Keys[i], i);
+  R.run(Container, "lookup-hit", N, N, [&] {
+    uintptr_t Sum = 0;
+    for (unsigned i = 0; i != N; ++i)
+      Sum += *M.lookup(Keys[N - 1 - i]);
+    Sink = Sum;
+  });
+}
+
+void runIntervalMap(Runner &R, unsigned N) {
+  StringRef Container = "IntervalMap";
+  if (!R.isEnabled(Container))
+    return;
+
+  typedef IntervalMap<unsigned, unsigned> MapT;
+  MapT::Allocator Alloc;
+
+  // Live-range-like intervals: short, disjoint, inserted out of order.
+  std::vector<unsigned> Starts;
+  for (unsigned i = 0; i != N; ++i)
+    Starts.push_back(i * 16);
+  shuffle(Starts);
+
+  R.run(Container, "insert", N, N, [&] {
+    MapT Map(Alloc);
+    for (unsigned i = 0; i != N; ++i)
+      Map.insert(Starts[i], Starts[i] + 7, i);
+    Sink = Map.empty();
+  });
+
+  MapT Map(Alloc);
+  for (unsigned i = 0; i != N; ++i)
+    Map.insert(Starts[i], Starts[i] + 7, i + 1);
+  R.run(Container, "lookup", N, N, [&] {
+    uintptr_t Sum = 0;
+    for (unsigned i = 0; i != N; ++i)
+      Sum += Map.lookup(Starts[i] + (i & 15));
+    Sink = Sum;
+  });
+}
+
+} // end anonymous namespace
+
+void adtbench::runVectorBenchmarks(Runner &R, unsigned N) {
+  runSmallVector(R, N);
+}
+
+void adtbench::runTreeBenchmarks(Runner &R, unsigned N) {
+  runFoldingSet(R, N);
+  runImmutableMap(R, N);
+  runIntervalMap(R, N);
+}
+
+void adtbench::runAllocatorBenchmarks(Runner &R, unsigned N) {
+  StringRef Container = "BumpPtrAllocator";
+  if (!R.isEnabled(Container))
+    return;
+
+  // Mixed small object sizes, as when allocating IR and analysis nodes.
+  static const unsigned ObjectSizes[] = { 16, 24, 40, 48, 64, 96 };
+  R.run(Container, "allocate-reset", N, N, [&] {
+    BumpPtrAllocator Alloc;
+    uintptr_t Sum = 0;
+    for (unsigned i = 0; i != N; ++i)
+      Sum += reinterpret_cast<uintptr_t>(
+          Alloc.Allocate(ObjectSizes[i % array_lengthof(ObjectSizes)], 8));
+    Sink = Sum;
+  });
+}
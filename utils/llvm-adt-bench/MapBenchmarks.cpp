@@ -0,0 +1,156 @@
+//===- MapBenchmarks.cpp - Hash map and set benchmarks --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file runs the hash-based containers through the access patterns that
+// dominate their use in the compiler: populating a side table in program
+// order, data-dependent lookups that hit and miss, worklist-style erase and
+// insert churn, and iteration.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/GroupedDenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringMap.h"
+
+using namespace llvm;
+using namespace adtbench;
+
+namespace {
+
+template <typename MapT>
+void runPointerMap(Runner &R, StringRef Container, const PointerKeys &Keys) {
+  if (!R.isEnabled(Container))
+    return;
+  unsigned N = Keys.Inserted.size();
+
+  R.run(Container, "insert", N, N, [&] {
+    MapT Map;
+    for (unsigned i = 0; i != N; ++i)
+      Map[Keys.Inserted[i]] = i;
+    Sink = Map.size();
+  });
+
+  MapT Map;
+  for (unsigned i = 0; i != N; ++i)
+    Map[Keys.Inserted[i]] = i;
+
+  R.run(Container, "lookup-hit", N, N, [&] {
+    uintptr_t Sum = 0;
+    for (unsigned i = 0; i != N; ++i)
+      Sum += Map.find(Keys.Shuffled[i])->second;
+    Sink = Sum;
+  });
+
+  R.run(Container, "lookup-miss", N, N, [&] {
+    uintptr_t Sum = 0;
+    for (unsigned i = 0; i != N; ++i)
+      Sum += Map.count(Keys.Missing[i]);
+    Sink = Sum;
+  });
+
+  R.run(Container, "erase-insert", N, 4 * N, [&] {
+    for (unsigned i = 0; i != N; ++i) {
+      Map.erase(Keys.Shuffled[i]);
+      Map[Keys.Missing[i]] = i;
+    }
+    for (unsigned i = 0; i != N; ++i) {
+      Map.erase(Keys.Missing[i]);
+      Map[Keys.Shuffled[i]] = i;
+    }
+  });
+
+  R.run(Container, "iterate", N, N, [&] {
+    uintptr_t Sum = 0;
+    for (typename MapT::iterator I = Map.begin(), E = Map.end(); I != E; ++I)
+      Sum += I->second;
+    Sink = Sum;
+  });
+}
+
+void runStringMap(Runner &R, const StringKeys &Keys) {
+  StringRef Container = "StringMap";
+  if (!R.isEnabled(Container))
+    return;
+  unsigned N = Keys.Inserted.size();
+
+  R.run(Container, "insert", N, N, [&] {
+    StringMap<unsigned> Map;
+    for (unsigned i = 0; i != N; ++i)
+      Map[Keys.Inserted[i]] = i;
+    Sink = Map.size();
+  });
+
+  StringMap<unsigned> Map;
+  for (unsigned i = 0; i != N; ++i)
+    Map[Keys.Inserted[i]] = i;
+
+  R.run(Container, "lookup-hit", N, N, [&] {
+    uintptr_t Sum = 0;
+    for (unsigned i = 0; i != N; ++i)
+      Sum += Map.find(Keys.Shuffled[i])->getValue();
+    Sink = Sum;
+  });
+
+  R.run(Container, "lookup-miss", N, N, [&] {
+    uintptr_t Sum = 0;
+    for (unsigned i = 0; i != N; ++i)
+      Sum += Map.count(Keys.Missing[i]);
+    Sink = Sum;
+  });
+}
+
+template <unsigned SmallSize>
+void runSmallPtrSet(Runner &R, StringRef Container, const PointerKeys &Keys) {
+  if (!R.isEnabled(Container))
+    return;
+  unsigned N = Keys.Inserted.size();
+
+  // The "visited" idiom: insert everything reachable, most of it once.
+  R.run(Container, "insert", N, N, [&] {
+    SmallPtrSet<void *, SmallSize> Set;
+    for (unsigned i = 0; i != N; ++i)
+      Set.insert(Keys.Inserted[i]);
+    Sink = Set.size();
+  });
+
+  SmallPtrSet<void *, SmallSize> Set;
+  for (unsigned i = 0; i != N; ++i)
+    Set.insert(Keys.Inserted[i]);
+
+  R.run(Container, "lookup-hit", N, N, [&] {
+    uintptr_t Sum = 0;
+    for (unsigned i = 0; i != N; ++i)
+      Sum += Set.count(Keys.Shuffled[i]);
+    Sink = Sum;
+  });
+
+  R.run(Container, "lookup-miss", N, N, [&] {
+    uintptr_t Sum = 0;
+    for (unsigned i = 0; i != N; ++i)
+      Sum += Set.count(Keys.Missing[i]);
+    Sink = Sum;
+  });
+}
+
+} // end anonymous namespace
+
+void adtbench::runMapBenchmarks(Runner &R, unsigned N, unsigned Stride) {
+  PointerKeys Keys(N, Stride);
+  runPointerMap<DenseMap<void *, unsigned> >(R, "DenseMap", Keys);
+  runPointerMap<GroupedDenseMap<void *, unsigned> >(R, "GroupedDenseMap",
+                                                    Keys);
+  runStringMap(R, StringKeys(N));
+}
+
+void adtbench::runSetBenchmarks(Runner &R, unsigned N, unsigned Stride) {
+  PointerKeys Keys(N, Stride);
+  runSmallPtrSet<8>(R, "SmallPtrSet", Keys);
+}
@@ -0,0 +1,73 @@
+//===- PerfCounter.cpp - Portable hardware counter shim -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the cache-miss counter used by llvm-adt-bench.  Only
+// Linux perf events are supported; everywhere else, and whenever the kernel
+// refuses to open the counter, the counter reports itself as unavailable.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Benchmark.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+using namespace llvm;
+using namespace adtbench;
+
+#if defined(__linux__) && defined(__NR_perf_event_open)
+
+PerfCounter::PerfCounter() {
+  struct perf_event_attr Attr;
+  std::memset(&Attr, 0, sizeof(Attr));
+  Attr.type = PERF_TYPE_HARDWARE;
+  Attr.size = sizeof(Attr);
+  Attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  Attr.disabled = 1;
+  Attr.exclude_kernel = 1;
+  Attr.exclude_hv = 1;
+  // Count this thread on any CPU.
+  FD = syscall(__NR_perf_event_open, &Attr, 0, -1, -1, 0);
+}
+
+PerfCounter::~PerfCounter() {
+  if (FD >= 0)
+    close(FD);
+}
+
+void PerfCounter::start() {
+  if (FD < 0)
+    return;
+  ioctl(FD, PERF_EVENT_IOC_RESET, 0);
+  ioctl(FD, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+uint64_t PerfCounter::stop() {
+  if (FD < 0)
+    return 0;
+  ioctl(FD, PERF_EVENT_IOC_DISABLE, 0);
+  uint64_t Count = 0;
+  if (read(FD, &Count, sizeof(Count)) != sizeof(Count))
+    return 0;
+  return Count;
+}
+
+#else
+
+PerfCounter::PerfCounter() : FD(-1) {}
+PerfCounter::~PerfCounter() {}
+void PerfCounter::start() {}
+uint64_t PerfCounter::stop() { return 0; }
+
+#endif
@@ -0,0 +1,130 @@
+//===- AnalysisBenchmarks.cpp - Analysis cache benchmarks -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file measures the caches kept by the lazy analyses on functions with
+// one block per element, the shape that makes them expensive.  Run with
+// -sizes=100000 to reproduce a 100k-block function; the analyses' own options,
+// such as -lvi-max-cache-entries, are accepted on the command line too.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassBench.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/PassManager.h"
+#include "llvm/Target/TargetLibraryInfo.h"
+#include <algorithm>
+
+using namespace llvm;
+using namespace passbench;
+
+namespace {
+
+/// buildRangeChain - Build a function of N blocks, each of which branches to
+/// the next one only if the argument is below a bound that shrinks along the
+/// chain, and to a common exit otherwise.
+Function *buildRangeChain(Module &M, unsigned N) {
+  LLVMContext &C = M.getContext();
+  Type *I64 = Type::getInt64Ty(C);
+  Function *F = Function::Create(
+      FunctionType::get(Type::getVoidTy(C), I64, false),
+      GlobalValue::ExternalLinkage, "", &M);
+  Value *X = F->arg_begin();
+
+  BasicBlock *Exit = BasicBlock::Create(C, "", F);
+  IRBuilder<> B(BasicBlock::Create(C, "", F, Exit));
+  for (unsigned i = 0; i != N; ++i) {
+    Value *Cmp = B.CreateICmpULT(X, B.getInt64(N - i));
+    BasicBlock *Next = BasicBlock::Create(C, "", F, Exit);
+    B.CreateCondBr(Cmp, Next, Exit);
+    B.SetInsertPoint(Next);
+  }
+  B.CreateBr(Exit);
+  ReturnInst::Create(C, Exit);
+  return F;
+}
+
+/// LVIQueries - Ask LazyValueInfo, on the edge into every block of a range
+/// chain, whether the argument is below the bound at the head of the chain:
+/// the query JumpThreading and CorrelatedValuePropagation make.
+class LVIQueries : public FunctionPass {
+  bool Reverse;
+public:
+  static char ID;
+  uintptr_t NumKnown;
+
+  explicit LVIQueries(bool Reverse)
+    : FunctionPass(ID), Reverse(Reverse), NumKnown(0) {}
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<LazyValueInfo>();
+    AU.setPreservesAll();
+  }
+
+  bool runOnFunction(Function &F) override {
+    LazyValueInfo &LVI = getAnalysis<LazyValueInfo>();
+    Value *X = F.arg_begin();
+    Constant *Bound = ConstantInt::get(X->getType(), F.size());
+
+    std::vector<BasicBlock *> Blocks;
+    for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+      if (BB->getSinglePredecessor())
+        Blocks.push_back(BB);
+    if (Reverse)
+      std::reverse(Blocks.begin(), Blocks.end());
+
+    for (unsigned i = 0, e = Blocks.size(); i != e; ++i)
+      NumKnown += LVI.getPredicateOnEdge(ICmpInst::ICMP_ULT, X, Bound,
+                                         Blocks[i]->getSinglePredecessor(),
+                                         Blocks[i]) == LazyValueInfo::True;
+    return false;
+  }
+};
+
+char LVIQueries::ID = 0;
+
+void runLazyValueInfo(Runner &R, unsigned N) {
+  StringRef Group = "LazyValueInfo";
+  if (!R.isEnabled(Group))
+    return;
+
+  initializeAnalysis(*PassRegistry::getPassRegistry());
+
+  LLVMContext C;
+  Module M("bench", C);
+  Function *F = buildRangeChain(M, N);
+
+  // The cache is rebuilt from scratch on every run.  Querying in program
+  // order solves one new block per query; querying in reverse solves the
+  // whole chain on the first query and answers the rest from the cache.
+  for (unsigned Reverse = 0; Reverse != 2; ++Reverse) {
+    FunctionPassManager FPM(&M);
+    FPM.add(new TargetLibraryInfo(Triple(M.getTargetTriple())));
+    LVIQueries *Queries = new LVIQueries(Reverse);
+    FPM.add(Queries);
+    FPM.doInitialization();
+    R.run(Group, Reverse ? "edge-query-rev" : "edge-query", N, N, [&] {
+      FPM.run(*F);
+      Sink = Queries->NumKnown;
+    });
+    FPM.doFinalization();
+  }
+}
+
+} // end anonymous namespace
+
+void passbench::runAnalysisBenchmarks(Runner &R, unsigned N) {
+  runLazyValueInfo(R, N);
+}
@@ -0,0 +1,92 @@
+//===- PassBench - Benchmark analyses and transforms ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program builds IR in the shapes that make particular analyses and
+// transforms expensive, or that they are meant to speed up, and reports the
+// time per operation: per query for the analyses, per element processed for
+// the code the transforms produce.
+//
+// Results are printed as a table, or with -json as a JSON document that can
+// be saved and compared between builds.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassBench.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace passbench;
+
+static cl::list<unsigned>
+Sizes("sizes", cl::CommaSeparated,
+      cl::desc("Size of the IR built by each benchmark (default "
+               "256,4096,65536)"));
+
+static cl::opt<unsigned>
+MinOps("min-ops", cl::init(1 << 22),
+       cl::desc("Minimum number of operations timed per measurement"));
+
+static cl::opt<std::string>
+Filter("filter", cl::init(""),
+       cl::desc("Only run the benchmark groups whose name contains this "
+                "string"));
+
+static cl::opt<bool>
+JSON("json", cl::desc("Print the results as JSON"));
+
+volatile uintptr_t passbench::Sink;
+
+void Runner::printText(raw_ostream &OS) const {
+  OS << "group              pattern                size        ns/op\n";
+  for (unsigned i = 0, e = Results.size(); i != e; ++i) {
+    const Result &R = Results[i];
+    OS << format("%-18s %-18s %8u %12.2f\n", R.Group.c_str(),
+                 R.Pattern.c_str(), R.Size, R.NsPerOp);
+  }
+}
+
+void Runner::printJSON(raw_ostream &OS) const {
+  // Group and pattern names are plain identifiers, so nothing needs to be
+  // escaped.
+  OS << "{\n  \"benchmarks\": [";
+  for (unsigned i = 0, e = Results.size(); i != e; ++i) {
+    const Result &R = Results[i];
+    OS << (i ? ",\n" : "\n") << "    { \"group\": \"" << R.Group
+       << "\", \"pattern\": \"" << R.Pattern << "\", \"size\": " << R.Size
+       << format(", \"ns_per_op\": %.3f }", R.NsPerOp);
+  }
+  OS << "\n  ]\n}\n";
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "Analysis and transform "
+                              "benchmarks\n");
+
+  std::vector<unsigned> N(Sizes.begin(), Sizes.end());
+  if (N.empty()) {
+    static const unsigned DefaultSizes[] = { 256, 4096, 65536 };
+    N.assign(DefaultSizes, DefaultSizes + array_lengthof(DefaultSizes));
+  }
+
+  Runner R(MinOps, Filter);
+  for (unsigned i = 0, e = N.size(); i != e; ++i) {
+    runAnalysisBenchmarks(R, N[i]);
+    runPromoteBenchmarks(R, N[i]);
+    runVectorizeBenchmarks(R, N[i]);
+  }
+
+  if (JSON)
+    R.printJSON(outs());
+  else
+    R.printText(outs());
+  return 0;
+}
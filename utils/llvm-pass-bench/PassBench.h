@@ -0,0 +1,101 @@
+//===- PassBench.h - Pass benchmark harness ---------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the harness shared by the llvm-pass-bench benchmarks:
+// the runner that times a benchmark body and collects the results.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_PASS_BENCH_PASSBENCH_H
+#define LLVM_PASS_BENCH_PASSBENCH_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/Timer.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+class raw_ostream;
+
+namespace passbench {
+
+/// Result - One measurement of one benchmark.
+struct Result {
+  std::string Group;
+  std::string Pattern;
+  unsigned Size;
+  double NsPerOp;
+};
+
+/// Runner - Times benchmark bodies and collects the results.
+class Runner {
+  unsigned MinOps;
+  std::string Filter;
+  std::vector<Result> Results;
+
+public:
+  Runner(unsigned MinOps, StringRef Filter)
+    : MinOps(MinOps), Filter(Filter) {}
+
+  /// isEnabled - Return true if the benchmarks of Group were selected on the
+  /// command line.
+  bool isEnabled(StringRef Group) const {
+    return Filter.empty() || Group.find(Filter) != StringRef::npos;
+  }
+
+  /// run - Run Body, which performs OpsPerRun operations, enough times to
+  /// perform at least MinOps operations, and record the time per operation.
+  template <typename BodyT>
+  void run(StringRef Group, StringRef Pattern, unsigned Size,
+           unsigned OpsPerRun, BodyT Body) {
+    if (!isEnabled(Group))
+      return;
+    if (OpsPerRun == 0)
+      OpsPerRun = 1;
+    unsigned Runs = MinOps / OpsPerRun;
+    if (Runs == 0)
+      Runs = 1;
+
+    // Warm up the caches once before measuring.
+    Body();
+
+    double Start = TimeRecord::getCurrentTime(true).getWallTime();
+    for (unsigned R = 0; R != Runs; ++R)
+      Body();
+    double End = TimeRecord::getCurrentTime(false).getWallTime();
+
+    Result R;
+    R.Group = Group;
+    R.Pattern = Pattern;
+    R.Size = Size;
+    R.NsPerOp = (End - Start) * 1e9 / (double(Runs) * OpsPerRun);
+    Results.push_back(R);
+  }
+
+  /// printText - Print one line per result in a human readable table.
+  void printText(raw_ostream &OS) const;
+
+  /// printJSON - Print the results as a JSON document, for comparing runs of
+  /// different builds.
+  void printJSON(raw_ostream &OS) const;
+};
+
+/// Sink - Stores to this keep the optimizer from deleting benchmark loops.
+extern volatile uintptr_t Sink;
+
+// The benchmark groups.
+void runAnalysisBenchmarks(Runner &R, unsigned N);
+void runPromoteBenchmarks(Runner &R, unsigned N);
+void runVectorizeBenchmarks(Runner &R, unsigned N);
+
+} // end namespace passbench
+} // end namespace llvm
+
+#endif
@@ -0,0 +1,133 @@
+//===- PromoteBenchmarks.cpp - mem2reg scaling benchmarks -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file measures how PromoteMemToReg scales with the size of a function,
+// in time per promoted alloca or per loop.  Each run builds the function,
+// computes its dominator tree and promotes all of its allocas, so the time of
+// building the IR is included; it grows linearly, and the totals are what
+// matter for the generated code that motivated the measurements.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassBench.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Transforms/Utils/PromoteMemToReg.h"
+
+using namespace llvm;
+using namespace passbench;
+
+namespace {
+
+/// The number of cases of the state machine's switch.
+const unsigned NumStates = 64;
+
+/// buildStateMachine - Build a loop around a switch on a volatile load, whose
+/// cases each update every NumStates'th of N scalars held in allocas.  Every
+/// scalar needs a phi node in the loop header and in the latch.
+Function *buildStateMachine(Module &M, unsigned N) {
+  LLVMContext &C = M.getContext();
+  Type *I32 = Type::getInt32Ty(C);
+  Function *F = Function::Create(
+      FunctionType::get(I32, I32->getPointerTo(), false),
+      GlobalValue::ExternalLinkage, "", &M);
+  Value *P = F->arg_begin();
+
+  BasicBlock *Entry = BasicBlock::Create(C, "", F);
+  BasicBlock *Loop = BasicBlock::Create(C, "", F);
+  BasicBlock *Latch = BasicBlock::Create(C, "", F);
+  BasicBlock *Exit = BasicBlock::Create(C, "", F);
+  IRBuilder<> B(Entry);
+  std::vector<Value *> Vars(N);
+  for (unsigned i = 0; i != N; ++i) {
+    Vars[i] = B.CreateAlloca(I32);
+    B.CreateStore(B.getInt32(0), Vars[i]);
+  }
+  B.CreateBr(Loop);
+
+  B.SetInsertPoint(Loop);
+  SwitchInst *SI = B.CreateSwitch(B.CreateLoad(P, true), Exit, NumStates);
+  for (unsigned s = 0; s != NumStates; ++s) {
+    BasicBlock *Case = BasicBlock::Create(C, "", F, Latch);
+    SI->addCase(B.getInt32(s), Case);
+    B.SetInsertPoint(Case);
+    for (unsigned i = s; i < N; i += NumStates)
+      B.CreateStore(B.CreateAdd(B.CreateLoad(Vars[i]), B.getInt32(1)),
+                    Vars[i]);
+    B.CreateBr(Latch);
+  }
+
+  B.SetInsertPoint(Latch);
+  B.CreateBr(Loop);
+
+  B.SetInsertPoint(Exit);
+  Value *Sum = B.getInt32(0);
+  for (unsigned i = 0; i != N; ++i)
+    Sum = B.CreateAdd(Sum, B.CreateLoad(Vars[i]));
+  B.CreateRet(Sum);
+  return F;
+}
+
+/// buildNestedLoops - Build N nested repeat-until loops that each exit on a
+/// volatile load, around an update of one alloca.  The dominance frontiers of
+/// the latches together hold N * N / 2 blocks.
+Function *buildNestedLoops(Module &M, unsigned N) {
+  LLVMContext &C = M.getContext();
+  Type *I32 = Type::getInt32Ty(C);
+  Function *F = Function::Create(
+      FunctionType::get(I32, Type::getInt1PtrTy(C), false),
+      GlobalValue::ExternalLinkage, "", &M);
+  Value *P = F->arg_begin();
+
+  IRBuilder<> B(BasicBlock::Create(C, "", F));
+  Value *Var = B.CreateAlloca(I32);
+  B.CreateStore(B.getInt32(0), Var);
+  std::vector<BasicBlock *> Headers(N);
+  for (unsigned i = 0; i != N; ++i) {
+    Headers[i] = BasicBlock::Create(C, "", F);
+    B.CreateBr(Headers[i]);
+    B.SetInsertPoint(Headers[i]);
+  }
+  B.CreateStore(B.CreateAdd(B.CreateLoad(Var), B.getInt32(1)), Var);
+  for (unsigned i = N; i != 0; --i) {
+    BasicBlock *Next = BasicBlock::Create(C, "", F);
+    B.CreateCondBr(B.CreateLoad(P, true), Headers[i - 1], Next);
+    B.SetInsertPoint(Next);
+  }
+  B.CreateRet(B.CreateLoad(Var));
+  return F;
+}
+
+void runPromote(Runner &R, unsigned N, StringRef Pattern,
+                Function *(*Build)(Module &, unsigned), unsigned OpsPerRun) {
+  StringRef Group = "Mem2Reg";
+  if (!R.isEnabled(Group))
+    return;
+
+  R.run(Group, Pattern, N, OpsPerRun, [&] {
+    LLVMContext C;
+    Module M("bench", C);
+    Function *F = Build(M, N);
+
+    DominatorTree DT;
+    DT.recalculate(*F);
+    std::vector<AllocaInst *> Allocas;
+    for (BasicBlock::iterator I = F->begin()->begin(), E = F->begin()->end();
+         I != E; ++I)
+      if (AllocaInst *AI = dyn_cast<AllocaInst>(I))
+        Allocas.push_back(AI);
+    PromoteMemToReg(Allocas, DT);
+    Sink = F->size();
+  });
+}
+
+} // end anonymous namespace
+
+void passbench::runPromoteBenchmarks(Runner &R, unsigned N) {
+  runPromote(R, N, "state-machine", buildStateMachine, N);
+  runPromote(R, N, "nested-loops", buildNestedLoops, N);
+}
@@ -0,0 +1,317 @@
+//===- VectorizeBenchmarks.cpp - Vectorized code benchmarks ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file measures the code the vectorizers produce.  Each loop is built in
+// IR, vectorized for the host, compiled with MCJIT, and timed per element.
+//
+// SLPReduction compares reductions vectorized with and without
+// -slp-vectorize-hor.  LVInterleave compares loops with strided accesses
+// left scalar, vectorized by the loop vectorizer as it is by default, and
+// vectorized with -enable-interleaved-mem-accesses.  Run with -vectorize-cpu
+// where the host CPU isn't recognized.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassBench.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Vectorize.h"
+
+using namespace llvm;
+using namespace passbench;
+
+static cl::opt<std::string>
+VectorizeCPU("vectorize-cpu", cl::init(""),
+             cl::desc("CPU to vectorize and compile the loops for "
+                      "(default: the host CPU)"));
+
+namespace {
+
+/// The number of elements each loop iteration reduces.
+const unsigned Width = 8;
+
+enum ReductionKind { RK_Add, RK_Xor, RK_SMax, RK_FAdd };
+
+/// reduce - Combine LHS and RHS with the operation of Kind.
+Value *reduce(IRBuilder<> &B, ReductionKind Kind, Value *LHS, Value *RHS) {
+  switch (Kind) {
+  case RK_Add:
+    return B.CreateAdd(LHS, RHS);
+  case RK_Xor:
+    return B.CreateXor(LHS, RHS);
+  case RK_SMax:
+    return B.CreateSelect(B.CreateICmpSGT(LHS, RHS), LHS, RHS);
+  case RK_FAdd:
+    return B.CreateFAdd(LHS, RHS);
+  }
+  llvm_unreachable("Unknown reduction kind");
+}
+
+/// buildReduction - Build "T rdx(T *P, i64 N)", which reduces the N elements
+/// of P, N a multiple of Width, Width elements per iteration.  Each iteration
+/// combines its loads in a chain and folds the result into the accumulator
+/// phi: the shape a horizontal reduction is matched from.
+Function *buildReduction(Module &M, ReductionKind Kind) {
+  LLVMContext &C = M.getContext();
+  Type *I64 = Type::getInt64Ty(C);
+  Type *T = Kind == RK_FAdd ? Type::getFloatTy(C) : Type::getInt32Ty(C);
+  Type *Params[] = { T->getPointerTo(), I64 };
+  Function *F = Function::Create(FunctionType::get(T, Params, false),
+                                 GlobalValue::ExternalLinkage, "rdx", &M);
+  Function::arg_iterator AI = F->arg_begin();
+  Value *P = AI++;
+  Value *N = AI;
+
+  BasicBlock *Entry = BasicBlock::Create(C, "entry", F);
+  BasicBlock *Loop = BasicBlock::Create(C, "loop", F);
+  BasicBlock *Exit = BasicBlock::Create(C, "exit", F);
+  IRBuilder<> B(Entry);
+  // The fast-math flags allow the fadd chain to be reassociated.
+  FastMathFlags FMF;
+  FMF.setUnsafeAlgebra();
+  B.SetFastMathFlags(FMF);
+  B.CreateBr(Loop);
+
+  B.SetInsertPoint(Loop);
+  PHINode *I = B.CreatePHI(I64, 2);
+  PHINode *Acc = B.CreatePHI(T, 2);
+  Value *Chain = nullptr;
+  for (unsigned k = 0; k != Width; ++k) {
+    Value *Elt = B.CreateLoad(B.CreateGEP(P, B.CreateAdd(I, B.getInt64(k))));
+    Chain = Chain ? reduce(B, Kind, Chain, Elt) : Elt;
+  }
+  Value *NextAcc = reduce(B, Kind, Chain, Acc);
+  Value *NextI = B.CreateAdd(I, B.getInt64(Width));
+  B.CreateCondBr(B.CreateICmpULT(NextI, N), Loop, Exit);
+  I->addIncoming(B.getInt64(0), Entry);
+  I->addIncoming(NextI, Loop);
+  Acc->addIncoming(Constant::getNullValue(T), Entry);
+  Acc->addIncoming(NextAcc, Loop);
+
+  B.SetInsertPoint(Exit);
+  B.CreateRet(NextAcc);
+  return F;
+}
+
+/// getBoolOption - Return the boolean option Name of a vectorizer, which the
+/// vectorizer reads each time it runs.
+cl::opt<bool> &getBoolOption(StringRef Name) {
+  StringMap<cl::Option *> Options;
+  cl::getRegisteredOptions(Options);
+  StringMap<cl::Option *>::iterator I = Options.find(Name);
+  if (I == Options.end())
+    report_fatal_error("-" + Name + " is not registered");
+  return *static_cast<cl::opt<bool> *>(I->second);
+}
+
+/// compile - Run P, if any, on M for the benchmark CPU and compile M with
+/// MCJIT.  The engine takes ownership of M.
+ExecutionEngine *compile(Module *M, Pass *P) {
+  M->setTargetTriple(sys::getProcessTriple());
+  std::string Error;
+  EngineBuilder EB(M);
+  EB.setEngineKind(EngineKind::JIT)
+    .setUseMCJIT(true)
+    .setErrorStr(&Error)
+    .setMCPU(VectorizeCPU.empty() ? sys::getHostCPUName()
+                                  : StringRef(VectorizeCPU));
+  std::unique_ptr<TargetMachine> TM(EB.selectTarget());
+  if (!TM)
+    report_fatal_error("Could not select a target: " + Error);
+  M->setDataLayout(TM->getDataLayout());
+
+  if (P) {
+    PassManager PM;
+    TM->addAnalysisPasses(PM);
+    PM.add(new DataLayoutPass(M));
+    PM.add(P);
+    PM.run(*M);
+  }
+
+  ExecutionEngine *EE = EB.create();
+  if (!EE)
+    report_fatal_error("Could not create the JIT: " + Error);
+  return EE;
+}
+
+void runSLPReduction(Runner &R, unsigned N, ReductionKind Kind,
+                     StringRef Name) {
+  StringRef Group = "SLPReduction";
+  if (!R.isEnabled(Group))
+    return;
+
+  unsigned NumElts = (N + Width - 1) / Width * Width;
+  std::vector<int32_t> Ints(NumElts);
+  std::vector<float> Floats(NumElts);
+  for (unsigned i = 0; i != NumElts; ++i) {
+    Ints[i] = int32_t(i * 2654435761U);
+    Floats[i] = float(i % 1024);
+  }
+
+  cl::opt<bool> &VectorizeHor = getBoolOption("slp-vectorize-hor");
+  bool SavedVectorizeHor = VectorizeHor;
+  int32_t ScalarResult = 0;
+  for (unsigned Hor = 0; Hor != 2; ++Hor) {
+    LLVMContext C;
+    Module *M = new Module("bench", C);
+    buildReduction(*M, Kind);
+
+    VectorizeHor.setValue(Hor);
+    std::unique_ptr<ExecutionEngine> EE(compile(M, createSLPVectorizerPass()));
+    uint64_t Addr = EE->getFunctionAddress("rdx");
+
+    std::string Pattern = (Name + (Hor ? "-hor" : "-scalar")).str();
+    if (Kind == RK_FAdd) {
+      typedef float (*FnTy)(float *, uint64_t);
+      FnTy Fn = reinterpret_cast<FnTy>(static_cast<uintptr_t>(Addr));
+      R.run(Group, Pattern, N, NumElts, [&] {
+        Sink = uintptr_t(Fn(Floats.data(), NumElts));
+      });
+    } else {
+      typedef int32_t (*FnTy)(int32_t *, uint64_t);
+      FnTy Fn = reinterpret_cast<FnTy>(static_cast<uintptr_t>(Addr));
+      R.run(Group, Pattern, N, NumElts, [&] {
+        Sink = uintptr_t(Fn(Ints.data(), NumElts));
+      });
+      // Integer reductions can be reassociated exactly, so the vectorized
+      // code must compute the same value as the scalar code.
+      int32_t Result = Fn(Ints.data(), NumElts);
+      if (!Hor)
+        ScalarResult = Result;
+      else if (Result != ScalarResult)
+        report_fatal_error("Vectorized " + Name + " reduction computed a "
+                           "different value");
+    }
+  }
+  VectorizeHor.setValue(SavedVectorizeHor);
+}
+
+/// buildInterleaved - Build "void ilv(i32 *Dst, i32 *Src, i64 N)" with
+/// accesses of stride Factor.  With Load, it sums each group of Factor
+/// elements of Src into Dst[i]; otherwise it spreads Src[i] + k over the
+/// group Dst[Factor * i + k].  N must be at least one.
+Function *buildInterleaved(Module &M, unsigned Factor, bool Load) {
+  LLVMContext &C = M.getContext();
+  Type *I32 = Type::getInt32Ty(C);
+  Type *I64 = Type::getInt64Ty(C);
+  Type *Params[] = { I32->getPointerTo(), I32->getPointerTo(), I64 };
+  Function *F = Function::Create(FunctionType::get(Type::getVoidTy(C), Params,
+                                                   false),
+                                 GlobalValue::ExternalLinkage, "ilv", &M);
+  // The arrays don't overlap, so the vectorizer needs no runtime checks, and
+  // the addresses are inbounds, so it can tell the strides don't wrap.
+  F->setDoesNotAlias(1);
+  F->setDoesNotAlias(2);
+  Function::arg_iterator AI = F->arg_begin();
+  Value *Dst = AI++;
+  Value *Src = AI++;
+  Value *N = AI;
+
+  BasicBlock *Entry = BasicBlock::Create(C, "entry", F);
+  BasicBlock *Loop = BasicBlock::Create(C, "loop", F);
+  BasicBlock *Exit = BasicBlock::Create(C, "exit", F);
+  IRBuilder<> B(Entry);
+  B.CreateBr(Loop);
+
+  B.SetInsertPoint(Loop);
+  PHINode *I = B.CreatePHI(I64, 2);
+  Value *Base = B.CreateMul(I, B.getInt64(Factor));
+  if (Load) {
+    Value *Sum = nullptr;
+    for (unsigned k = 0; k != Factor; ++k) {
+      Value *Idx = B.CreateAdd(Base, B.getInt64(k));
+      Value *Elt = B.CreateLoad(B.CreateInBoundsGEP(Src, Idx));
+      Sum = Sum ? B.CreateAdd(Sum, Elt) : Elt;
+    }
+    B.CreateStore(Sum, B.CreateInBoundsGEP(Dst, I));
+  } else {
+    Value *Elt = B.CreateLoad(B.CreateInBoundsGEP(Src, I));
+    for (unsigned k = 0; k != Factor; ++k) {
+      Value *Idx = B.CreateAdd(Base, B.getInt64(k));
+      B.CreateStore(B.CreateAdd(Elt, B.getInt32(k)),
+                    B.CreateInBoundsGEP(Dst, Idx));
+    }
+  }
+  Value *NextI = B.CreateAdd(I, B.getInt64(1));
+  B.CreateCondBr(B.CreateICmpULT(NextI, N), Loop, Exit);
+  I->addIncoming(B.getInt64(0), Entry);
+  I->addIncoming(NextI, Loop);
+
+  B.SetInsertPoint(Exit);
+  B.CreateRetVoid();
+  return F;
+}
+
+void runLVInterleave(Runner &R, unsigned N, unsigned Factor, bool Load) {
+  StringRef Group = "LVInterleave";
+  if (!R.isEnabled(Group))
+    return;
+
+  std::vector<int32_t> Src(Load ? N * Factor : N);
+  for (unsigned i = 0, e = Src.size(); i != e; ++i)
+    Src[i] = int32_t(i * 2654435761U);
+  std::vector<int32_t> Dst(Load ? N : N * Factor), ScalarDst;
+
+  cl::opt<bool> &Interleave = getBoolOption("enable-interleaved-mem-accesses");
+  bool SavedInterleave = Interleave;
+  static const char *const Modes[] = { "scalar", "vector", "interleaved" };
+  for (unsigned Mode = 0; Mode != 3; ++Mode) {
+    LLVMContext C;
+    Module *M = new Module("bench", C);
+    buildInterleaved(*M, Factor, Load);
+
+    Interleave.setValue(Mode == 2);
+    std::unique_ptr<ExecutionEngine> EE(
+        compile(M, Mode ? createLoopVectorizePass() : nullptr));
+    typedef void (*FnTy)(int32_t *, int32_t *, uint64_t);
+    FnTy Fn = reinterpret_cast<FnTy>(
+        static_cast<uintptr_t>(EE->getFunctionAddress("ilv")));
+
+    std::string Pattern =
+        (Twine(Load ? "load" : "store") + Twine(Factor) + "-" + Modes[Mode])
+            .str();
+    R.run(Group, Pattern, N, N, [&] {
+      Fn(Dst.data(), Src.data(), N);
+      Sink = uintptr_t(Dst[N / 2]);
+    });
+    if (!Mode)
+      ScalarDst = Dst;
+    else if (Dst != ScalarDst)
+      report_fatal_error("Vectorized " + Pattern + " loop computed different "
+                         "values");
+  }
+  Interleave.setValue(SavedInterleave);
+}
+
+} // end anonymous namespace
+
+void passbench::runVectorizeBenchmarks(Runner &R, unsigned N) {
+  InitializeNativeTarget();
+  InitializeNativeTargetAsmPrinter();
+  runSLPReduction(R, N, RK_Add, "add");
+  runSLPReduction(R, N, RK_Xor, "xor");
+  runSLPReduction(R, N, RK_SMax, "smax");
+  runSLPReduction(R, N, RK_FAdd, "fadd");
+  for (unsigned Factor = 2; Factor <= 4; ++Factor) {
+    runLVInterleave(R, N, Factor, /*Load=*/true);
+    runLVInterleave(R, N, Factor, /*Load=*/false);
+  }
+}